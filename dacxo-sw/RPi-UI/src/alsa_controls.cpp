@@ -0,0 +1,159 @@
+#include "alsa_controls.h"
+#include "log.h"
+
+#include <poll.h>
+#include <sys/epoll.h>
+
+namespace dacxo {
+
+static const char *const VOLUME_NAME = "Master";
+static const char *const INPUT_NAME = "Input Source";
+static const uint32_t RETRY_MS = 2000;
+
+AlsaControls::AlsaControls(EventLoop &loop) : loop_(loop), retry_timer_(loop, [this]() { connect_(); }) {}
+
+AlsaControls::~AlsaControls() { disconnect_(); }
+
+void AlsaControls::open(const char *card, VolumeCallback &&on_volume, InputCallback &&on_input) {
+  card_ = card;
+  on_volume_ = std::move(on_volume);
+  on_input_ = std::move(on_input);
+  connect_();
+}
+
+// Resolve a mixer control by name. @return its numid, or 0 if absent.
+static unsigned int find_control(snd_ctl_t *ctl, const char *name, snd_ctl_elem_info_t *info) {
+  snd_ctl_elem_info_set_interface(info, SND_CTL_ELEM_IFACE_MIXER);
+  snd_ctl_elem_info_set_name(info, name);
+  if (snd_ctl_elem_info(ctl, info) < 0)
+    return 0;
+  return snd_ctl_elem_info_get_numid(info);
+}
+
+void AlsaControls::connect_() {
+  int err = snd_ctl_open(&ctl_, card_.c_str(), SND_CTL_NONBLOCK);
+  if (err < 0) {
+    log_debug("control %s: %s, retry in %u s", card_.c_str(), snd_strerror(err), RETRY_MS / 1000);
+    ctl_ = nullptr;
+    retry_timer_.start_ms(RETRY_MS);
+    return;
+  }
+
+  snd_ctl_elem_info_t *info;
+  snd_ctl_elem_info_alloca(&info);
+  volume_numid_ = find_control(ctl_, VOLUME_NAME, info);
+  if (volume_numid_) {
+    volume_min_ = snd_ctl_elem_info_get_min(info);
+    volume_max_ = snd_ctl_elem_info_get_max(info);
+  }
+  input_numid_ = find_control(ctl_, INPUT_NAME, info);
+  input_names_.clear();
+  if (input_numid_) {
+    const unsigned int items = snd_ctl_elem_info_get_items(info);
+    for (unsigned int i = 0; i < items; i++) {
+      snd_ctl_elem_info_set_item(info, i);
+      snd_ctl_elem_info(ctl_, info);
+      input_names_.emplace_back(snd_ctl_elem_info_get_item_name(info));
+    }
+  }
+  if (!volume_numid_ || !input_numid_)
+    log_error("control %s: no '%s' or '%s' control, is this the dacxo card?", card_.c_str(), VOLUME_NAME, INPUT_NAME);
+
+  err = snd_ctl_subscribe_events(ctl_, 1);
+  const int count = snd_ctl_poll_descriptors_count(ctl_);
+  std::vector<struct pollfd> pfds(count > 0 ? count : 0);
+  if (err >= 0 && count > 0)
+    err = snd_ctl_poll_descriptors(ctl_, pfds.data(), count);
+  if (err < 0 || count <= 0) {
+    log_error("control %s events: %s", card_.c_str(), snd_strerror(err));
+    disconnect_();
+    retry_timer_.start_ms(RETRY_MS);
+    return;
+  }
+  for (const struct pollfd &pfd : pfds) {
+    fds_.push_back(pfd.fd);
+    loop_.add(pfd.fd, EPOLLIN, [this](uint32_t) { read_events_(); });
+  }
+
+  log_info("control %s: volume %d..%d, %zu inputs", card_.c_str(), volume_min_, volume_max_, input_names_.size());
+  read_volume_();
+  read_input_();
+}
+
+void AlsaControls::disconnect_() {
+  for (int fd : fds_)
+    loop_.remove(fd);
+  fds_.clear();
+  if (ctl_)
+    snd_ctl_close(ctl_);
+  ctl_ = nullptr;
+  volume_numid_ = input_numid_ = 0;
+}
+
+void AlsaControls::read_events_() {
+  snd_ctl_event_t *event;
+  snd_ctl_event_alloca(&event);
+  int err;
+  while ((err = snd_ctl_read(ctl_, event)) > 0) {
+    if (snd_ctl_event_get_type(event) != SND_CTL_EVENT_ELEM)
+      continue;
+    const unsigned int mask = snd_ctl_event_elem_get_mask(event);
+    if (mask == SND_CTL_EVENT_MASK_REMOVE) {
+      err = -ENODEV;  // the card is going away
+      break;
+    }
+    if (!(mask & SND_CTL_EVENT_MASK_VALUE))
+      continue;
+    const unsigned int numid = snd_ctl_event_elem_get_numid(event);
+    if (numid == volume_numid_)
+      read_volume_();
+    else if (numid == input_numid_)
+      read_input_();
+  }
+  if (err < 0 && err != -EAGAIN) {
+    log_info("control %s: %s, waiting for the card", card_.c_str(), snd_strerror(err));
+    disconnect_();
+    retry_timer_.start_ms(RETRY_MS);
+  }
+}
+
+void AlsaControls::read_volume_() {
+  if (!volume_numid_)
+    return;
+  snd_ctl_elem_value_t *value;
+  snd_ctl_elem_value_alloca(&value);
+  snd_ctl_elem_value_set_numid(value, volume_numid_);
+  if (snd_ctl_elem_read(ctl_, value) < 0)
+    return;
+  on_volume_(snd_ctl_elem_value_get_integer(value, 0));  // the knob drives both channels alike
+}
+
+void AlsaControls::read_input_() {
+  if (!input_numid_)
+    return;
+  snd_ctl_elem_value_t *value;
+  snd_ctl_elem_value_alloca(&value);
+  snd_ctl_elem_value_set_numid(value, input_numid_);
+  if (snd_ctl_elem_read(ctl_, value) < 0)
+    return;
+  const unsigned int index = snd_ctl_elem_value_get_enumerated(value, 0);
+  on_input_(index, index < input_names_.size() ? input_names_[index] : std::string("?"));
+}
+
+bool AlsaControls::set_volume(int volume) {
+  if (!volume_numid_)
+    return false;
+  snd_ctl_elem_value_t *value;
+  snd_ctl_elem_value_alloca(&value);
+  snd_ctl_elem_value_set_numid(value, volume_numid_);
+  snd_ctl_elem_value_set_integer(value, 0, volume);
+  snd_ctl_elem_value_set_integer(value, 1, volume);
+  int err = snd_ctl_elem_write(ctl_, value);
+  if (err < 0) {
+    log_error("write %s: %s", VOLUME_NAME, snd_strerror(err));
+    return false;
+  }
+  return true;
+}
+
+}  // namespace dacxo
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "event_loop.h"
+
+#include <alsa/asoundlib.h>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace dacxo {
+
+/**
+ * The kernel controls of the dacxo card: the "Master" volume and the "Input Source" enum.
+ * Their changes by others (mixer apps, or the UI controller through the uinotify line)
+ * arrive as ALSA control events. Waits for the card when it is not (yet) probed.
+ */
+class AlsaControls {
+  public:
+    /// 'volume' in 1dB steps from volume_min() (max attenuation) up to volume_max()
+    using VolumeCallback = std::function<void(int volume)>;
+    using InputCallback = std::function<void(unsigned int index, const std::string &name)>;
+
+    explicit AlsaControls(EventLoop &loop);
+    ~AlsaControls();
+    AlsaControls(const AlsaControls &) = delete;
+    AlsaControls &operator=(const AlsaControls &) = delete;
+
+    /// Open the control device of 'card', such as "hw:DACXO", and report the current values.
+    void open(const char *card, VolumeCallback &&on_volume, InputCallback &&on_input);
+    bool is_open() const { return ctl_ != nullptr; }
+
+    int volume_min() const { return volume_min_; }
+    int volume_max() const { return volume_max_; }
+    /// Write both channels. @return false on error, or without card.
+    bool set_volume(int volume);
+
+  private:
+    void connect_();
+    void disconnect_();
+    void read_events_();
+    void read_volume_();
+    void read_input_();
+
+    EventLoop &loop_;
+    Timer retry_timer_;
+    std::string card_;
+    snd_ctl_t *ctl_{nullptr};
+    std::vector<int> fds_;
+    unsigned int volume_numid_{0};
+    unsigned int input_numid_{0};
+    int volume_min_{0};
+    int volume_max_{0};
+    std::vector<std::string> input_names_;
+    VolumeCallback on_volume_;
+    InputCallback on_input_;
+};
+
+}  // namespace dacxo
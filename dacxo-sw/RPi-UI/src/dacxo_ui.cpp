@@ -0,0 +1,243 @@
+#include "dacxo_ui.h"
+#include "log.h"
+
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <unistd.h>
+
+namespace dacxo {
+
+static const uint32_t LONG_PRESS_MS = 1000;
+
+void LatencyStats::add(uint64_t ns) {
+  count_++;
+  sum_ns_ += ns;
+  if (ns < min_ns_)
+    min_ns_ = ns;
+  if (ns > max_ns_)
+    max_ns_ = ns;
+  unsigned int bucket = 0;
+  for (uint64_t us = ns / 1000; us > 1 && bucket < BUCKETS - 1; us >>= 1)
+    bucket++;
+  buckets_[bucket]++;
+}
+
+void LatencyStats::print(const char *name) const {
+  if (count_ == 0) {
+    log_info("%s latency: no samples", name);
+    return;
+  }
+  log_info("%s latency: %llu samples, min %.3f avg %.3f max %.3f ms", name, (unsigned long long) count_,
+           min_ns_ / 1e6, (double) sum_ns_ / count_ / 1e6, max_ns_ / 1e6);
+  for (unsigned int i = 0; i < BUCKETS; i++) {
+    if (buckets_[i])
+      log_info("  < %6llu us: %llu", 2ULL << i, (unsigned long long) buckets_[i]);
+  }
+}
+
+DacXo::DacXo(EventLoop &loop, const Options &options)
+    : loop_(loop),
+      options_(options),
+      controls_(loop),
+      knob_(loop),
+      lirc_(loop),
+      press_timer_(loop, [this]() { power_down_(); }),
+      holdoff_timer_(loop, [this]() { write_volume_(); }),
+      start_ns_(monotonic_ns()) {}
+
+DacXo::~DacXo() {
+  if (signal_fd_ >= 0) {
+    loop_.remove(signal_fd_);
+    close(signal_fd_);
+  }
+}
+
+bool DacXo::start() {
+  sigset_t signals;
+  sigemptyset(&signals);
+  sigaddset(&signals, SIGINT);
+  sigaddset(&signals, SIGTERM);
+  sigaddset(&signals, SIGUSR1);
+  sigprocmask(SIG_BLOCK, &signals, nullptr);
+  signal_fd_ = signalfd(-1, &signals, SFD_NONBLOCK | SFD_CLOEXEC);
+  if (signal_fd_ < 0 || !loop_.add(signal_fd_, EPOLLIN, [this](uint32_t) { on_signal_(); })) {
+    log_error("signalfd: %s", strerror(errno));
+    return false;
+  }
+
+  if (options_.display_bus >= 0)
+    oled_.open(options_.display_bus);
+
+  const bool knob = knob_.open(
+      options_.gpiochip.c_str(), options_.knob_pins[0], options_.knob_pins[1], options_.knob_pins[2],
+      [this](int steps, uint64_t ts_ns) { on_turn_(steps, ts_ns); },
+      [this](bool pressed, uint64_t ts_ns) { on_switch_(pressed, ts_ns); });
+  if (!options_.lirc_socket.empty()) {
+    lirc_.open(options_.lirc_socket.c_str(),
+               [this](LircInput::Key key, unsigned int repeat, uint64_t ts_ns) { on_ir_key_(key, repeat, ts_ns); });
+  } else if (!knob) {
+    return false;
+  }
+
+  controls_.open(
+      options_.card.c_str(), [this](int volume) { on_volume_(volume); },
+      [this](unsigned int index, const std::string &name) { on_input_(index, name); });
+  power_up_();
+  return true;
+}
+
+void DacXo::on_turn_(int steps, uint64_t ts_ns) {
+  turn_events_++;
+  if (!power_)
+    return;
+  press_timer_.cancel();
+  step_volume_(steps, ts_ns);
+}
+
+void DacXo::on_switch_(bool pressed, uint64_t ts_ns) {
+  (void) ts_ns;
+  switch_events_++;
+  if (!pressed) {
+    press_timer_.cancel();
+    if (power_)
+      oled_.show_string(1, 10, "0");
+    return;
+  }
+  if (!power_) {
+    power_up_();
+    return;
+  }
+  oled_.show_string(1, 10, "1");
+  press_timer_.start_ms(LONG_PRESS_MS);
+}
+
+void DacXo::on_ir_key_(LircInput::Key key, unsigned int repeat, uint64_t ts_ns) {
+  ir_events_++;
+  switch (key) {
+    case LircInput::KEY_VOLUME_UP:
+      if (power_)
+        step_volume_(+1, ts_ns);
+      break;
+    case LircInput::KEY_VOLUME_DOWN:
+      if (power_)
+        step_volume_(-1, ts_ns);
+      break;
+    case LircInput::KEY_POWER:
+      if (repeat > 0)  // a toggle per press, not per repeated code
+        break;
+      if (power_)
+        power_down_();
+      else
+        power_up_();
+      break;
+  }
+}
+
+// A change by the card: the echo of an own write, or a change by a mixer app or the UI controller
+void DacXo::on_volume_(int volume) {
+  control_events_++;
+  written_volume_ = volume;
+  if (pending_ns_)  // an own change to write still, which wins
+    return;
+  if (volume != volume_) {
+    volume_ = volume;
+    show_volume_();
+  }
+}
+
+void DacXo::on_input_(unsigned int index, const std::string &name) {
+  control_events_++;
+  log_debug("input %u: %s", index, name.c_str());
+  input_name_ = name.substr(0, 16);
+  if (power_)
+    oled_.show_string(0, 0, input_name_ + std::string(16 - input_name_.size(), ' '));
+}
+
+void DacXo::step_volume_(int steps, uint64_t ts_ns) {
+  if (!controls_.is_open())
+    return;
+  int volume = volume_ + steps;
+  if (volume < controls_.volume_min())
+    volume = controls_.volume_min();
+  if (volume > controls_.volume_max())
+    volume = controls_.volume_max();
+  if (volume == volume_)
+    return;
+  volume_ = volume;
+  show_volume_();
+
+  if (pending_ns_)
+    coalesced_++;
+  else
+    pending_ns_ = ts_ns;
+  if (!holdoff_timer_.is_active())
+    write_volume_();
+}
+
+void DacXo::write_volume_() {
+  if (!pending_ns_)
+    return;
+  if (volume_ != written_volume_ && controls_.set_volume(volume_)) {
+    written_volume_ = volume_;
+    writes_++;
+    // from the oldest edge in this write: the coalesced ones waited the longest
+    latency_.add(monotonic_ns() - pending_ns_);
+    holdoff_timer_.start_ms(options_.holdoff_ms);
+  }
+  pending_ns_ = 0;
+}
+
+void DacXo::power_up_() {
+  power_ = true;
+  oled_.clear();
+  oled_.show_string(0, 0, input_name_.empty() ? "Hello!" : input_name_);
+  show_volume_();
+}
+
+void DacXo::power_down_() {
+  power_ = false;
+  oled_.clear();
+  oled_.show_string(1, 15, ".");
+}
+
+void DacXo::show_volume_() {
+  if (!power_)
+    return;
+  char text[8];
+  snprintf(text, sizeof(text), "%02d", volume_);
+  oled_.show_string(1, 0, text);
+}
+
+void DacXo::on_signal_() {
+  struct signalfd_siginfo info;
+  while (read(signal_fd_, &info, sizeof(info)) == sizeof(info)) {
+    if (info.ssi_signo == SIGUSR1) {
+      print_stats();
+    } else {
+      log_info("signal %u, exiting", info.ssi_signo);
+      loop_.stop();
+    }
+  }
+}
+
+void DacXo::print_stats() const {
+  const double seconds = (monotonic_ns() - start_ns_) / 1e9;
+  long pages = 0, resident = 0;
+  FILE *statm = fopen("/proc/self/statm", "r");
+  if (statm) {
+    if (fscanf(statm, "%ld %ld", &pages, &resident) != 2)
+      resident = 0;
+    fclose(statm);
+  }
+  log_info("up %.0f s, %llu wake-ups (%.3f/s), resident %ld kB", seconds, (unsigned long long) loop_.wakeups(),
+           seconds > 0 ? loop_.wakeups() / seconds : 0.0, resident * (sysconf(_SC_PAGESIZE) / 1024));
+  log_info("events: %llu knob, %llu switch, %llu ir, %llu control; %llu writes, %llu coalesced",
+           (unsigned long long) turn_events_, (unsigned long long) switch_events_, (unsigned long long) ir_events_,
+           (unsigned long long) control_events_, (unsigned long long) writes_, (unsigned long long) coalesced_);
+  latency_.print("input to volume write");
+}
+
+}  // namespace dacxo
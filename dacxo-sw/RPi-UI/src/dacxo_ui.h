@@ -0,0 +1,96 @@
+#pragma once
+
+#include "alsa_controls.h"
+#include "event_loop.h"
+#include "gpio_knob.h"
+#include "lirc_input.h"
+#include "oled16x2.h"
+
+#include <cstdint>
+#include <string>
+
+namespace dacxo {
+
+struct Options {
+  std::string card{"hw:DACXO"};
+  std::string gpiochip{"/dev/gpiochip0"};
+  unsigned int knob_pins[3]{5, 6, 13};  // phase A, phase B, switch
+  std::string lirc_socket{"/var/run/lirc/lircd"};
+  int display_bus{-1};  // i2c bus of the OLED, -1 for none
+  uint32_t holdoff_ms{20};
+};
+
+/**
+ * Latency from an input edge to the completed control write, in a log2 histogram.
+ */
+class LatencyStats {
+  public:
+    void add(uint64_t ns);
+    void print(const char *name) const;
+
+  private:
+    static const unsigned int BUCKETS = 32;
+    uint64_t count_{0};
+    uint64_t sum_ns_{0};
+    uint64_t min_ns_{UINT64_MAX};
+    uint64_t max_ns_{0};
+    uint64_t buckets_[BUCKETS]{};  // bucket i: [2^i, 2^(i+1)) us
+};
+
+/**
+ * The UI of the dac: knob and remote set the volume and the power state, the display shows them.
+ *
+ * A volume change is written at once; the changes within the hold-off time after a write
+ * are coalesced into a single write of the latest volume when the hold-off ends.
+ * A fast turn of the knob so costs one control write per hold-off time, rather than one per step.
+ */
+class DacXo {
+  public:
+    DacXo(EventLoop &loop, const Options &options);
+    ~DacXo();
+
+    /// Open the inputs and outputs. @return false if none of the inputs is available.
+    bool start();
+    void print_stats() const;
+
+  private:
+    void on_turn_(int steps, uint64_t ts_ns);
+    void on_switch_(bool pressed, uint64_t ts_ns);
+    void on_ir_key_(LircInput::Key key, unsigned int repeat, uint64_t ts_ns);
+    void on_volume_(int volume);
+    void on_input_(unsigned int index, const std::string &name);
+    void on_signal_();
+
+    void step_volume_(int steps, uint64_t ts_ns);
+    void write_volume_();
+    void power_up_();
+    void power_down_();
+    void show_volume_();
+
+    EventLoop &loop_;
+    const Options options_;
+    AlsaControls controls_;
+    GpioKnob knob_;
+    LircInput lirc_;
+    Oled16x2 oled_;
+    Timer press_timer_;    // the long press for power down
+    Timer holdoff_timer_;  // the coalescing of volume writes
+    int signal_fd_{-1};
+    uint64_t start_ns_;
+
+    bool power_{false};
+    int volume_{0};          // the target
+    int written_volume_{0};  // the last written or reported by the card
+    uint64_t pending_ns_{0};  // the time of the oldest change not written yet, 0 if none
+    std::string input_name_;
+
+    uint64_t turn_events_{0};
+    uint64_t switch_events_{0};
+    uint64_t ir_events_{0};
+    uint64_t control_events_{0};
+    uint64_t writes_{0};
+    uint64_t coalesced_{0};
+    LatencyStats latency_;
+};
+
+}  // namespace dacxo
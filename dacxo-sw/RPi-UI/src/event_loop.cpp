@@ -0,0 +1,109 @@
+#include "event_loop.h"
+#include "log.h"
+
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+namespace dacxo {
+
+static const int MAX_EVENTS = 8;
+
+uint64_t monotonic_ns() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+EventLoop::EventLoop() : epoll_fd_(epoll_create1(EPOLL_CLOEXEC)) {
+  if (epoll_fd_ < 0)
+    log_error("epoll_create1: %s", strerror(errno));
+}
+
+EventLoop::~EventLoop() {
+  if (epoll_fd_ >= 0)
+    close(epoll_fd_);
+}
+
+bool EventLoop::add(int fd, uint32_t events, Handler &&handler) {
+  struct epoll_event ev {};
+  ev.events = events;
+  ev.data.fd = fd;
+  if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev) < 0) {
+    log_error("epoll_ctl add fd %d: %s", fd, strerror(errno));
+    return false;
+  }
+  handlers_[fd] = std::move(handler);
+  return true;
+}
+
+void EventLoop::remove(int fd) {
+  epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+  handlers_.erase(fd);
+}
+
+int EventLoop::run() {
+  struct epoll_event events[MAX_EVENTS];
+  running_ = true;
+  while (running_) {
+    int n = epoll_wait(epoll_fd_, events, MAX_EVENTS, -1);
+    if (n < 0) {
+      if (errno == EINTR)
+        continue;
+      log_error("epoll_wait: %s", strerror(errno));
+      return -1;
+    }
+    wakeups_++;
+    for (int i = 0; i < n; i++) {
+      auto it = handlers_.find(events[i].data.fd);
+      if (it == handlers_.end())
+        continue;  // removed by an earlier handler of this wake-up
+      Handler handler = it->second;  // a copy: the handler may remove itself
+      handler(events[i].events);
+    }
+  }
+  return 0;
+}
+
+Timer::Timer(EventLoop &loop, std::function<void()> &&callback)
+    : loop_(loop), fd_(timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC)), callback_(std::move(callback)) {
+  if (fd_ < 0) {
+    log_error("timerfd_create: %s", strerror(errno));
+    return;
+  }
+  loop_.add(fd_, EPOLLIN, [this](uint32_t) {
+    uint64_t expirations;
+    if (read(fd_, &expirations, sizeof(expirations)) != sizeof(expirations))
+      return;
+    active_ = false;
+    callback_();
+  });
+}
+
+Timer::~Timer() {
+  if (fd_ >= 0) {
+    loop_.remove(fd_);
+    close(fd_);
+  }
+}
+
+void Timer::start_ms(uint32_t ms) {
+  struct itimerspec its {};
+  its.it_value.tv_sec = ms / 1000;
+  its.it_value.tv_nsec = (long) (ms % 1000) * 1000000;
+  if (its.it_value.tv_sec == 0 && its.it_value.tv_nsec == 0)
+    its.it_value.tv_nsec = 1;  // zero would disarm
+  timerfd_settime(fd_, 0, &its, nullptr);
+  active_ = true;
+}
+
+void Timer::cancel() {
+  struct itimerspec its {};
+  timerfd_settime(fd_, 0, &its, nullptr);
+  active_ = false;
+}
+
+}  // namespace dacxo
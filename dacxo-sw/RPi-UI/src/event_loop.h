@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+
+namespace dacxo {
+
+/**
+ * Single-threaded event loop on epoll: all inputs of the daemon are file descriptors
+ * (ALSA control events, GPIO line events, the lircd socket, timers and signals),
+ * such that the process only wakes up on an actual event.
+ */
+class EventLoop {
+  public:
+    using Handler = std::function<void(uint32_t events)>;
+
+    EventLoop();
+    ~EventLoop();
+    EventLoop(const EventLoop &) = delete;
+    EventLoop &operator=(const EventLoop &) = delete;
+
+    /// Call 'handler' when 'fd' gets one of the epoll 'events'. @return false on error.
+    bool add(int fd, uint32_t events, Handler &&handler);
+    /// Stop watching 'fd', also allowed from within its own handler.
+    void remove(int fd);
+
+    /// Dispatch events until stop(). @return 0, or -1 on an epoll error.
+    int run();
+    void stop() { running_ = false; }
+
+    /// Number of returns from epoll_wait: the process wake-ups.
+    uint64_t wakeups() const { return wakeups_; }
+
+  private:
+    int epoll_fd_;
+    bool running_{false};
+    uint64_t wakeups_{0};
+    std::unordered_map<int, Handler> handlers_;
+};
+
+/**
+ * One-shot timer on a timerfd, calling back from the event loop.
+ */
+class Timer {
+  public:
+    Timer(EventLoop &loop, std::function<void()> &&callback);
+    ~Timer();
+    Timer(const Timer &) = delete;
+    Timer &operator=(const Timer &) = delete;
+
+    void start_ms(uint32_t ms);
+    void cancel();
+    bool is_active() const { return active_; }
+
+  private:
+    EventLoop &loop_;
+    int fd_;
+    bool active_{false};
+    std::function<void()> callback_;
+};
+
+/// CLOCK_MONOTONIC in ns: the clock of the GPIO event timestamps
+uint64_t monotonic_ns();
+
+}  // namespace dacxo
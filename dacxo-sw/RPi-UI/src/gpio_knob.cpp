@@ -0,0 +1,101 @@
+#include "gpio_knob.h"
+#include "log.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/gpio.h>
+#include <sys/epoll.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+namespace dacxo {
+
+// Line indices in the request
+static const unsigned int LINE_A = 0;
+static const unsigned int LINE_B = 1;
+static const unsigned int LINE_SWITCH = 2;
+
+static const uint32_t KNOB_DEBOUNCE_US = 1000;
+static const uint32_t SWITCH_DEBOUNCE_US = 10000;
+
+GpioKnob::~GpioKnob() {
+  if (line_fd_ >= 0) {
+    loop_.remove(line_fd_);
+    close(line_fd_);
+  }
+}
+
+bool GpioKnob::open(const char *chip, unsigned int pin_a, unsigned int pin_b, unsigned int pin_switch,
+                    TurnCallback &&on_turn, SwitchCallback &&on_switch) {
+  int chip_fd = ::open(chip, O_RDONLY | O_CLOEXEC);
+  if (chip_fd < 0) {
+    log_error("open %s: %s", chip, strerror(errno));
+    return false;
+  }
+
+  const uint64_t input = GPIO_V2_LINE_FLAG_INPUT | GPIO_V2_LINE_FLAG_ACTIVE_LOW | GPIO_V2_LINE_FLAG_BIAS_PULL_UP;
+  struct gpio_v2_line_request req {};
+  req.offsets[LINE_A] = pin_a;
+  req.offsets[LINE_B] = pin_b;
+  req.offsets[LINE_SWITCH] = pin_switch;
+  req.num_lines = 3;
+  strncpy(req.consumer, "dacxo-ui", sizeof(req.consumer) - 1);
+  req.config.flags = input;
+  // a step on phase A becoming active, both edges of the switch
+  req.config.attrs[0].attr.id = GPIO_V2_LINE_ATTR_ID_FLAGS;
+  req.config.attrs[0].attr.flags = input | GPIO_V2_LINE_FLAG_EDGE_RISING;
+  req.config.attrs[0].mask = 1ULL << LINE_A;
+  req.config.attrs[1].attr.id = GPIO_V2_LINE_ATTR_ID_FLAGS;
+  req.config.attrs[1].attr.flags = input | GPIO_V2_LINE_FLAG_EDGE_RISING | GPIO_V2_LINE_FLAG_EDGE_FALLING;
+  req.config.attrs[1].mask = 1ULL << LINE_SWITCH;
+  req.config.attrs[2].attr.id = GPIO_V2_LINE_ATTR_ID_DEBOUNCE;
+  req.config.attrs[2].attr.debounce_period_us = KNOB_DEBOUNCE_US;
+  req.config.attrs[2].mask = (1ULL << LINE_A) | (1ULL << LINE_B);
+  req.config.attrs[3].attr.id = GPIO_V2_LINE_ATTR_ID_DEBOUNCE;
+  req.config.attrs[3].attr.debounce_period_us = SWITCH_DEBOUNCE_US;
+  req.config.attrs[3].mask = 1ULL << LINE_SWITCH;
+  req.config.num_attrs = 4;
+
+  int err = ioctl(chip_fd, GPIO_V2_GET_LINE_IOCTL, &req);
+  int saved_errno = errno;
+  close(chip_fd);
+  if (err < 0) {
+    log_error("request gpio lines %u,%u,%u on %s: %s", pin_a, pin_b, pin_switch, chip, strerror(saved_errno));
+    return false;
+  }
+
+  line_fd_ = req.fd;
+  pin_a_ = pin_a;
+  pin_switch_ = pin_switch;
+  on_turn_ = std::move(on_turn);
+  on_switch_ = std::move(on_switch);
+  log_info("knob on gpio %u (A), %u (B), %u (switch)", pin_a, pin_b, pin_switch);
+  return loop_.add(line_fd_, EPOLLIN, [this](uint32_t) { read_events_(); });
+}
+
+void GpioKnob::read_events_() {
+  struct gpio_v2_line_event events[16];
+  ssize_t len = read(line_fd_, events, sizeof(events));
+  if (len < 0) {
+    if (errno != EAGAIN)
+      log_error("read gpio events: %s", strerror(errno));
+    return;
+  }
+
+  for (size_t i = 0; i < (size_t) len / sizeof(events[0]); i++) {
+    const struct gpio_v2_line_event &ev = events[i];
+    if (ev.offset == pin_a_) {
+      // the direction from the level of phase B
+      struct gpio_v2_line_values values {};
+      values.mask = 1ULL << LINE_B;
+      if (ioctl(line_fd_, GPIO_V2_LINE_GET_VALUES_IOCTL, &values) < 0)
+        continue;
+      on_turn_((values.bits & (1ULL << LINE_B)) ? -1 : +1, ev.timestamp_ns);
+    } else if (ev.offset == pin_switch_) {
+      on_switch_(ev.id == GPIO_V2_LINE_EVENT_RISING_EDGE, ev.timestamp_ns);
+    }
+  }
+}
+
+}  // namespace dacxo
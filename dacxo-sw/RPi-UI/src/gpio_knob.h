@@ -0,0 +1,49 @@
+#pragma once
+
+#include "event_loop.h"
+
+#include <cstdint>
+#include <functional>
+
+namespace dacxo {
+
+/**
+ * Rotary knob with push switch on three GPIO lines, through the GPIO character device:
+ * the kernel timestamps and debounces the edges, and wakes the daemon only on an edge.
+ * The lines are active-low with pull-up, as the knob switches to ground.
+ */
+class GpioKnob {
+  public:
+    /// 'steps' +1 for a step to the right, -1 to the left. 'ts_ns' is the edge time in CLOCK_MONOTONIC.
+    using TurnCallback = std::function<void(int steps, uint64_t ts_ns)>;
+    using SwitchCallback = std::function<void(bool pressed, uint64_t ts_ns)>;
+
+    explicit GpioKnob(EventLoop &loop) : loop_(loop) {}
+    ~GpioKnob();
+    GpioKnob(const GpioKnob &) = delete;
+    GpioKnob &operator=(const GpioKnob &) = delete;
+
+    /**
+     * Request the lines and start watching their edges.
+     *
+     * @param chip The gpio chip device, such as "/dev/gpiochip0".
+     * @param pin_a Knob phase A: a step on each of its active edges.
+     * @param pin_b Knob phase B: its level on the A edge sets the direction.
+     * @param pin_switch The push switch.
+     * @return false if the lines could not be requested.
+     */
+    bool open(const char *chip, unsigned int pin_a, unsigned int pin_b, unsigned int pin_switch,
+              TurnCallback &&on_turn, SwitchCallback &&on_switch);
+
+  private:
+    void read_events_();
+
+    EventLoop &loop_;
+    int line_fd_{-1};
+    unsigned int pin_a_{0};
+    unsigned int pin_switch_{0};
+    TurnCallback on_turn_;
+    SwitchCallback on_switch_;
+};
+
+}  // namespace dacxo
@@ -0,0 +1,92 @@
+#include "lirc_input.h"
+#include "log.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace dacxo {
+
+static const uint32_t RETRY_MS = 5000;
+
+LircInput::LircInput(EventLoop &loop) : loop_(loop), retry_timer_(loop, [this]() { connect_(); }) {}
+
+LircInput::~LircInput() { disconnect_(); }
+
+void LircInput::open(const char *socket_path, KeyCallback &&on_key) {
+  path_ = socket_path;
+  on_key_ = std::move(on_key);
+  connect_();
+}
+
+void LircInput::connect_() {
+  struct sockaddr_un addr {};
+  addr.sun_family = AF_UNIX;
+  strncpy(addr.sun_path, path_.c_str(), sizeof(addr.sun_path) - 1);
+
+  fd_ = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (fd_ < 0 || connect(fd_, (struct sockaddr *) &addr, sizeof(addr)) < 0) {
+    log_debug("lircd socket %s: %s, retry in %u s", path_.c_str(), strerror(errno), RETRY_MS / 1000);
+    if (fd_ >= 0)
+      close(fd_);
+    fd_ = -1;
+    retry_timer_.start_ms(RETRY_MS);
+    return;
+  }
+  log_info("ir remote on %s", path_.c_str());
+  loop_.add(fd_, EPOLLIN, [this](uint32_t) { read_(); });
+}
+
+void LircInput::disconnect_() {
+  if (fd_ < 0)
+    return;
+  loop_.remove(fd_);
+  close(fd_);
+  fd_ = -1;
+  pending_.clear();
+}
+
+void LircInput::read_() {
+  char buf[256];
+  ssize_t len = read(fd_, buf, sizeof(buf));
+  if (len <= 0) {
+    if (len < 0 && errno == EAGAIN)
+      return;
+    log_info("lircd closed the connection");
+    disconnect_();
+    retry_timer_.start_ms(RETRY_MS);
+    return;
+  }
+
+  const uint64_t ts_ns = monotonic_ns();
+  pending_.append(buf, len);
+  size_t eol;
+  while ((eol = pending_.find('\n')) != std::string::npos) {
+    handle_line_(pending_.substr(0, eol), ts_ns);
+    pending_.erase(0, eol + 1);
+  }
+}
+
+// A line as "<code> <repeat> <key name> <remote name>", with the repeat count in hex
+void LircInput::handle_line_(const std::string &line, uint64_t ts_ns) {
+  std::istringstream fields(line);
+  std::string code, repeat_hex, name;
+  if (!(fields >> code >> repeat_hex >> name))
+    return;
+  const unsigned int repeat = strtoul(repeat_hex.c_str(), nullptr, 16);
+  log_debug("ir key %s repeat %u", name.c_str(), repeat);
+
+  if (name == "KEY_VOLUMEUP" || name == "KEY_UP")
+    on_key_(KEY_VOLUME_UP, repeat, ts_ns);
+  else if (name == "KEY_VOLUMEDOWN" || name == "KEY_DOWN")
+    on_key_(KEY_VOLUME_DOWN, repeat, ts_ns);
+  else if (name == "KEY_POWER")
+    on_key_(KEY_POWER, repeat, ts_ns);
+}
+
+}  // namespace dacxo
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "event_loop.h"
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
+namespace dacxo {
+
+/**
+ * IR remote keys from the lircd socket, as the 'irw' tool reads them.
+ * Requires a lircd.conf for the remote, such as the one in RPi-UI-old/lirc, but no lircrc.
+ * Reconnects when lircd is not (yet) running.
+ */
+class LircInput {
+  public:
+    enum Key { KEY_VOLUME_UP, KEY_VOLUME_DOWN, KEY_POWER };
+    /// 'repeat' counts the repeated codes of a key held down. 'ts_ns' is the receive time in CLOCK_MONOTONIC.
+    using KeyCallback = std::function<void(Key key, unsigned int repeat, uint64_t ts_ns)>;
+
+    explicit LircInput(EventLoop &loop);
+    ~LircInput();
+    LircInput(const LircInput &) = delete;
+    LircInput &operator=(const LircInput &) = delete;
+
+    void open(const char *socket_path, KeyCallback &&on_key);
+
+  private:
+    void connect_();
+    void disconnect_();
+    void read_();
+    void handle_line_(const std::string &line, uint64_t ts_ns);
+
+    EventLoop &loop_;
+    Timer retry_timer_;
+    std::string path_;
+    int fd_{-1};
+    std::string pending_;  // received text without line end yet
+    KeyCallback on_key_;
+};
+
+}  // namespace dacxo
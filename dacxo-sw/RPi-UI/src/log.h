@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstdio>
+
+namespace dacxo {
+
+// Log to stderr, which ends up in the journal when run as systemd service.
+// The debug messages only with the '-v' option.
+extern bool log_verbose;
+
+#define log_error(fmt, ...) fprintf(stderr, "dacxo-ui: error: " fmt "\n", ##__VA_ARGS__)
+#define log_info(fmt, ...) fprintf(stderr, "dacxo-ui: " fmt "\n", ##__VA_ARGS__)
+#define log_debug(fmt, ...) \
+  do { \
+    if (::dacxo::log_verbose) \
+      fprintf(stderr, "dacxo-ui: " fmt "\n", ##__VA_ARGS__); \
+  } while (0)
+
+}  // namespace dacxo
@@ -0,0 +1,74 @@
+#include "dacxo_ui.h"
+#include "event_loop.h"
+#include "log.h"
+
+#include <cstdlib>
+#include <getopt.h>
+
+bool dacxo::log_verbose = false;
+
+static void usage(const char *name) {
+  fprintf(stderr,
+          "Usage: %s [options]\n"
+          "  -c, --card NAME        alsa control device (hw:DACXO)\n"
+          "  -g, --gpiochip DEV     gpio chip of the knob (/dev/gpiochip0)\n"
+          "  -k, --knob A,B,SWITCH  knob gpio lines (5,6,13)\n"
+          "  -l, --lirc PATH        lircd socket, '' for none (/var/run/lirc/lircd)\n"
+          "  -d, --display BUS      i2c bus of the 16x2 oled (none)\n"
+          "  -o, --holdoff MS       volume write coalescing time (20)\n"
+          "  -v, --verbose          debug messages\n"
+          "Send SIGUSR1 for the wake-up, memory and latency statistics.\n",
+          name);
+}
+
+int main(int argc, char **argv) {
+  static const struct option long_options[] = {
+      {"card", required_argument, nullptr, 'c'},    {"gpiochip", required_argument, nullptr, 'g'},
+      {"knob", required_argument, nullptr, 'k'},    {"lirc", required_argument, nullptr, 'l'},
+      {"display", required_argument, nullptr, 'd'}, {"holdoff", required_argument, nullptr, 'o'},
+      {"verbose", no_argument, nullptr, 'v'},       {"help", no_argument, nullptr, 'h'},
+      {nullptr, 0, nullptr, 0},
+  };
+
+  dacxo::Options options;
+  int opt;
+  while ((opt = getopt_long(argc, argv, "c:g:k:l:d:o:vh", long_options, nullptr)) != -1) {
+    switch (opt) {
+      case 'c':
+        options.card = optarg;
+        break;
+      case 'g':
+        options.gpiochip = optarg;
+        break;
+      case 'k':
+        if (sscanf(optarg, "%u,%u,%u", &options.knob_pins[0], &options.knob_pins[1], &options.knob_pins[2]) != 3) {
+          usage(argv[0]);
+          return EXIT_FAILURE;
+        }
+        break;
+      case 'l':
+        options.lirc_socket = optarg;
+        break;
+      case 'd':
+        options.display_bus = atoi(optarg);
+        break;
+      case 'o':
+        options.holdoff_ms = strtoul(optarg, nullptr, 0);
+        break;
+      case 'v':
+        dacxo::log_verbose = true;
+        break;
+      default:
+        usage(argv[0]);
+        return opt == 'h' ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+  }
+
+  dacxo::EventLoop loop;
+  dacxo::DacXo dac(loop, options);
+  if (!dac.start())
+    return EXIT_FAILURE;
+  int ret = loop.run();
+  dac.print_stats();
+  return ret == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,127 @@
+#include "oled16x2.h"
+#include "log.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/i2c-dev.h>
+#include <sys/ioctl.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace dacxo {
+
+static const uint8_t I2C_ADDRESS = 0x3c;
+static const uint8_t CMD_MODE = 0x80;
+static const uint8_t DATA_MODE = 0x40;
+static const uint8_t CGRAM_ADDR = 0x40;
+static const uint8_t DDRAM_ADDR = 0x80;
+
+// The 8 glyphs to build the big digits from, stored as custom chars 0..7
+static const uint8_t BIG_CHAR_GLYPHS[8][8] = {
+    {0x07, 0x0f, 0x1f, 0x1f, 0x1f, 0x1f, 0x1f, 0x1f},  // left top
+    {0x1f, 0x1f, 0x1f, 0x00, 0x00, 0x00, 0x00, 0x00},
+    {0x1c, 0x1e, 0x1f, 0x1f, 0x1f, 0x1f, 0x1f, 0x1f},  // right top
+    {0x1f, 0x1f, 0x1f, 0x1f, 0x1f, 0x1f, 0x0f, 0x07},
+    {0x1f, 0x1f, 0x1f, 0x1f, 0x1f, 0x1f, 0x0f, 0x07},
+    {0x1f, 0x1f, 0x1f, 0x1f, 0x1f, 0x1f, 0x1e, 0x1c},  // lower right
+    {0x1f, 0x1f, 0x1f, 0x00, 0x00, 0x00, 0x1f, 0x1f},  // upper middle
+    {0x1f, 0x00, 0x00, 0x00, 0x00, 0x1f, 0x1f, 0x1f},  // lower middle
+};
+
+// Each digit as 2 rows of 3 glyphs, or blank/full chars
+static const uint8_t BLK = ' ';
+static const uint8_t WHT = 0x1f;
+static const uint8_t BIG_CHARS[10][6] = {
+    {0, 1, 2, 3, 4, 5},             {BLK, WHT, BLK, BLK, WHT, BLK}, {6, 6, 2, 3, 7, 7},
+    {6, 6, 2, 7, 7, 5},             {3, 4, 2, BLK, BLK, WHT},       {WHT, 6, 6, 7, 7, 5},
+    {0, 6, 6, 3, 7, 5},             {1, 1, 2, BLK, 0, BLK},         {0, 6, 2, 3, 7, 5},
+    {0, 6, 2, BLK, BLK, WHT},
+};
+
+// The controller init: internal regulator, clock, segment config, contrast and VCOM
+// levels, the 15V generator, entry mode. See oled16x2.py for the command by command notes.
+static const uint8_t INIT_SEQUENCE_1[] = {0x2a, 0x71};
+static const uint8_t INIT_SEQUENCE_2[] = {0x28, 0x08, 0x2a, 0x79, 0xd5, 0x70, 0x78, 0x08, 0x06, 0x72};
+static const uint8_t INIT_SEQUENCE_3[] = {0x2a, 0x79, 0xda, 0x10, 0x81, 0xff, 0xdb, 0x30, 0xdc,
+                                          0x03, 0x78, 0x28, 0x2a, 0x06, 0x08, 0x28, 0x01};
+
+Oled16x2::~Oled16x2() {
+  if (fd_ >= 0)
+    close(fd_);
+}
+
+bool Oled16x2::open(unsigned int bus) {
+  char path[32];
+  snprintf(path, sizeof(path), "/dev/i2c-%u", bus);
+  fd_ = ::open(path, O_RDWR | O_CLOEXEC);
+  if (fd_ < 0 || ioctl(fd_, I2C_SLAVE, I2C_ADDRESS) < 0) {
+    log_error("display on %s: %s", path, strerror(errno));
+    if (fd_ >= 0)
+      close(fd_);
+    fd_ = -1;
+    return false;
+  }
+
+  static const uint8_t regulator_on = 0x5c;
+  static const uint8_t rom_a = 0x00;
+  for (uint8_t cmd : INIT_SEQUENCE_1)
+    send_cmd_(cmd);
+  send_data_(&regulator_on, 1);
+  for (uint8_t cmd : INIT_SEQUENCE_2)
+    send_cmd_(cmd);
+  send_data_(&rom_a, 1);
+  for (uint8_t cmd : INIT_SEQUENCE_3)
+    send_cmd_(cmd);
+  // the clear takes a while, only once here
+  const struct timespec clear_time = {0, 20 * 1000 * 1000};
+  nanosleep(&clear_time, nullptr);
+
+  for (unsigned int i = 0; i < 8; i++) {
+    send_cmd_(CGRAM_ADDR + i * 8);
+    send_data_(BIG_CHAR_GLYPHS[i], sizeof(BIG_CHAR_GLYPHS[i]));
+  }
+  send_cmd_(0x0c);  // display on
+  log_info("display on %s", path);
+  return true;
+}
+
+void Oled16x2::show_string(unsigned int row, unsigned int col, const std::string &text) {
+  show_data_(row, col, (const uint8_t *) text.data(), text.size());
+}
+
+void Oled16x2::show_big_digit(unsigned int col, unsigned int digit) {
+  if (digit > 9)
+    return;
+  show_data_(0, col, &BIG_CHARS[digit][0], 3);
+  show_data_(1, col, &BIG_CHARS[digit][3], 3);
+}
+
+void Oled16x2::clear() { send_cmd_(0x01); }
+
+void Oled16x2::show_data_(unsigned int row, unsigned int col, const uint8_t *data, size_t len) {
+  send_cmd_(DDRAM_ADDR + col + row * 0x40);
+  send_data_(data, len);
+}
+
+void Oled16x2::send_cmd_(uint8_t cmd) {
+  if (fd_ < 0)
+    return;
+  const uint8_t buf[2] = {CMD_MODE, cmd};
+  if (write(fd_, buf, sizeof(buf)) != sizeof(buf))
+    log_debug("display cmd 0x%02x: %s", cmd, strerror(errno));
+}
+
+void Oled16x2::send_data_(const uint8_t *data, size_t len) {
+  if (fd_ < 0 || len == 0)
+    return;
+  uint8_t buf[1 + 40];  // a row of the display RAM at most
+  if (len > sizeof(buf) - 1)
+    len = sizeof(buf) - 1;
+  buf[0] = DATA_MODE;
+  memcpy(buf + 1, data, len);
+  if (write(fd_, buf, len + 1) != (ssize_t) (len + 1))
+    log_debug("display data: %s", strerror(errno));
+}
+
+}  // namespace dacxo
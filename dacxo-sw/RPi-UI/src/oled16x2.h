@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace dacxo {
+
+/**
+ * The 16x2 character OLED on i2c-dev, as oled16x2.py of the former Python UI,
+ * with the big-digit glyphs in its custom character RAM.
+ */
+class Oled16x2 {
+  public:
+    Oled16x2() = default;
+    ~Oled16x2();
+    Oled16x2(const Oled16x2 &) = delete;
+    Oled16x2 &operator=(const Oled16x2 &) = delete;
+
+    /// Open /dev/i2c-'bus' and initialize the display. @return false without display.
+    bool open(unsigned int bus);
+    bool is_open() const { return fd_ >= 0; }
+
+    /// 'row' 0 or 1, 'col' 0..15
+    void show_string(unsigned int row, unsigned int col, const std::string &text);
+    /// A 3 columns wide digit over both rows
+    void show_big_digit(unsigned int col, unsigned int digit);
+    void clear();
+
+  private:
+    void show_data_(unsigned int row, unsigned int col, const uint8_t *data, size_t len);
+    void send_cmd_(uint8_t cmd);
+    void send_data_(const uint8_t *data, size_t len);
+
+    int fd_{-1};
+};
+
+}  // namespace dacxo
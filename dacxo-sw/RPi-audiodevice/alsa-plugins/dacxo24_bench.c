@@ -0,0 +1,127 @@
+/*
+ * Benchmark of the S24_3LE to S24_LE conversion for the dacxo card, at all its sample rates:
+ * - the generic ALSA 'plug' conversion, into the 'null' pcm
+ * - the 'dacxo24' plugin, into the 'null' pcm (if installed)
+ * - the bare conversion kernel of the plugin
+ * Reported is the cpu time as percentage of the audio duration.
+ *
+ * Copyright 2016 Jos van Eijndhoven
+ * jos@vaneijndhoven.net
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <alsa/asoundlib.h>
+
+#include "dacxo_convert.h"
+
+#define CHANNELS      2
+#define PERIOD_FRAMES 4096
+#define AUDIO_SECONDS 10   // per rate and per path
+
+// the rates in DACXO_RATES
+static const unsigned int rates[] = { 44100, 48000, 88200, 96000, 176400, 192000 };
+
+// The plug path as in etc/asound.conf, and the plugin path, with the null pcm as sink
+static const char bench_conf[] =
+	"pcm.bench_plug { type plug slave { pcm \"null\" format S24_LE } }\n"
+	"pcm.bench_dacxo24 { type dacxo24 slave.pcm \"null\" }\n";
+
+static double cpu_seconds(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// @return cpu time per audio time in percent, or a negative value if the pcm is not available
+static double bench_pcm(snd_config_t *config, const char *pcm_name, unsigned int rate, const uint8_t *buf)
+{
+	snd_pcm_t *pcm;
+	if (snd_pcm_open_lconf(&pcm, pcm_name, SND_PCM_STREAM_PLAYBACK, 0, config) < 0)
+		return -1;
+	int err = snd_pcm_set_params(pcm, SND_PCM_FORMAT_S24_3LE, SND_PCM_ACCESS_RW_INTERLEAVED,
+	                             CHANNELS, rate, 0, 500000);
+	if (err < 0) {
+		fprintf(stderr, "%s: set_params(rate=%u): %s\n", pcm_name, rate, snd_strerror(err));
+		snd_pcm_close(pcm);
+		return -1;
+	}
+
+	const size_t total = (size_t)rate * AUDIO_SECONDS;
+	double start = cpu_seconds();
+	for (size_t done = 0; done < total; done += PERIOD_FRAMES) {
+		snd_pcm_sframes_t n = snd_pcm_writei(pcm, buf, PERIOD_FRAMES);
+		if (n < 0)
+			snd_pcm_recover(pcm, n, 1);
+	}
+	double cpu = cpu_seconds() - start;
+	snd_pcm_close(pcm);
+	return 100.0 * cpu / AUDIO_SECONDS;
+}
+
+static double bench_kernel(unsigned int rate, const uint8_t *buf, int32_t *out)
+{
+	const size_t total = (size_t)rate * AUDIO_SECONDS;
+	double start = cpu_seconds();
+	for (size_t done = 0; done < total; done += PERIOD_FRAMES)
+		dacxo_s24_3le_to_s24_le(out, buf, PERIOD_FRAMES * CHANNELS);
+	return 100.0 * (cpu_seconds() - start) / AUDIO_SECONDS;
+}
+
+int main(void)
+{
+	uint8_t *buf = malloc(PERIOD_FRAMES * CHANNELS * 3);
+	int32_t *out = malloc(PERIOD_FRAMES * CHANNELS * sizeof(int32_t));
+	if (!buf || !out)
+		return 1;
+	for (size_t i = 0; i < PERIOD_FRAMES * CHANNELS * 3; i++)
+		buf[i] = rand();
+
+	// verify the vectorized kernel against the scalar one
+	int32_t *ref = malloc(PERIOD_FRAMES * CHANNELS * sizeof(int32_t));
+	if (!ref)
+		return 1;
+	dacxo_s24_3le_to_s24_le(out, buf, PERIOD_FRAMES * CHANNELS - 1);
+	dacxo_s24_3le_to_s24_le_scalar(ref, buf, PERIOD_FRAMES * CHANNELS - 1);
+	if (memcmp(out, ref, (PERIOD_FRAMES * CHANNELS - 1) * sizeof(int32_t)) != 0) {
+		fprintf(stderr, "%s kernel mismatch!\n", dacxo_convert_isa);
+		return 1;
+	}
+	free(ref);
+
+	snd_config_t *config;
+	snd_input_t *in;
+	snd_config_update();
+	snd_config_copy(&config, snd_config);
+	snd_input_buffer_open(&in, bench_conf, -1);
+	snd_config_load(config, in);
+	snd_input_close(in);
+
+	printf("S24_3LE to S24_LE, %u channels, cpu time in %% of audio time, kernel: %s\n",
+	       CHANNELS, dacxo_convert_isa);
+	printf("%8s %10s %10s %10s\n", "rate", "plug", "dacxo24", "kernel");
+	for (size_t r = 0; r < sizeof(rates) / sizeof(rates[0]); r++) {
+		double plug = bench_pcm(config, "bench_plug", rates[r], buf);
+		double plugin = bench_pcm(config, "bench_dacxo24", rates[r], buf);
+		double kernel = bench_kernel(rates[r], buf, out);
+		printf("%8u %9.2f%% ", rates[r], plug);
+		if (plugin < 0)
+			printf("%10s ", "n/a");
+		else
+			printf("%9.2f%% ", plugin);
+		printf("%9.3f%%\n", kernel);
+	}
+
+	snd_config_delete(config);
+	free(buf);
+	free(out);
+	return 0;
+}
@@ -0,0 +1,136 @@
+/*
+ * Benchmark of the partitioned convolution engine of the 'dacxo_conv' ALSA plugin:
+ * stereo at 192kHz with filters of 64k taps, for each partition size, with one and two threads.
+ * Reported per partition size:
+ * - the latency of the engine
+ * - the wall-clock time as percentage of the audio duration: above 100% it can not keep up
+ * - the cpu time of all threads as percentage of the audio duration
+ * The engine output is first verified against a direct convolution.
+ *
+ * Copyright 2016 Jos van Eijndhoven
+ * jos@vaneijndhoven.net
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "dacxo_convolve.h"
+
+#define CHANNELS      2
+#define RATE          192000
+#define TAPS          65536
+#define AUDIO_SECONDS 4    // per partition size and thread count
+
+static double seconds(clockid_t clock)
+{
+	struct timespec ts;
+	clock_gettime(clock, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Decaying noise, as the tail of a room impulse response
+static float *make_filter(size_t taps)
+{
+	float *h = malloc(taps * sizeof(float));
+	if (!h)
+		exit(1);
+	for (size_t i = 0; i < taps; i++)
+		h[i] = (rand() / (float)RAND_MAX - 0.5f) * expf(-(float)i / (taps / 8));
+	return h;
+}
+
+static int verify(void)
+{
+	const unsigned int partition = 64, blocks = 32;
+	const size_t taps[CHANNELS] = { 1000, 333 };
+	float *h[CHANNELS];
+	for (unsigned int c = 0; c < CHANNELS; c++)
+		h[c] = make_filter(taps[c]);
+	struct dacxo_convolver *conv = dacxo_convolve_create(CHANNELS, partition, (const float *const *)h, taps, CHANNELS);
+	if (!conv)
+		return -1;
+
+	const size_t frames = (size_t)partition * blocks;
+	float *x = malloc(frames * sizeof(float));
+	float *y = malloc(frames * sizeof(float));
+	double max_err = 0.0;
+	for (size_t i = 0; i < frames; i++)
+		x[i] = rand() / (float)RAND_MAX - 0.5f;
+	for (unsigned int c = 0; c < CHANNELS; c++) {
+		dacxo_convolve_reset(conv);
+		for (unsigned int b = 0; b < blocks; b++) {
+			for (unsigned int i = 0; i < partition; i++)
+				dacxo_convolve_input(conv, c)[i] = x[b * partition + i];
+			dacxo_convolve_run(conv);
+			for (unsigned int i = 0; i < partition; i++)
+				y[b * partition + i] = dacxo_convolve_output(conv, c)[i];
+		}
+		for (size_t n = 0; n < frames; n++) {
+			double ref = 0.0;
+			for (size_t j = 0; j < taps[c] && j <= n; j++)
+				ref += h[c][j] * x[n - j];
+			if (fabs(ref - y[n]) > max_err)
+				max_err = fabs(ref - y[n]);
+		}
+	}
+	dacxo_convolve_destroy(conv);
+	for (unsigned int c = 0; c < CHANNELS; c++)
+		free(h[c]);
+	free(x);
+	free(y);
+	return max_err < 1e-4 ? 0 : -1;
+}
+
+int main(void)
+{
+	if (verify() < 0) {
+		fprintf(stderr, "%s engine mismatch against direct convolution!\n", dacxo_convolve_isa);
+		return 1;
+	}
+
+	float *h[CHANNELS];
+	size_t taps[CHANNELS];
+	for (unsigned int c = 0; c < CHANNELS; c++) {
+		h[c] = make_filter(TAPS);
+		taps[c] = TAPS;
+	}
+
+	printf("Partitioned convolution, %u channels at %uHz, %u taps, kernel: %s\n",
+	       CHANNELS, RATE, TAPS, dacxo_convolve_isa);
+	printf("%9s %9s %8s %9s %9s\n", "partition", "latency", "threads", "realtime", "cpu");
+	for (unsigned int partition = DACXO_CONV_PARTITION_MIN; partition <= 8192; partition *= 2) {
+		for (unsigned int threads = 1; threads <= CHANNELS; threads++) {
+			struct dacxo_convolver *conv = dacxo_convolve_create(CHANNELS, partition,
+			                                                     (const float *const *)h, taps, threads);
+			if (!conv) {
+				fprintf(stderr, "out of memory\n");
+				return 1;
+			}
+			for (unsigned int c = 0; c < CHANNELS; c++)
+				for (unsigned int i = 0; i < partition; i++)
+					dacxo_convolve_input(conv, c)[i] = rand() / (float)RAND_MAX - 0.5f;
+
+			const unsigned int blocks = (unsigned int)((size_t)RATE * AUDIO_SECONDS / partition);
+			double wall = seconds(CLOCK_MONOTONIC), cpu = seconds(CLOCK_PROCESS_CPUTIME_ID);
+			for (unsigned int b = 0; b < blocks; b++)
+				dacxo_convolve_run(conv);
+			wall = seconds(CLOCK_MONOTONIC) - wall;
+			cpu = seconds(CLOCK_PROCESS_CPUTIME_ID) - cpu;
+
+			printf("%9u %7.2fms %8u %8.1f%% %8.1f%%\n", partition, 1000.0 * partition / RATE,
+			       dacxo_convolve_threads(conv), 100.0 * wall / AUDIO_SECONDS, 100.0 * cpu / AUDIO_SECONDS);
+			dacxo_convolve_destroy(conv);
+		}
+	}
+
+	for (unsigned int c = 0; c < CHANNELS; c++)
+		free(h[c]);
+	return 0;
+}
@@ -0,0 +1,115 @@
+/*
+ * Sample format conversion kernels of the 'dacxo24' ALSA plugin
+ *
+ * Copyright 2016 Jos van Eijndhoven
+ * jos@vaneijndhoven.net
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ */
+
+#include <string.h>
+#include "dacxo_convert.h"
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+const char *const dacxo_convert_isa = "neon";
+#elif defined(__SSSE3__)
+#include <tmmintrin.h>
+const char *const dacxo_convert_isa = "ssse3";
+#else
+const char *const dacxo_convert_isa = "scalar";
+#endif
+
+void dacxo_s24_3le_to_s24_le_scalar(int32_t *dst, const uint8_t *src, size_t count)
+{
+	for (size_t i = 0; i < count; i++, src += 3) {
+		// shift into the upper bits, and back down for the sign extension
+		uint32_t v = ((uint32_t)src[0] << 8) | ((uint32_t)src[1] << 16) | ((uint32_t)src[2] << 24);
+		dst[i] = (int32_t)v >> 8;
+	}
+}
+
+void dacxo_s16_le_to_s24_le_scalar(int32_t *dst, const int16_t *src, size_t count)
+{
+	for (size_t i = 0; i < count; i++)
+		dst[i] = (int32_t)src[i] * 256;
+}
+
+#if defined(__ARM_NEON)
+
+void dacxo_s24_3le_to_s24_le(int32_t *dst, const uint8_t *src, size_t count)
+{
+	size_t i = 0;
+	// 16 samples per iteration: de-interleave the three bytes of each sample,
+	// and interleave them again with a fourth sign byte
+	for (; i + 16 <= count; i += 16, src += 48) {
+		uint8x16x3_t in = vld3q_u8(src);
+		uint8x16x4_t out;
+		out.val[0] = in.val[0];
+		out.val[1] = in.val[1];
+		out.val[2] = in.val[2];
+		out.val[3] = vreinterpretq_u8_s8(vshrq_n_s8(vreinterpretq_s8_u8(in.val[2]), 7));
+		vst4q_u8((uint8_t *)(dst + i), out);
+	}
+	dacxo_s24_3le_to_s24_le_scalar(dst + i, src, count - i);
+}
+
+void dacxo_s16_le_to_s24_le(int32_t *dst, const int16_t *src, size_t count)
+{
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		int16x8_t in = vld1q_s16(src + i);
+		vst1q_s32(dst + i, vshll_n_s16(vget_low_s16(in), 8));
+		vst1q_s32(dst + i + 4, vshll_n_s16(vget_high_s16(in), 8));
+	}
+	dacxo_s16_le_to_s24_le_scalar(dst + i, src + i, count - i);
+}
+
+#elif defined(__SSSE3__)
+
+void dacxo_s24_3le_to_s24_le(int32_t *dst, const uint8_t *src, size_t count)
+{
+	// place each 3-byte sample in the upper bytes of a 32-bit lane, then shift down with sign extension
+	const __m128i shuffle = _mm_setr_epi8(-1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11);
+	size_t i = 0;
+	// 8 samples (24 bytes) per iteration, as two 16-byte loads of which 12 bytes are used.
+	// The loop condition keeps the second load within the source buffer.
+	for (; i + 8 + 2 <= count; i += 8, src += 24) {
+		__m128i lo = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)src), shuffle);
+		__m128i hi = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(src + 12)), shuffle);
+		_mm_storeu_si128((__m128i *)(dst + i), _mm_srai_epi32(lo, 8));
+		_mm_storeu_si128((__m128i *)(dst + i + 4), _mm_srai_epi32(hi, 8));
+	}
+	dacxo_s24_3le_to_s24_le_scalar(dst + i, src, count - i);
+}
+
+void dacxo_s16_le_to_s24_le(int32_t *dst, const int16_t *src, size_t count)
+{
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		__m128i in = _mm_loadu_si128((const __m128i *)(src + i));
+		// interleave with zeros below each sample: (s16 << 16), then shift down to (s16 << 8)
+		__m128i lo = _mm_unpacklo_epi16(_mm_setzero_si128(), in);
+		__m128i hi = _mm_unpackhi_epi16(_mm_setzero_si128(), in);
+		_mm_storeu_si128((__m128i *)(dst + i), _mm_srai_epi32(lo, 8));
+		_mm_storeu_si128((__m128i *)(dst + i + 4), _mm_srai_epi32(hi, 8));
+	}
+	dacxo_s16_le_to_s24_le_scalar(dst + i, src + i, count - i);
+}
+
+#else
+
+void dacxo_s24_3le_to_s24_le(int32_t *dst, const uint8_t *src, size_t count)
+{
+	dacxo_s24_3le_to_s24_le_scalar(dst, src, count);
+}
+
+void dacxo_s16_le_to_s24_le(int32_t *dst, const int16_t *src, size_t count)
+{
+	dacxo_s16_le_to_s24_le_scalar(dst, src, count);
+}
+
+#endif
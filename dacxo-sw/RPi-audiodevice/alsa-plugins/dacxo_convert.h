@@ -0,0 +1,33 @@
+/*
+ * Sample format conversion kernels of the 'dacxo24' ALSA plugin
+ *
+ * Copyright 2016 Jos van Eijndhoven
+ * jos@vaneijndhoven.net
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ */
+
+#ifndef _DACXO_CONVERT_H
+#define _DACXO_CONVERT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Name of the kernel variant that got compiled in: "neon", "ssse3" or "scalar"
+extern const char *const dacxo_convert_isa;
+
+// Packed 24-bit (S24_3LE, as produced by flac) to 24-bit in 32-bit words (S24_LE),
+// with the upper byte as sign extension. 'count' is the number of samples.
+void dacxo_s24_3le_to_s24_le(int32_t *dst, const uint8_t *src, size_t count);
+
+// 16-bit (S16_LE) to S24_LE: exact, the 16 bits become the upper bits of the 24-bit sample
+void dacxo_s16_le_to_s24_le(int32_t *dst, const int16_t *src, size_t count);
+
+// Scalar reference versions of the above, for the tail samples and for verification
+void dacxo_s24_3le_to_s24_le_scalar(int32_t *dst, const uint8_t *src, size_t count);
+void dacxo_s16_le_to_s24_le_scalar(int32_t *dst, const int16_t *src, size_t count);
+
+#endif /* _DACXO_CONVERT_H */
@@ -0,0 +1,508 @@
+/*
+ * Uniformly partitioned FFT convolution engine of the 'dacxo_conv' ALSA plugin
+ *
+ * Overlap-save with a frequency domain delay line: each block of 'partition' frames is
+ * transformed once (FFT size 2 x partition), and multiplied with the spectra of all filter partitions
+ * of the same size. The latency is one partition, and the cpu load per frame grows with the
+ * number of partitions: a larger partition lowers the cpu load at the cost of latency.
+ *
+ * The real FFT of size 2m is done as a complex FFT of size m, in split (re, im) arrays,
+ * such that the butterflies and the spectrum multiply-accumulate run 4 bins per instruction.
+ * The channels run in parallel threads: one per dac chip of the dual-mono dacxo.
+ *
+ * Copyright 2016 Jos van Eijndhoven
+ * jos@vaneijndhoven.net
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ */
+
+#include <errno.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "dacxo_convolve.h"
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+const char *const dacxo_convolve_isa = "neon";
+#define HAVE_VF 1
+typedef float32x4_t vf;
+#define VF_LOAD(p)     vld1q_f32(p)
+#define VF_STORE(p, v) vst1q_f32((p), (v))
+#define VF_ADD(a, b)   vaddq_f32((a), (b))
+#define VF_SUB(a, b)   vsubq_f32((a), (b))
+#define VF_MUL(a, b)   vmulq_f32((a), (b))
+#define VF_MLA(acc, a, b) vmlaq_f32((acc), (a), (b))
+#define VF_MLS(acc, a, b) vmlsq_f32((acc), (a), (b))
+#elif defined(__SSE__)
+#include <xmmintrin.h>
+const char *const dacxo_convolve_isa = "sse";
+#define HAVE_VF 1
+typedef __m128 vf;
+#define VF_LOAD(p)     _mm_loadu_ps(p)
+#define VF_STORE(p, v) _mm_storeu_ps((p), (v))
+#define VF_ADD(a, b)   _mm_add_ps((a), (b))
+#define VF_SUB(a, b)   _mm_sub_ps((a), (b))
+#define VF_MUL(a, b)   _mm_mul_ps((a), (b))
+#define VF_MLA(acc, a, b) _mm_add_ps((acc), _mm_mul_ps((a), (b)))
+#define VF_MLS(acc, a, b) _mm_sub_ps((acc), _mm_mul_ps((a), (b)))
+#else
+const char *const dacxo_convolve_isa = "scalar";
+#endif
+
+// Tables of the complex FFT of size m, shared by the channels
+struct fft_tables {
+	unsigned int m;
+	unsigned int *bitrev;
+	float *tw_re, *tw_im;  // at [h + j]: exp(-2 pi i j / 2h), for the stage of half size h
+	float *rt_re, *rt_im;  // at [k]: exp(-2 pi i k / 2m), k in [0, m], for the real split
+};
+
+struct conv_channel {
+	float *in, *prev, *out;     // blocks of 'partition' frames
+	float *zr, *zi;             // complex FFT scratch of size m
+	float *fdl_re, *fdl_im;     // 'parts' input spectra, newest at 'head'
+	float *filt_re, *filt_im;   // 'parts' filter spectra, scaled for the inverse FFT
+	float *acc_re, *acc_im;     // output spectrum
+	unsigned int head;
+};
+
+struct dacxo_convolver {
+	unsigned int channels;
+	unsigned int partition;
+	unsigned int bins;          // m + 1 spectrum bins, rounded up to the vector size
+	unsigned int parts;         // filter partitions
+	struct fft_tables fft;
+	struct conv_channel ch[DACXO_CONV_CHANNELS_MAX];
+
+	// worker threads for the channels beyond the first
+	unsigned int threads;
+	pthread_t tid[DACXO_CONV_CHANNELS_MAX];
+	pthread_mutex_t lock;
+	pthread_cond_t start_cond;
+	pthread_cond_t done_cond;
+	unsigned int generation;    // of the current run
+	unsigned int pending;       // workers still busy on it
+	bool quit;
+};
+
+static float *alloc_floats(size_t n)
+{
+	void *p = NULL;
+	if (posix_memalign(&p, 64, n * sizeof(float)) != 0)
+		return NULL;
+	memset(p, 0, n * sizeof(float));
+	return p;
+}
+
+static int fft_init(struct fft_tables *t, unsigned int m)
+{
+	unsigned int log2m = 0;
+	while ((1u << log2m) < m)
+		log2m++;
+
+	t->m = m;
+	t->bitrev = malloc(m * sizeof(unsigned int));
+	t->tw_re = alloc_floats(m);
+	t->tw_im = alloc_floats(m);
+	t->rt_re = alloc_floats(m + 1);
+	t->rt_im = alloc_floats(m + 1);
+	if (!t->bitrev || !t->tw_re || !t->tw_im || !t->rt_re || !t->rt_im)
+		return -ENOMEM;
+
+	for (unsigned int n = 0; n < m; n++) {
+		unsigned int r = 0;
+		for (unsigned int b = 0; b < log2m; b++)
+			r |= ((n >> b) & 1) << (log2m - 1 - b);
+		t->bitrev[n] = r;
+	}
+	for (unsigned int h = 1; h < m; h <<= 1) {
+		for (unsigned int j = 0; j < h; j++) {
+			t->tw_re[h + j] = cos(M_PI * j / h);
+			t->tw_im[h + j] = -sin(M_PI * j / h);
+		}
+	}
+	for (unsigned int k = 0; k <= m; k++) {
+		t->rt_re[k] = cos(M_PI * k / m);
+		t->rt_im[k] = -sin(M_PI * k / m);
+	}
+	return 0;
+}
+
+static void fft_free(struct fft_tables *t)
+{
+	free(t->bitrev);
+	free(t->tw_re);
+	free(t->tw_im);
+	free(t->rt_re);
+	free(t->rt_im);
+}
+
+// In-place radix-2 butterflies on bit-reversed input. With (xi, xr) swapped, this is the inverse FFT.
+static void fft_butterflies(float *xr, float *xi, const struct fft_tables *t)
+{
+	const unsigned int m = t->m;
+	for (unsigned int h = 1; h < m; h <<= 1) {
+		const float *wr = t->tw_re + h;
+		const float *wi = t->tw_im + h;
+		for (unsigned int g = 0; g < m; g += 2 * h) {
+			float *ar = xr + g, *ai = xi + g;
+			float *br = xr + g + h, *bi = xi + g + h;
+			unsigned int j = 0;
+#ifdef HAVE_VF
+			for (; h >= 4 && j < h; j += 4) {
+				vf vwr = VF_LOAD(wr + j), vwi = VF_LOAD(wi + j);
+				vf vbr = VF_LOAD(br + j), vbi = VF_LOAD(bi + j);
+				vf tr = VF_MLS(VF_MUL(vbr, vwr), vbi, vwi);
+				vf ti = VF_MLA(VF_MUL(vbr, vwi), vbi, vwr);
+				vf var = VF_LOAD(ar + j), vai = VF_LOAD(ai + j);
+				VF_STORE(br + j, VF_SUB(var, tr));
+				VF_STORE(bi + j, VF_SUB(vai, ti));
+				VF_STORE(ar + j, VF_ADD(var, tr));
+				VF_STORE(ai + j, VF_ADD(vai, ti));
+			}
+#endif
+			for (; j < h; j++) {
+				float tr = br[j] * wr[j] - bi[j] * wi[j];
+				float ti = br[j] * wi[j] + bi[j] * wr[j];
+				br[j] = ar[j] - tr;
+				bi[j] = ai[j] - ti;
+				ar[j] += tr;
+				ai[j] += ti;
+			}
+		}
+	}
+}
+
+// Spectrum of the 2m real samples, the first m in 'x0' and the next m in 'x1', into bins [0, m] of (sr, si)
+static void fft_real_forward(const struct fft_tables *t, const float *x0, const float *x1,
+                             float *zr, float *zi, float *sr, float *si)
+{
+	const unsigned int m = t->m;
+	for (unsigned int n = 0; n < m; n++) {
+		const float *x = (n < m / 2) ? x0 + 2 * n : x1 + 2 * n - m;
+		zr[t->bitrev[n]] = x[0];
+		zi[t->bitrev[n]] = x[1];
+	}
+	fft_butterflies(zr, zi, t);
+
+	// split the even and odd samples' spectra, with Z[m] = Z[0]
+	for (unsigned int k = 0; k <= m; k++) {
+		const unsigned int a = (k == m) ? 0 : k;
+		const unsigned int b = (k == 0) ? 0 : m - k;
+		const float fer = 0.5f * (zr[a] + zr[b]), fei = 0.5f * (zi[a] - zi[b]);
+		const float dr = 0.5f * (zr[a] - zr[b]), di = 0.5f * (zi[a] + zi[b]);
+		// odd spectrum: -i * d
+		const float forr = di, foi = -dr;
+		sr[k] = fer + t->rt_re[k] * forr - t->rt_im[k] * foi;
+		si[k] = fei + t->rt_re[k] * foi + t->rt_im[k] * forr;
+	}
+}
+
+// The 2m real samples of spectrum bins [0, m] of (sr, si), times m
+static void fft_real_inverse(const struct fft_tables *t, const float *sr, const float *si, float *zr, float *zi)
+{
+	const unsigned int m = t->m;
+	for (unsigned int k = 0; k < m; k++) {
+		const unsigned int b = m - k;
+		const float fer = 0.5f * (sr[k] + sr[b]), fei = 0.5f * (si[k] - si[b]);
+		const float dr = 0.5f * (sr[k] - sr[b]), di = 0.5f * (si[k] + si[b]);
+		// odd spectrum: d * conj(W^k)
+		const float forr = dr * t->rt_re[k] + di * t->rt_im[k];
+		const float foi = di * t->rt_re[k] - dr * t->rt_im[k];
+		zr[t->bitrev[k]] = fer - foi;
+		zi[t->bitrev[k]] = fei + forr;
+	}
+	fft_butterflies(zi, zr, t);
+}
+
+// acc += s * h, complex, over 'bins' (a multiple of 4)
+static void spectrum_mac(float *acc_re, float *acc_im, const float *s_re, const float *s_im,
+                         const float *h_re, const float *h_im, unsigned int bins)
+{
+	unsigned int k = 0;
+#ifdef HAVE_VF
+	for (; k < bins; k += 4) {
+		vf sr = VF_LOAD(s_re + k), si = VF_LOAD(s_im + k);
+		vf hr = VF_LOAD(h_re + k), hi = VF_LOAD(h_im + k);
+		vf ar = VF_LOAD(acc_re + k), ai = VF_LOAD(acc_im + k);
+		ar = VF_MLS(VF_MLA(ar, sr, hr), si, hi);
+		ai = VF_MLA(VF_MLA(ai, sr, hi), si, hr);
+		VF_STORE(acc_re + k, ar);
+		VF_STORE(acc_im + k, ai);
+	}
+#endif
+	for (; k < bins; k++) {
+		acc_re[k] += s_re[k] * h_re[k] - s_im[k] * h_im[k];
+		acc_im[k] += s_re[k] * h_im[k] + s_im[k] * h_re[k];
+	}
+}
+
+static void run_channel(struct dacxo_convolver *conv, struct conv_channel *ch)
+{
+	const unsigned int b = conv->partition;
+	const unsigned int m = conv->fft.m;
+	const size_t bins = conv->bins;
+
+	// overlap-save: the spectrum of the previous and the current block, into the newest delay line slot
+	fft_real_forward(&conv->fft, ch->prev, ch->in, ch->zr, ch->zi,
+	                 ch->fdl_re + ch->head * bins, ch->fdl_im + ch->head * bins);
+
+	memset(ch->acc_re, 0, bins * sizeof(float));
+	memset(ch->acc_im, 0, bins * sizeof(float));
+	for (unsigned int p = 0; p < conv->parts; p++) {
+		const unsigned int slot = (ch->head + conv->parts - p) % conv->parts;
+		spectrum_mac(ch->acc_re, ch->acc_im, ch->fdl_re + slot * bins, ch->fdl_im + slot * bins,
+		             ch->filt_re + p * bins, ch->filt_im + p * bins, bins);
+	}
+
+	fft_real_inverse(&conv->fft, ch->acc_re, ch->acc_im, ch->zr, ch->zi);
+	// the second half is the valid output of overlap-save
+	for (unsigned int n = m / 2; n < m; n++) {
+		ch->out[2 * n - b] = ch->zr[n];
+		ch->out[2 * n + 1 - b] = ch->zi[n];
+	}
+
+	ch->head = (ch->head + 1) % conv->parts;
+	memcpy(ch->prev, ch->in, b * sizeof(float));
+}
+
+static void *worker(void *arg)
+{
+	struct dacxo_convolver *conv = arg;
+	unsigned int index;
+	unsigned int seen = 0;
+
+	pthread_mutex_lock(&conv->lock);
+	// the thread index: the number of threads started before this one
+	for (index = 1; index < conv->threads && !pthread_equal(conv->tid[index], pthread_self()); index++)
+		;
+	for (;;) {
+		while (conv->generation == seen && !conv->quit)
+			pthread_cond_wait(&conv->start_cond, &conv->lock);
+		if (conv->quit)
+			break;
+		seen = conv->generation;
+		pthread_mutex_unlock(&conv->lock);
+
+		for (unsigned int c = index; c < conv->channels; c += conv->threads)
+			run_channel(conv, &conv->ch[c]);
+
+		pthread_mutex_lock(&conv->lock);
+		if (--conv->pending == 0)
+			pthread_cond_signal(&conv->done_cond);
+	}
+	pthread_mutex_unlock(&conv->lock);
+	return NULL;
+}
+
+void dacxo_convolve_run(struct dacxo_convolver *conv)
+{
+	if (conv->threads > 1) {
+		pthread_mutex_lock(&conv->lock);
+		conv->generation++;
+		conv->pending = conv->threads - 1;
+		pthread_cond_broadcast(&conv->start_cond);
+		pthread_mutex_unlock(&conv->lock);
+	}
+
+	for (unsigned int c = 0; c < conv->channels; c += conv->threads)
+		run_channel(conv, &conv->ch[c]);
+
+	if (conv->threads > 1) {
+		pthread_mutex_lock(&conv->lock);
+		while (conv->pending)
+			pthread_cond_wait(&conv->done_cond, &conv->lock);
+		pthread_mutex_unlock(&conv->lock);
+	}
+}
+
+// The spectra of the filter partitions, scaled by 1/m for the inverse FFT
+static void prepare_filter(struct dacxo_convolver *conv, struct conv_channel *ch, const float *h, size_t taps)
+{
+	const unsigned int b = conv->partition;
+	float *x = alloc_floats(2 * b);
+	if (!x)
+		return;
+	for (unsigned int p = 0; p < conv->parts; p++) {
+		float *sr = ch->filt_re + p * conv->bins, *si = ch->filt_im + p * conv->bins;
+		size_t n = (taps > (size_t)p * b) ? taps - (size_t)p * b : 0;
+		if (n > b)
+			n = b;
+		memset(x, 0, 2 * b * sizeof(float));
+		for (size_t i = 0; i < n; i++)
+			x[i] = h[(size_t)p * b + i] / conv->fft.m;
+		fft_real_forward(&conv->fft, x, x + b, ch->zr, ch->zi, sr, si);
+	}
+	free(x);
+}
+
+struct dacxo_convolver *dacxo_convolve_create(unsigned int channels, unsigned int partition,
+                                              const float *const *filters, const size_t *taps,
+                                              unsigned int threads)
+{
+	if (!channels || channels > DACXO_CONV_CHANNELS_MAX ||
+	    partition < DACXO_CONV_PARTITION_MIN || partition > DACXO_CONV_PARTITION_MAX ||
+	    (partition & (partition - 1)))
+		return NULL;
+
+	size_t max_taps = 1;
+	for (unsigned int c = 0; c < channels; c++) {
+		if (taps[c] > DACXO_CONV_TAPS_MAX)
+			return NULL;
+		if (taps[c] > max_taps)
+			max_taps = taps[c];
+	}
+
+	struct dacxo_convolver *conv = calloc(1, sizeof(*conv));
+	if (!conv)
+		return NULL;
+	conv->channels = channels;
+	conv->partition = partition;
+	conv->bins = partition + 4;  // m + 1 bins, with m = partition
+	conv->parts = (max_taps + partition - 1) / partition;
+	conv->threads = 1;
+
+	bool ok = fft_init(&conv->fft, partition) == 0;
+	const size_t spectra = (size_t)conv->parts * conv->bins;
+	for (unsigned int c = 0; ok && c < channels; c++) {
+		struct conv_channel *ch = &conv->ch[c];
+		ch->in = alloc_floats(partition);
+		ch->prev = alloc_floats(partition);
+		ch->out = alloc_floats(partition);
+		ch->zr = alloc_floats(partition);
+		ch->zi = alloc_floats(partition);
+		ch->fdl_re = alloc_floats(spectra);
+		ch->fdl_im = alloc_floats(spectra);
+		ch->filt_re = alloc_floats(spectra);
+		ch->filt_im = alloc_floats(spectra);
+		ch->acc_re = alloc_floats(conv->bins);
+		ch->acc_im = alloc_floats(conv->bins);
+		ok = ch->in && ch->prev && ch->out && ch->zr && ch->zi && ch->fdl_re && ch->fdl_im &&
+		     ch->filt_re && ch->filt_im && ch->acc_re && ch->acc_im;
+		if (ok)
+			prepare_filter(conv, ch, filters[c], taps[c]);
+	}
+	if (!ok) {
+		dacxo_convolve_destroy(conv);
+		return NULL;
+	}
+
+	if (threads > channels)
+		threads = channels;
+	if (threads > 1) {
+		pthread_mutex_init(&conv->lock, NULL);
+		pthread_cond_init(&conv->start_cond, NULL);
+		pthread_cond_init(&conv->done_cond, NULL);
+		pthread_mutex_lock(&conv->lock);  // the workers find their index after all got created
+		conv->threads = threads;
+		for (unsigned int t = 1; t < threads; t++) {
+			if (pthread_create(&conv->tid[t], NULL, worker, conv) != 0) {
+				conv->threads = t;  // run with the ones that did start
+				break;
+			}
+		}
+		pthread_mutex_unlock(&conv->lock);
+	}
+	return conv;
+}
+
+void dacxo_convolve_destroy(struct dacxo_convolver *conv)
+{
+	if (!conv)
+		return;
+	if (conv->threads > 1) {
+		pthread_mutex_lock(&conv->lock);
+		conv->quit = true;
+		pthread_cond_broadcast(&conv->start_cond);
+		pthread_mutex_unlock(&conv->lock);
+		for (unsigned int t = 1; t < conv->threads; t++)
+			pthread_join(conv->tid[t], NULL);
+		pthread_mutex_destroy(&conv->lock);
+		pthread_cond_destroy(&conv->start_cond);
+		pthread_cond_destroy(&conv->done_cond);
+	}
+	for (unsigned int c = 0; c < conv->channels; c++) {
+		struct conv_channel *ch = &conv->ch[c];
+		free(ch->in);
+		free(ch->prev);
+		free(ch->out);
+		free(ch->zr);
+		free(ch->zi);
+		free(ch->fdl_re);
+		free(ch->fdl_im);
+		free(ch->filt_re);
+		free(ch->filt_im);
+		free(ch->acc_re);
+		free(ch->acc_im);
+	}
+	fft_free(&conv->fft);
+	free(conv);
+}
+
+void dacxo_convolve_reset(struct dacxo_convolver *conv)
+{
+	const size_t spectra = (size_t)conv->parts * conv->bins;
+	for (unsigned int c = 0; c < conv->channels; c++) {
+		struct conv_channel *ch = &conv->ch[c];
+		memset(ch->in, 0, conv->partition * sizeof(float));
+		memset(ch->prev, 0, conv->partition * sizeof(float));
+		memset(ch->out, 0, conv->partition * sizeof(float));
+		memset(ch->fdl_re, 0, spectra * sizeof(float));
+		memset(ch->fdl_im, 0, spectra * sizeof(float));
+		ch->head = 0;
+	}
+}
+
+float *dacxo_convolve_input(struct dacxo_convolver *conv, unsigned int channel)
+{
+	return conv->ch[channel].in;
+}
+
+const float *dacxo_convolve_output(const struct dacxo_convolver *conv, unsigned int channel)
+{
+	return conv->ch[channel].out;
+}
+
+unsigned int dacxo_convolve_partition(const struct dacxo_convolver *conv)
+{
+	return conv->partition;
+}
+
+unsigned int dacxo_convolve_threads(const struct dacxo_convolver *conv)
+{
+	return conv->threads;
+}
+
+long dacxo_convolve_load_filter(const char *path, float **filter)
+{
+	FILE *f = fopen(path, "rb");
+	if (!f)
+		return -errno;
+
+	long taps = -EINVAL;
+	if (fseek(f, 0, SEEK_END) == 0) {
+		long bytes = ftell(f);
+		if (bytes > 0 && bytes % sizeof(float) == 0 && bytes / sizeof(float) <= DACXO_CONV_TAPS_MAX)
+			taps = bytes / sizeof(float);
+	}
+	if (taps > 0) {
+		// the Pi and x86 are little-endian, as the file
+		*filter = malloc(taps * sizeof(float));
+		if (!*filter)
+			taps = -ENOMEM;
+		else if (fseek(f, 0, SEEK_SET) != 0 || fread(*filter, sizeof(float), taps, f) != (size_t)taps) {
+			free(*filter);
+			*filter = NULL;
+			taps = -EIO;
+		}
+	}
+	fclose(f);
+	return taps;
+}
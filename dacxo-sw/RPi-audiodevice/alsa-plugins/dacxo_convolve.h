@@ -0,0 +1,56 @@
+/*
+ * Uniformly partitioned FFT convolution engine of the 'dacxo_conv' ALSA plugin
+ *
+ * Copyright 2016 Jos van Eijndhoven
+ * jos@vaneijndhoven.net
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ */
+
+#ifndef _DACXO_CONVOLVE_H
+#define _DACXO_CONVOLVE_H
+
+#include <stddef.h>
+
+// Partition size in frames: a power of two in this range. It is also the latency of the engine.
+#define DACXO_CONV_PARTITION_MIN     64
+#define DACXO_CONV_PARTITION_MAX     16384
+#define DACXO_CONV_PARTITION_DEFAULT 1024
+
+#define DACXO_CONV_TAPS_MAX  (256 * 1024)
+#define DACXO_CONV_CHANNELS_MAX 8
+
+// Name of the kernel variant that got compiled in: "neon", "sse" or "scalar"
+extern const char *const dacxo_convolve_isa;
+
+struct dacxo_convolver;
+
+// Setup for 'channels' channels, each with its own FIR filter of 'taps[c]' coefficients.
+// The channels are spread over 'threads' threads (including the caller of dacxo_convolve_run()),
+// at most one per channel.
+// @return The engine, or NULL on an invalid argument or out of memory
+struct dacxo_convolver *dacxo_convolve_create(unsigned int channels, unsigned int partition,
+                                              const float *const *filters, const size_t *taps,
+                                              unsigned int threads);
+void dacxo_convolve_destroy(struct dacxo_convolver *conv);
+
+// Back to silence in the input history and the output
+void dacxo_convolve_reset(struct dacxo_convolver *conv);
+
+// The block buffers of 'partition' frames per channel: fill the inputs, run,
+// and find the filtered block in the outputs until the next run.
+float *dacxo_convolve_input(struct dacxo_convolver *conv, unsigned int channel);
+const float *dacxo_convolve_output(const struct dacxo_convolver *conv, unsigned int channel);
+void dacxo_convolve_run(struct dacxo_convolver *conv);
+
+unsigned int dacxo_convolve_partition(const struct dacxo_convolver *conv);
+unsigned int dacxo_convolve_threads(const struct dacxo_convolver *conv);
+
+// Read a filter of raw 32-bit float little-endian samples, as exported by most room correction tools.
+// @return The number of taps, or a negative errno. '*filter' is to be freed by the caller.
+long dacxo_convolve_load_filter(const char *path, float **filter);
+
+#endif /* _DACXO_CONVOLVE_H */
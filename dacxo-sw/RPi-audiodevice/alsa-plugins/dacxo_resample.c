@@ -0,0 +1,310 @@
+/*
+ * Polyphase sample rate converter of the 'dacxo' ALSA rate plugin
+ *
+ * A Kaiser windowed sinc filter in DACXO_RESAMPLE_PHASES phases, with linear interpolation
+ * between two adjacent phases for the positions in between. The samples are processed in float,
+ * which keeps the 24-bit resolution of the dac.
+ *
+ * Copyright 2016 Jos van Eijndhoven
+ * jos@vaneijndhoven.net
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ */
+
+#include <errno.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "dacxo_resample.h"
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+const char *const dacxo_resample_isa = "neon";
+#elif defined(__SSE__)
+#include <xmmintrin.h>
+const char *const dacxo_resample_isa = "sse";
+#else
+const char *const dacxo_resample_isa = "scalar";
+#endif
+
+// Stopband attenuation in dB, sets the Kaiser window shape and the transition width
+#define STOPBAND_DB 90.0
+
+void dacxo_dot2_scalar(const float *x, const float *c0, const float *c1, unsigned int n, float *a, float *b)
+{
+	float sa = 0.0f, sb = 0.0f;
+	for (unsigned int i = 0; i < n; i++) {
+		sa += x[i] * c0[i];
+		sb += x[i] * c1[i];
+	}
+	*a = sa;
+	*b = sb;
+}
+
+#if defined(__ARM_NEON)
+
+static inline float hsum(float32x4_t v)
+{
+	float32x2_t s = vadd_f32(vget_low_f32(v), vget_high_f32(v));
+	return vget_lane_f32(vpadd_f32(s, s), 0);
+}
+
+void dacxo_dot2(const float *x, const float *c0, const float *c1, unsigned int n, float *a, float *b)
+{
+	// two accumulators per phase, to hide the multiply-accumulate latency
+	float32x4_t a0 = vdupq_n_f32(0.0f), a1 = a0, b0 = a0, b1 = a0;
+	for (unsigned int i = 0; i < n; i += 8) {
+		float32x4_t x0 = vld1q_f32(x + i);
+		float32x4_t x1 = vld1q_f32(x + i + 4);
+		a0 = vmlaq_f32(a0, x0, vld1q_f32(c0 + i));
+		a1 = vmlaq_f32(a1, x1, vld1q_f32(c0 + i + 4));
+		b0 = vmlaq_f32(b0, x0, vld1q_f32(c1 + i));
+		b1 = vmlaq_f32(b1, x1, vld1q_f32(c1 + i + 4));
+	}
+	*a = hsum(vaddq_f32(a0, a1));
+	*b = hsum(vaddq_f32(b0, b1));
+}
+
+#elif defined(__SSE__)
+
+static inline float hsum(__m128 v)
+{
+	v = _mm_add_ps(v, _mm_movehl_ps(v, v));
+	v = _mm_add_ss(v, _mm_shuffle_ps(v, v, 1));
+	return _mm_cvtss_f32(v);
+}
+
+void dacxo_dot2(const float *x, const float *c0, const float *c1, unsigned int n, float *a, float *b)
+{
+	__m128 a0 = _mm_setzero_ps(), a1 = a0, b0 = a0, b1 = a0;
+	for (unsigned int i = 0; i < n; i += 8) {
+		__m128 x0 = _mm_loadu_ps(x + i);
+		__m128 x1 = _mm_loadu_ps(x + i + 4);
+		a0 = _mm_add_ps(a0, _mm_mul_ps(x0, _mm_loadu_ps(c0 + i)));
+		a1 = _mm_add_ps(a1, _mm_mul_ps(x1, _mm_loadu_ps(c0 + i + 4)));
+		b0 = _mm_add_ps(b0, _mm_mul_ps(x0, _mm_loadu_ps(c1 + i)));
+		b1 = _mm_add_ps(b1, _mm_mul_ps(x1, _mm_loadu_ps(c1 + i + 4)));
+	}
+	*a = hsum(_mm_add_ps(a0, a1));
+	*b = hsum(_mm_add_ps(b0, b1));
+}
+
+#else
+
+void dacxo_dot2(const float *x, const float *c0, const float *c1, unsigned int n, float *a, float *b)
+{
+	dacxo_dot2_scalar(x, c0, c1, n, a, b);
+}
+
+#endif
+
+// Modified Bessel function of the first kind, order 0, for the Kaiser window
+static double bessel_i0(double x)
+{
+	double sum = 1.0, term = 1.0;
+	for (int k = 1; k < 50 && term > 1e-12 * sum; k++) {
+		term *= (x / (2 * k)) * (x / (2 * k));
+		sum += term;
+	}
+	return sum;
+}
+
+// Fill the phase rows: row p holds the filter at a position p/PHASES input frames after the
+// window centre. 'scale' is the ratio of the lower rate to the input rate.
+static void design_filter(float *coefs, unsigned int taps, double scale)
+{
+	const double beta = 0.1102 * (STOPBAND_DB - 8.7);
+	const double half = taps / 2.0;
+	// transition width of the Kaiser window in input frames, ending at the Nyquist frequency of the lower rate
+	const double transition = (STOPBAND_DB - 8.0) / (2.285 * 2.0 * M_PI * (taps - 1));
+	const double fc = 0.5 * scale - transition / 2.0;  // cutoff, in cycles per input frame
+	const double i0_beta = bessel_i0(beta);
+
+	for (unsigned int p = 0; p <= DACXO_RESAMPLE_PHASES; p++) {
+		float *row = coefs + (size_t)p * taps;
+		const double mu = (double)p / DACXO_RESAMPLE_PHASES;
+		double sum = 0.0;
+		for (unsigned int j = 0; j < taps; j++) {
+			const double t = j - half + 1.0 - mu;
+			const double x = t / half;
+			const double w = (x * x < 1.0) ? bessel_i0(beta * sqrt(1.0 - x * x)) / i0_beta : 0.0;
+			const double sinc = (t == 0.0) ? 1.0 : sin(2.0 * M_PI * fc * t) / (2.0 * M_PI * fc * t);
+			const double h = 2.0 * fc * sinc * w;
+			row[j] = h;
+			sum += h;
+		}
+		// unity gain in each phase, against a ripple at the phase rate
+		for (unsigned int j = 0; j < taps; j++)
+			row[j] /= sum;
+	}
+}
+
+static unsigned int gcd(unsigned int a, unsigned int b)
+{
+	while (b) {
+		unsigned int t = a % b;
+		a = b;
+		b = t;
+	}
+	return a;
+}
+
+void dacxo_resample_set_step(struct dacxo_resampler *rs, unsigned int in_period, unsigned int out_period)
+{
+	const unsigned int g = gcd(in_period, out_period);
+	rs->in_step = in_period / g;
+	rs->out_step = out_period / g;
+	rs->frac = 0;
+}
+
+void dacxo_resample_reset(struct dacxo_resampler *rs)
+{
+	// taps - 1 frames of silence: the first output window is then complete
+	memset(rs->hist, 0, rs->channels * rs->capacity * sizeof(float));
+	rs->fill = rs->taps - 1;
+	rs->frac = 0;
+}
+
+int dacxo_resample_init(struct dacxo_resampler *rs, unsigned int channels,
+                        unsigned int in_rate, unsigned int out_rate,
+                        unsigned int in_period, unsigned int out_period,
+                        size_t max_chunk, unsigned int taps)
+{
+	memset(rs, 0, sizeof(*rs));
+	if (!channels || !in_rate || !out_rate || !in_period || !out_period)
+		return -EINVAL;
+
+	const double scale = (out_rate < in_rate) ? (double)out_rate / in_rate : 1.0;
+	if (!taps)
+		taps = DACXO_RESAMPLE_TAPS_DEFAULT;
+	taps = (unsigned int)ceil(taps / scale);
+	taps = (taps + 7) & ~7u;
+	if (taps > DACXO_RESAMPLE_TAPS_MAX)
+		taps = DACXO_RESAMPLE_TAPS_MAX;
+
+	rs->channels = channels;
+	rs->taps = taps;
+	rs->capacity = taps - 1 + max_chunk;
+	rs->coefs = malloc((size_t)(DACXO_RESAMPLE_PHASES + 1) * taps * sizeof(float));
+	rs->hist = malloc(channels * rs->capacity * sizeof(float));
+	if (!rs->coefs || !rs->hist) {
+		dacxo_resample_free(rs);
+		return -ENOMEM;
+	}
+	design_filter(rs->coefs, taps, scale);
+	dacxo_resample_set_step(rs, in_period, out_period);
+	dacxo_resample_reset(rs);
+	return 0;
+}
+
+void dacxo_resample_free(struct dacxo_resampler *rs)
+{
+	free(rs->coefs);
+	free(rs->hist);
+	rs->coefs = NULL;
+	rs->hist = NULL;
+}
+
+size_t dacxo_resample_in_frames(const struct dacxo_resampler *rs, size_t out_frames)
+{
+	return (out_frames * rs->in_step + rs->out_step / 2) / rs->out_step;
+}
+
+size_t dacxo_resample_out_frames(const struct dacxo_resampler *rs, size_t in_frames)
+{
+	return (in_frames * rs->out_step + rs->in_step / 2) / rs->in_step;
+}
+
+// Append interleaved input to the per-channel history, as float in [-1, 1)
+static void push_input(struct dacxo_resampler *rs, const void *src, size_t in_frames, int is_s16)
+{
+	if (in_frames > rs->capacity - rs->fill)
+		in_frames = rs->capacity - rs->fill;  // larger than announced: the excess is dropped
+	for (unsigned int c = 0; c < rs->channels; c++) {
+		float *h = rs->hist + c * rs->capacity + rs->fill;
+		if (is_s16) {
+			const int16_t *s = (const int16_t *)src + c;
+			for (size_t i = 0; i < in_frames; i++, s += rs->channels)
+				h[i] = *s * (1.0f / 32768.0f);
+		} else {
+			const int32_t *s = (const int32_t *)src + c;
+			for (size_t i = 0; i < in_frames; i++, s += rs->channels)
+				h[i] = *s * (1.0f / 2147483648.0f);
+		}
+	}
+	rs->fill += in_frames;
+}
+
+static inline int32_t to_s32(float y)
+{
+	if (y >= 1.0f)
+		return INT32_MAX;
+	if (y <= -1.0f)
+		return INT32_MIN;
+	return (int32_t)lrintf(y * 2147483648.0f);
+}
+
+static inline int16_t to_s16(float y)
+{
+	long v = lrintf(y * 32768.0f);
+	return (v > INT16_MAX) ? INT16_MAX : (v < INT16_MIN) ? INT16_MIN : (int16_t)v;
+}
+
+// Filter the output frames from the history, and drop the consumed input frames from it
+static void produce_output(struct dacxo_resampler *rs, void *dst, size_t out_frames, int is_s16)
+{
+	const unsigned int taps = rs->taps;
+	const unsigned int channels = rs->channels;
+	size_t start = 0;  // of the filter window in the history
+	unsigned int frac = rs->frac;
+	size_t k = 0;
+
+	for (; k < out_frames && start + taps <= rs->fill; k++) {
+		const uint64_t pos = (uint64_t)frac * DACXO_RESAMPLE_PHASES;
+		const unsigned int p = pos / rs->out_step;
+		const float t = (float)(pos % rs->out_step) / rs->out_step;
+		const float *c0 = rs->coefs + (size_t)p * taps;
+
+		for (unsigned int c = 0; c < channels; c++) {
+			float a, b;
+			dacxo_dot2(rs->hist + c * rs->capacity + start, c0, c0 + taps, taps, &a, &b);
+			const float y = a + t * (b - a);
+			if (is_s16)
+				((int16_t *)dst)[k * channels + c] = to_s16(y);
+			else
+				((int32_t *)dst)[k * channels + c] = to_s32(y);
+		}
+		frac += rs->in_step;
+		start += frac / rs->out_step;
+		frac %= rs->out_step;
+	}
+	// input ran short of the step: silence
+	if (k < out_frames)
+		memset((char *)dst + k * channels * (is_s16 ? 2 : 4), 0, (out_frames - k) * channels * (is_s16 ? 2 : 4));
+
+	if (start > rs->fill)
+		start = rs->fill;
+	for (unsigned int c = 0; c < channels; c++) {
+		float *h = rs->hist + c * rs->capacity;
+		memmove(h, h + start, (rs->fill - start) * sizeof(float));
+	}
+	rs->fill -= start;
+	rs->frac = frac;
+}
+
+void dacxo_resample_s32(struct dacxo_resampler *rs, int32_t *dst, size_t out_frames,
+                        const int32_t *src, size_t in_frames)
+{
+	push_input(rs, src, in_frames, 0);
+	produce_output(rs, dst, out_frames, 0);
+}
+
+void dacxo_resample_s16(struct dacxo_resampler *rs, int16_t *dst, size_t out_frames,
+                        const int16_t *src, size_t in_frames)
+{
+	push_input(rs, src, in_frames, 1);
+	produce_output(rs, dst, out_frames, 1);
+}
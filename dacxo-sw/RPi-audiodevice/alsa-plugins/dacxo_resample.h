@@ -0,0 +1,73 @@
+/*
+ * Polyphase sample rate converter of the 'dacxo' ALSA rate plugin
+ *
+ * Copyright 2016 Jos van Eijndhoven
+ * jos@vaneijndhoven.net
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ */
+
+#ifndef _DACXO_RESAMPLE_H
+#define _DACXO_RESAMPLE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Filter phases per input sample, the coefficients in between are interpolated linearly
+#define DACXO_RESAMPLE_PHASES 256
+
+// Taps per phase when upsampling: 64 gives a passband up to 0.41 of the lower of both rates,
+// with -90dB from its Nyquist frequency on. The taps scale with the downsampling ratio.
+#define DACXO_RESAMPLE_TAPS_DEFAULT 64
+#define DACXO_RESAMPLE_TAPS_MAX     256
+
+// Name of the filter kernel variant that got compiled in: "neon", "sse" or "scalar"
+extern const char *const dacxo_resample_isa;
+
+struct dacxo_resampler {
+	unsigned int channels;
+	unsigned int in_step;   // each output frame advances in_step / out_step input frames
+	unsigned int out_step;
+	unsigned int taps;      // per phase, a multiple of 8
+	float *coefs;           // (DACXO_RESAMPLE_PHASES + 1) rows of 'taps'
+	float *hist;            // per channel 'capacity' input frames, oldest first
+	size_t capacity;
+	size_t fill;            // input frames in 'hist'
+	unsigned int frac;      // position of the next output frame between two input frames, in 1/out_step
+};
+
+// Setup for a conversion from 'in_rate' to 'out_rate'. The step is the ratio of the period sizes,
+// such that each period of 'in_period' frames gives exactly 'out_period' frames.
+// 'max_chunk' is the largest number of input frames per call. 'taps' 0 selects the default.
+// @return 0 on success, or a negative errno
+int dacxo_resample_init(struct dacxo_resampler *rs, unsigned int channels,
+                        unsigned int in_rate, unsigned int out_rate,
+                        unsigned int in_period, unsigned int out_period,
+                        size_t max_chunk, unsigned int taps);
+void dacxo_resample_free(struct dacxo_resampler *rs);
+
+// Change the step only, keeping the filter and the history
+void dacxo_resample_set_step(struct dacxo_resampler *rs, unsigned int in_period, unsigned int out_period);
+
+// Back to silence in the history, as after init
+void dacxo_resample_reset(struct dacxo_resampler *rs);
+
+// Number of input frames for 'out_frames' output frames at the current step, rounded
+size_t dacxo_resample_in_frames(const struct dacxo_resampler *rs, size_t out_frames);
+size_t dacxo_resample_out_frames(const struct dacxo_resampler *rs, size_t in_frames);
+
+// Convert interleaved frames. When 'in_frames' runs short of the step, the missing output is silent.
+void dacxo_resample_s32(struct dacxo_resampler *rs, int32_t *dst, size_t out_frames,
+                        const int32_t *src, size_t in_frames);
+void dacxo_resample_s16(struct dacxo_resampler *rs, int16_t *dst, size_t out_frames,
+                        const int16_t *src, size_t in_frames);
+
+// The filter kernel: dot products of 'x' with the two adjacent phases 'c0' and 'c1', 'n' a multiple of 8
+void dacxo_dot2(const float *x, const float *c0, const float *c1, unsigned int n, float *a, float *b);
+// Scalar reference of the above, for verification
+void dacxo_dot2_scalar(const float *x, const float *c0, const float *c1, unsigned int n, float *a, float *b);
+
+#endif /* _DACXO_RESAMPLE_H */
@@ -0,0 +1,128 @@
+/*
+ * Benchmark of the polyphase rate converter of the 'dacxo' ALSA rate plugin,
+ * for the conversions of the rates outside DACXO_RATES to the card rates.
+ * Reported per conversion, for stereo S32_LE in periods of 20ms:
+ * - the throughput in million output samples per second per core
+ * - the cpu time as percentage of the audio duration
+ * - the signal to noise ratio of a -1dBFS 1kHz sine, against the exact sine at the output rate
+ *
+ * Copyright 2016 Jos van Eijndhoven
+ * jos@vaneijndhoven.net
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "dacxo_resample.h"
+
+#define CHANNELS      2
+#define PERIODS_PER_S 50
+#define AUDIO_SECONDS 10   // per conversion
+#define TONE_HZ       1000.0
+#define TONE_AMPL     0.89 // -1dBFS
+
+struct conversion {
+	unsigned int in_rate;
+	unsigned int out_rate;
+	const char *comment;
+};
+
+static const struct conversion conversions[] = {
+	{  22050,  44100, "nearest" },
+	{  32000,  44100, "nearest" },
+	{  32000,  48000, "48kHz family" },
+	{  44100,  48000, "48kHz family" },
+	{  48000,  44100, "44.1kHz family" },
+	{  88200,  96000, "48kHz family" },
+	{ 352800, 176400, "44.1kHz family" },
+	{ 352800, 192000, "nearest" },
+	{ 384000, 192000, "nearest" },
+};
+
+static double cpu_seconds(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void bench(const struct conversion *conv)
+{
+	const unsigned int in_period = conv->in_rate / PERIODS_PER_S;
+	const unsigned int out_period = conv->out_rate / PERIODS_PER_S;
+	const unsigned int periods = PERIODS_PER_S * AUDIO_SECONDS;
+	struct dacxo_resampler rs;
+
+	int32_t *in = malloc((size_t)in_period * periods * CHANNELS * sizeof(int32_t));
+	int32_t *out = malloc((size_t)out_period * periods * CHANNELS * sizeof(int32_t));
+	if (!in || !out || dacxo_resample_init(&rs, CHANNELS, conv->in_rate, conv->out_rate,
+	                                       in_period, out_period, in_period, 0) < 0) {
+		fprintf(stderr, "out of memory\n");
+		exit(1);
+	}
+	for (size_t i = 0; i < (size_t)in_period * periods; i++) {
+		double v = TONE_AMPL * sin(2.0 * M_PI * TONE_HZ * i / conv->in_rate);
+		for (unsigned int c = 0; c < CHANNELS; c++)
+			in[i * CHANNELS + c] = lrint(v * 2147483647.0);
+	}
+
+	int mismatch = 0;
+	double start = cpu_seconds();
+	for (unsigned int p = 0; p < periods; p++) {
+		dacxo_resample_s32(&rs, out + (size_t)p * out_period * CHANNELS, out_period,
+		                   in + (size_t)p * in_period * CHANNELS, in_period);
+		mismatch |= (rs.fill != rs.taps - 1);  // each period consumes its input exactly
+	}
+	double cpu = cpu_seconds() - start;
+
+	// output frame k is at input frame k * in/out - taps/2
+	const double step = (double)conv->in_rate / conv->out_rate;
+	double signal = 0.0, noise = 0.0;
+	for (size_t k = rs.taps; k < (size_t)out_period * periods; k++) {
+		double ref = TONE_AMPL * sin(2.0 * M_PI * TONE_HZ * (k * step - rs.taps / 2.0) / conv->in_rate);
+		double err = out[k * CHANNELS] / 2147483648.0 - ref;
+		signal += ref * ref;
+		noise += err * err;
+	}
+
+	const double samples = (double)out_period * periods * CHANNELS;
+	printf("%7u %7u %5u %10.2f %8.2f%% %8.1fdB %s%s\n", conv->in_rate, conv->out_rate, rs.taps,
+	       samples / cpu * 1e-6, 100.0 * cpu / AUDIO_SECONDS, 10.0 * log10(signal / noise),
+	       conv->comment, mismatch ? ", STEP MISMATCH!" : "");
+
+	dacxo_resample_free(&rs);
+	free(in);
+	free(out);
+}
+
+int main(void)
+{
+	// verify the vectorized kernel against the scalar one
+	float x[DACXO_RESAMPLE_TAPS_MAX], c0[DACXO_RESAMPLE_TAPS_MAX], c1[DACXO_RESAMPLE_TAPS_MAX];
+	for (unsigned int i = 0; i < DACXO_RESAMPLE_TAPS_MAX; i++) {
+		x[i] = rand() / (float)RAND_MAX - 0.5f;
+		c0[i] = rand() / (float)RAND_MAX - 0.5f;
+		c1[i] = rand() / (float)RAND_MAX - 0.5f;
+	}
+	float a, b, ra, rb;
+	dacxo_dot2(x, c0, c1, DACXO_RESAMPLE_TAPS_MAX, &a, &b);
+	dacxo_dot2_scalar(x, c0, c1, DACXO_RESAMPLE_TAPS_MAX, &ra, &rb);
+	if (fabsf(a - ra) > 1e-4f || fabsf(b - rb) > 1e-4f) {
+		fprintf(stderr, "%s kernel mismatch!\n", dacxo_resample_isa);
+		return 1;
+	}
+
+	printf("Polyphase rate conversion, %u channels S32_LE, kernel: %s\n", CHANNELS, dacxo_resample_isa);
+	printf("%7s %7s %5s %10s %9s %10s\n", "in", "out", "taps", "Msample/s", "cpu", "SNR");
+	for (size_t i = 0; i < sizeof(conversions) / sizeof(conversions[0]); i++)
+		bench(&conversions[i]);
+	return 0;
+}
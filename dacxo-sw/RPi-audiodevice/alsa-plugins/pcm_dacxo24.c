@@ -0,0 +1,164 @@
+/*
+ * ALSA external PCM plugin 'dacxo24' for the 5th generation DAC by Jos van Eijndhoven
+ *
+ * The dacxo card accepts S16_LE and S24_LE (24-bit in 32-bit words).
+ * Flac decoders produce the packed S24_3LE format, for which the generic 'plug'
+ * conversion costs a noticeable share of the Pi zero cpu at high sample rates.
+ * This plugin does that conversion with vectorized kernels, see dacxo_convert.c.
+ * S16_LE is widened to S24_LE without loss, S24_LE passes through.
+ *
+ * Usage in asound.conf:
+ *   pcm.dacxo24 {
+ *       type dacxo24
+ *       slave.pcm "dacxo_hw"
+ *   }
+ *
+ * Copyright 2016 Jos van Eijndhoven
+ * jos@vaneijndhoven.net
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <alsa/asoundlib.h>
+#include <alsa/pcm_external.h>
+
+#include "dacxo_convert.h"
+
+typedef struct {
+	snd_pcm_extplug_t ext;
+} snd_pcm_dacxo24_t;
+
+static const unsigned int client_formats[] = {
+	SND_PCM_FORMAT_S24_3LE,
+	SND_PCM_FORMAT_S16_LE,
+	SND_PCM_FORMAT_S24_LE,
+};
+
+// @return The first byte of channel 0 at 'offset', if the areas are interleaved with 'bytes' per sample
+static void *interleaved_addr(const snd_pcm_channel_area_t *areas, unsigned int channels,
+                              unsigned int bytes, snd_pcm_uframes_t offset)
+{
+	for (unsigned int c = 0; c < channels; c++) {
+		if (areas[c].addr != areas[0].addr || areas[c].step != channels * bytes * 8 ||
+		    areas[c].first != areas[0].first + c * bytes * 8)
+			return NULL;
+	}
+	return (char *)areas[0].addr + (areas[0].first + areas[0].step * offset) / 8;
+}
+
+static void convert(snd_pcm_format_t format, int32_t *dst, const void *src, size_t count)
+{
+	switch (format) {
+	case SND_PCM_FORMAT_S24_3LE:
+		dacxo_s24_3le_to_s24_le(dst, src, count);
+		break;
+	case SND_PCM_FORMAT_S16_LE:
+		dacxo_s16_le_to_s24_le(dst, src, count);
+		break;
+	default:
+		memcpy(dst, src, count * sizeof(int32_t));
+		break;
+	}
+}
+
+static snd_pcm_sframes_t dacxo24_transfer(snd_pcm_extplug_t *ext,
+                                          const snd_pcm_channel_area_t *dst_areas,
+                                          snd_pcm_uframes_t dst_offset,
+                                          const snd_pcm_channel_area_t *src_areas,
+                                          snd_pcm_uframes_t src_offset,
+                                          snd_pcm_uframes_t size)
+{
+	const unsigned int src_bytes = snd_pcm_format_physical_width(ext->format) / 8;
+	const void *src = interleaved_addr(src_areas, ext->channels, src_bytes, src_offset);
+	int32_t *dst = interleaved_addr(dst_areas, ext->channels, sizeof(int32_t), dst_offset);
+
+	if (src && dst) {
+		// the common case: all channels in one run
+		convert(ext->format, dst, src, size * ext->channels);
+		return size;
+	}
+
+	// non-interleaved access: convert per channel, sample by sample
+	for (unsigned int c = 0; c < ext->channels; c++) {
+		const char *s = (const char *)src_areas[c].addr + (src_areas[c].first + src_areas[c].step * src_offset) / 8;
+		char *d = (char *)dst_areas[c].addr + (dst_areas[c].first + dst_areas[c].step * dst_offset) / 8;
+		for (snd_pcm_uframes_t i = 0; i < size; i++) {
+			int32_t sample;
+			convert(ext->format, &sample, s, 1);
+			memcpy(d, &sample, sizeof(sample));
+			s += src_areas[c].step / 8;
+			d += dst_areas[c].step / 8;
+		}
+	}
+	return size;
+}
+
+static int dacxo24_close(snd_pcm_extplug_t *ext)
+{
+	free(ext->private_data);
+	return 0;
+}
+
+static const snd_pcm_extplug_callback_t dacxo24_callback = {
+	.transfer = dacxo24_transfer,
+	.close = dacxo24_close,
+};
+
+SND_PCM_PLUGIN_DEFINE_FUNC(dacxo24)
+{
+	snd_config_iterator_t i, next;
+	snd_config_t *sconf = NULL;
+
+	snd_config_for_each(i, next, conf) {
+		snd_config_t *n = snd_config_iterator_entry(i);
+		const char *id;
+		if (snd_config_get_id(n, &id) < 0)
+			continue;
+		if (strcmp(id, "comment") == 0 || strcmp(id, "type") == 0 || strcmp(id, "hint") == 0)
+			continue;
+		if (strcmp(id, "slave") == 0) {
+			sconf = n;
+			continue;
+		}
+		SNDERR("Unknown field %s", id);
+		return -EINVAL;
+	}
+	if (!sconf) {
+		SNDERR("No slave configuration for dacxo24 pcm");
+		return -EINVAL;
+	}
+	if (stream != SND_PCM_STREAM_PLAYBACK) {
+		SNDERR("dacxo24 is a playback-only plugin");
+		return -EINVAL;
+	}
+
+	snd_pcm_dacxo24_t *dacxo = calloc(1, sizeof(*dacxo));
+	if (!dacxo)
+		return -ENOMEM;
+	dacxo->ext.version = SND_PCM_EXTPLUG_VERSION;
+	dacxo->ext.name = "dacxo 24-bit conversion plugin";
+	dacxo->ext.callback = &dacxo24_callback;
+	dacxo->ext.private_data = dacxo;
+
+	int err = snd_pcm_extplug_create(&dacxo->ext, name, root, sconf, stream, mode);
+	if (err < 0) {
+		free(dacxo);
+		return err;
+	}
+
+	// stereo only, as the dacxo card
+	snd_pcm_extplug_set_param_minmax(&dacxo->ext, SND_PCM_EXTPLUG_HW_CHANNELS, 2, 2);
+	snd_pcm_extplug_set_param_list(&dacxo->ext, SND_PCM_EXTPLUG_HW_FORMAT,
+	                               sizeof(client_formats) / sizeof(client_formats[0]), client_formats);
+	snd_pcm_extplug_set_slave_param(&dacxo->ext, SND_PCM_EXTPLUG_HW_FORMAT, SND_PCM_FORMAT_S24_LE);
+
+	*pcmp = dacxo->ext.pcm;
+	return 0;
+}
+
+SND_PCM_PLUGIN_SYMBOL(dacxo24);
@@ -0,0 +1,320 @@
+/*
+ * ALSA external PCM plugin 'dacxo_conv' for the 5th generation DAC by Jos van Eijndhoven
+ *
+ * Room correction or equalization by per-channel FIR filters, in front of the dacxo card,
+ * with the partitioned convolution engine of dacxo_convolve.c.
+ * The filters are raw 32-bit float files, one per channel and sample rate, found by a template
+ * in which '%r' stands for the rate and '%c' for the channel (0 left, 1 right).
+ * Without a filter for the stream rate, the audio passes unfiltered.
+ *
+ * The partition size sets the latency against the cpu load: the engine delays by one partition.
+ * That delay is not included in the delay reported to the player.
+ *
+ * Usage in asound.conf:
+ *   pcm.dacxo_room {
+ *       type dacxo_conv
+ *       slave.pcm "dacxo_hw"
+ *       filter "/etc/dacxo/room_%r_%c.f32"
+ *       partition 1024    # frames, a power of 2 from 64 to 16384
+ *       threads 2         # at most one per channel
+ *   }
+ *
+ * Copyright 2016 Jos van Eijndhoven
+ * jos@vaneijndhoven.net
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <alsa/asoundlib.h>
+#include <alsa/pcm_external.h>
+
+#include "dacxo_convolve.h"
+
+typedef struct {
+	snd_pcm_extplug_t ext;
+	char *filter_template;
+	unsigned int partition;
+	unsigned int threads;
+	struct dacxo_convolver *conv;  // NULL: pass unfiltered
+	unsigned int pos;              // frames of the current block
+} snd_pcm_dacxo_conv_t;
+
+static const unsigned int client_formats[] = {
+	SND_PCM_FORMAT_S24_LE,
+	SND_PCM_FORMAT_S16_LE,
+	SND_PCM_FORMAT_S32_LE,
+};
+
+// The filter path for a rate and channel, from the template
+static void filter_path(char *path, size_t size, const char *template, unsigned int rate, unsigned int channel)
+{
+	size_t n = 0;
+	for (const char *t = template; *t && n + 1 < size; t++) {
+		if (t[0] == '%' && (t[1] == 'r' || t[1] == 'c')) {
+			n += snprintf(path + n, size - n, "%u", (t[1] == 'r') ? rate : channel);
+			t++;
+		} else {
+			path[n++] = *t;
+		}
+	}
+	path[(n < size) ? n : size - 1] = '\0';
+}
+
+static inline float read_sample(snd_pcm_format_t format, const char *p)
+{
+	int32_t v;
+	switch (format) {
+	case SND_PCM_FORMAT_S16_LE: {
+		int16_t s;
+		memcpy(&s, p, sizeof(s));
+		return s * (1.0f / 32768.0f);
+	}
+	case SND_PCM_FORMAT_S24_LE:
+		memcpy(&v, p, sizeof(v));
+		return (int32_t)((uint32_t)v << 8) * (1.0f / 2147483648.0f);
+	default:
+		memcpy(&v, p, sizeof(v));
+		return v * (1.0f / 2147483648.0f);
+	}
+}
+
+static inline void write_s24(char *p, float y)
+{
+	long v = lrintf(y * 8388608.0f);
+	int32_t s = (v > 8388607) ? 8388607 : (v < -8388608) ? -8388608 : (int32_t)v;
+	memcpy(p, &s, sizeof(s));
+}
+
+static snd_pcm_sframes_t dacxo_conv_transfer(snd_pcm_extplug_t *ext,
+                                             const snd_pcm_channel_area_t *dst_areas,
+                                             snd_pcm_uframes_t dst_offset,
+                                             const snd_pcm_channel_area_t *src_areas,
+                                             snd_pcm_uframes_t src_offset,
+                                             snd_pcm_uframes_t size)
+{
+	snd_pcm_dacxo_conv_t *dc = ext->private_data;
+	snd_pcm_uframes_t done = 0;
+
+	while (done < size) {
+		const unsigned int block = dc->conv ? dacxo_convolve_partition(dc->conv) : size - done;
+		snd_pcm_uframes_t n = block - dc->pos;
+		if (n > size - done)
+			n = size - done;
+
+		for (unsigned int c = 0; c < ext->channels; c++) {
+			const snd_pcm_channel_area_t *sa = &src_areas[c], *da = &dst_areas[c];
+			const char *s = (const char *)sa->addr + (sa->first + sa->step * (src_offset + done)) / 8;
+			char *d = (char *)da->addr + (da->first + da->step * (dst_offset + done)) / 8;
+			if (dc->conv) {
+				// the output of the previous block, as the input of the current block gets collected
+				float *in = dacxo_convolve_input(dc->conv, c) + dc->pos;
+				const float *out = dacxo_convolve_output(dc->conv, c) + dc->pos;
+				for (snd_pcm_uframes_t i = 0; i < n; i++, s += sa->step / 8, d += da->step / 8) {
+					in[i] = read_sample(ext->format, s);
+					write_s24(d, out[i]);
+				}
+			} else {
+				for (snd_pcm_uframes_t i = 0; i < n; i++, s += sa->step / 8, d += da->step / 8)
+					write_s24(d, read_sample(ext->format, s));
+			}
+		}
+
+		done += n;
+		if (dc->conv) {
+			dc->pos += n;
+			if (dc->pos == block) {
+				dacxo_convolve_run(dc->conv);
+				dc->pos = 0;
+			}
+		}
+	}
+	return size;
+}
+
+// Load the filters of the stream rate, and set up the engine
+static int dacxo_conv_hw_params(snd_pcm_extplug_t *ext, snd_pcm_hw_params_t *params)
+{
+	snd_pcm_dacxo_conv_t *dc = ext->private_data;
+	float *filters[DACXO_CONV_CHANNELS_MAX] = { NULL };
+	size_t taps[DACXO_CONV_CHANNELS_MAX];
+	char path[1024];
+	int err = 0;
+
+	dacxo_convolve_destroy(dc->conv);
+	dc->conv = NULL;
+	dc->pos = 0;
+	if (ext->channels > DACXO_CONV_CHANNELS_MAX)
+		return -EINVAL;
+
+	for (unsigned int c = 0; c < ext->channels && !err; c++) {
+		filter_path(path, sizeof(path), dc->filter_template, ext->rate, c);
+		long n = dacxo_convolve_load_filter(path, &filters[c]);
+		if (n == -ENOENT) {
+			SNDERR("dacxo_conv: no filter %s, passing unfiltered at %uHz", path, ext->rate);
+			err = 1;
+		} else if (n < 0) {
+			SNDERR("dacxo_conv: filter %s: %s", path, strerror(-n));
+			err = n;
+		} else {
+			taps[c] = n;
+		}
+	}
+	if (!err) {
+		dc->conv = dacxo_convolve_create(ext->channels, dc->partition,
+		                                 (const float *const *)filters, taps, dc->threads);
+		if (!dc->conv)
+			err = -ENOMEM;
+	}
+	for (unsigned int c = 0; c < ext->channels; c++)
+		free(filters[c]);
+	return (err < 0) ? err : 0;
+}
+
+static int dacxo_conv_hw_free(snd_pcm_extplug_t *ext)
+{
+	snd_pcm_dacxo_conv_t *dc = ext->private_data;
+
+	dacxo_convolve_destroy(dc->conv);
+	dc->conv = NULL;
+	return 0;
+}
+
+// On prepare: start from silence
+static int dacxo_conv_init(snd_pcm_extplug_t *ext)
+{
+	snd_pcm_dacxo_conv_t *dc = ext->private_data;
+
+	if (dc->conv)
+		dacxo_convolve_reset(dc->conv);
+	dc->pos = 0;
+	return 0;
+}
+
+static int dacxo_conv_close(snd_pcm_extplug_t *ext)
+{
+	snd_pcm_dacxo_conv_t *dc = ext->private_data;
+
+	dacxo_convolve_destroy(dc->conv);
+	free(dc->filter_template);
+	free(dc);
+	return 0;
+}
+
+static void dacxo_conv_dump(snd_pcm_extplug_t *ext, snd_output_t *out)
+{
+	snd_pcm_dacxo_conv_t *dc = ext->private_data;
+
+	snd_output_printf(out, "dacxo convolution (%s): filter %s, partition %u, %s\n", dacxo_convolve_isa,
+	                  dc->filter_template, dc->partition, dc->conv ? "active" : "passing unfiltered");
+	snd_output_printf(out, "Slave: ");
+	snd_pcm_dump(ext->slave, out);
+}
+
+static const snd_pcm_extplug_callback_t dacxo_conv_callback = {
+	.transfer = dacxo_conv_transfer,
+	.close = dacxo_conv_close,
+	.hw_params = dacxo_conv_hw_params,
+	.hw_free = dacxo_conv_hw_free,
+	.dump = dacxo_conv_dump,
+	.init = dacxo_conv_init,
+};
+
+SND_PCM_PLUGIN_DEFINE_FUNC(dacxo_conv)
+{
+	snd_config_iterator_t i, next;
+	snd_config_t *sconf = NULL;
+	const char *filter = NULL;
+	long partition = DACXO_CONV_PARTITION_DEFAULT;
+	long threads = 2;
+
+	snd_config_for_each(i, next, conf) {
+		snd_config_t *n = snd_config_iterator_entry(i);
+		const char *id;
+		if (snd_config_get_id(n, &id) < 0)
+			continue;
+		if (strcmp(id, "comment") == 0 || strcmp(id, "type") == 0 || strcmp(id, "hint") == 0)
+			continue;
+		if (strcmp(id, "slave") == 0) {
+			sconf = n;
+			continue;
+		}
+		if (strcmp(id, "filter") == 0) {
+			if (snd_config_get_string(n, &filter) < 0) {
+				SNDERR("Invalid string for %s", id);
+				return -EINVAL;
+			}
+			continue;
+		}
+		if (strcmp(id, "partition") == 0) {
+			if (snd_config_get_integer(n, &partition) < 0 ||
+			    partition < DACXO_CONV_PARTITION_MIN || partition > DACXO_CONV_PARTITION_MAX ||
+			    (partition & (partition - 1))) {
+				SNDERR("Invalid partition: a power of 2 from %d to %d", DACXO_CONV_PARTITION_MIN,
+				       DACXO_CONV_PARTITION_MAX);
+				return -EINVAL;
+			}
+			continue;
+		}
+		if (strcmp(id, "threads") == 0) {
+			if (snd_config_get_integer(n, &threads) < 0 || threads < 1) {
+				SNDERR("Invalid value for %s", id);
+				return -EINVAL;
+			}
+			continue;
+		}
+		SNDERR("Unknown field %s", id);
+		return -EINVAL;
+	}
+	if (!sconf) {
+		SNDERR("No slave configuration for dacxo_conv pcm");
+		return -EINVAL;
+	}
+	if (!filter) {
+		SNDERR("No filter for dacxo_conv pcm");
+		return -EINVAL;
+	}
+	if (stream != SND_PCM_STREAM_PLAYBACK) {
+		SNDERR("dacxo_conv is a playback-only plugin");
+		return -EINVAL;
+	}
+
+	snd_pcm_dacxo_conv_t *dc = calloc(1, sizeof(*dc));
+	if (!dc)
+		return -ENOMEM;
+	dc->filter_template = strdup(filter);
+	dc->partition = partition;
+	dc->threads = threads;
+	if (!dc->filter_template) {
+		free(dc);
+		return -ENOMEM;
+	}
+	dc->ext.version = SND_PCM_EXTPLUG_VERSION;
+	dc->ext.name = "dacxo convolution plugin";
+	dc->ext.callback = &dacxo_conv_callback;
+	dc->ext.private_data = dc;
+
+	int err = snd_pcm_extplug_create(&dc->ext, name, root, sconf, stream, mode);
+	if (err < 0) {
+		free(dc->filter_template);
+		free(dc);
+		return err;
+	}
+
+	// stereo only, as the dacxo card
+	snd_pcm_extplug_set_param_minmax(&dc->ext, SND_PCM_EXTPLUG_HW_CHANNELS, 2, 2);
+	snd_pcm_extplug_set_param_list(&dc->ext, SND_PCM_EXTPLUG_HW_FORMAT,
+	                               sizeof(client_formats) / sizeof(client_formats[0]), client_formats);
+	snd_pcm_extplug_set_slave_param(&dc->ext, SND_PCM_EXTPLUG_HW_FORMAT, SND_PCM_FORMAT_S24_LE);
+
+	*pcmp = dc->ext.pcm;
+	return 0;
+}
+
+SND_PCM_PLUGIN_SYMBOL(dacxo_conv);
@@ -0,0 +1,220 @@
+/*
+ * ALSA rate converter plugin 'dacxo' for the 5th generation DAC by Jos van Eijndhoven
+ *
+ * The dacxo card plays the 44.1kHz and 48kHz families at x1, x2 and x4 only.
+ * The 'plug' converts any other rate to the nearest of these, by default with the
+ * simple 'linear' converter. This plugin replaces that with a polyphase filter,
+ * see dacxo_resample.c. With the 'Rate Family' control of the card pinned to one family,
+ * the streams of the other family also get converted, rather than switching the oscillator.
+ *
+ * Usage in asound.conf:
+ *   pcm.dacxo {
+ *       type plug
+ *       slave.pcm "dacxo24"
+ *       rate_converter "dacxo"
+ *   }
+ * or with another filter length than the default of 64 taps:
+ *       rate_converter { name "dacxo" taps 128 }
+ *
+ * Copyright 2016 Jos van Eijndhoven
+ * jos@vaneijndhoven.net
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ */
+
+#include <stdlib.h>
+#include <alsa/asoundlib.h>
+#include <alsa/pcm_rate.h>
+
+#include "dacxo_resample.h"
+
+struct rate_dacxo {
+	struct dacxo_resampler rs;
+	unsigned int taps;     // as configured, 0 for the default
+	snd_pcm_format_t format;
+	snd_pcm_uframes_t in_period;
+	snd_pcm_uframes_t out_period;
+};
+
+static void *frame_addr(const snd_pcm_channel_area_t *areas, snd_pcm_uframes_t offset)
+{
+	return (char *)areas[0].addr + (areas[0].first + areas[0].step * offset) / 8;
+}
+
+static int dacxo_rate_init(void *obj, snd_pcm_rate_info_t *info)
+{
+	struct rate_dacxo *rate = obj;
+	snd_pcm_uframes_t max_chunk = info->in.buffer_size > info->in.period_size
+	                            ? info->in.buffer_size : info->in.period_size;
+
+	dacxo_resample_free(&rate->rs);
+	int err = dacxo_resample_init(&rate->rs, info->channels, info->in.rate, info->out.rate,
+	                              info->in.period_size, info->out.period_size, max_chunk, rate->taps);
+	if (err < 0)
+		return err;
+	rate->format = info->in.format;
+	rate->in_period = info->in.period_size;
+	rate->out_period = info->out.period_size;
+	return 0;
+}
+
+static int dacxo_rate_adjust_pitch(void *obj, snd_pcm_rate_info_t *info)
+{
+	struct rate_dacxo *rate = obj;
+
+	dacxo_resample_set_step(&rate->rs, info->in.period_size, info->out.period_size);
+	rate->in_period = info->in.period_size;
+	rate->out_period = info->out.period_size;
+	return 0;
+}
+
+static void dacxo_rate_reset(void *obj)
+{
+	struct rate_dacxo *rate = obj;
+
+	if (rate->rs.hist)
+		dacxo_resample_reset(&rate->rs);
+}
+
+static void dacxo_rate_free(void *obj)
+{
+	struct rate_dacxo *rate = obj;
+
+	dacxo_resample_free(&rate->rs);
+}
+
+static void dacxo_rate_close(void *obj)
+{
+	dacxo_rate_free(obj);
+	free(obj);
+}
+
+static void dacxo_rate_convert(void *obj,
+                               const snd_pcm_channel_area_t *dst_areas, snd_pcm_uframes_t dst_offset,
+                               unsigned int dst_frames,
+                               const snd_pcm_channel_area_t *src_areas, snd_pcm_uframes_t src_offset,
+                               unsigned int src_frames)
+{
+	struct rate_dacxo *rate = obj;
+
+	// interleaved only, see dacxo_rate_get_supported_formats()
+	if (rate->format == SND_PCM_FORMAT_S16_LE)
+		dacxo_resample_s16(&rate->rs, frame_addr(dst_areas, dst_offset), dst_frames,
+		                   frame_addr(src_areas, src_offset), src_frames);
+	else
+		dacxo_resample_s32(&rate->rs, frame_addr(dst_areas, dst_offset), dst_frames,
+		                   frame_addr(src_areas, src_offset), src_frames);
+}
+
+static void dacxo_rate_convert_s16(void *obj, int16_t *dst, unsigned int dst_frames,
+                                   const int16_t *src, unsigned int src_frames)
+{
+	struct rate_dacxo *rate = obj;
+
+	dacxo_resample_s16(&rate->rs, dst, dst_frames, src, src_frames);
+}
+
+static snd_pcm_uframes_t dacxo_rate_input_frames(void *obj, snd_pcm_uframes_t frames)
+{
+	struct rate_dacxo *rate = obj;
+
+	if (!rate->rs.out_step)
+		return frames;
+	return (frames == rate->out_period) ? rate->in_period : dacxo_resample_in_frames(&rate->rs, frames);
+}
+
+static snd_pcm_uframes_t dacxo_rate_output_frames(void *obj, snd_pcm_uframes_t frames)
+{
+	struct rate_dacxo *rate = obj;
+
+	if (!rate->rs.in_step)
+		return frames;
+	return (frames == rate->in_period) ? rate->out_period : dacxo_resample_out_frames(&rate->rs, frames);
+}
+
+static int dacxo_rate_get_supported_rates(void *obj, unsigned int *rate_min, unsigned int *rate_max)
+{
+	*rate_min = 8000;
+	*rate_max = 384000;
+	return 0;
+}
+
+static void dacxo_rate_dump(void *obj, snd_output_t *out)
+{
+	struct rate_dacxo *rate = obj;
+
+	snd_output_printf(out, "Converter: dacxo polyphase (%s), %u taps\n", dacxo_resample_isa, rate->rs.taps);
+}
+
+#if SND_PCM_RATE_PLUGIN_VERSION >= 0x010003
+// 32-bit samples keep the 24-bit resolution of the dac, 16-bit samples stay 16-bit
+static int dacxo_rate_get_supported_formats(void *obj, uint64_t *in_formats, uint64_t *out_formats,
+                                            unsigned int *flags)
+{
+	*in_formats = *out_formats = (1ULL << SND_PCM_FORMAT_S16_LE) | (1ULL << SND_PCM_FORMAT_S32_LE);
+	*flags = SND_PCM_RATE_FLAG_INTERLEAVED | SND_PCM_RATE_FLAG_SYNC_FORMATS;
+	return 0;
+}
+#endif
+
+static const snd_pcm_rate_ops_t dacxo_rate_ops = {
+	.close = dacxo_rate_close,
+	.init = dacxo_rate_init,
+	.free = dacxo_rate_free,
+	.reset = dacxo_rate_reset,
+	.adjust_pitch = dacxo_rate_adjust_pitch,
+	.convert = dacxo_rate_convert,
+	.convert_s16 = dacxo_rate_convert_s16,
+	.input_frames = dacxo_rate_input_frames,
+	.output_frames = dacxo_rate_output_frames,
+	.version = SND_PCM_RATE_PLUGIN_VERSION,
+	.get_supported_rates = dacxo_rate_get_supported_rates,
+	.dump = dacxo_rate_dump,
+#if SND_PCM_RATE_PLUGIN_VERSION >= 0x010003
+	.get_supported_formats = dacxo_rate_get_supported_formats,
+#endif
+};
+
+static int dacxo_rate_open(unsigned int version, void **objp, snd_pcm_rate_ops_t *ops,
+                           const snd_config_t *conf)
+{
+	if (version < SND_PCM_RATE_PLUGIN_VERSION) {
+		SNDERR("dacxo rate plugin: built for a newer alsa-lib (version %x), please rebuild", version);
+		return -EINVAL;
+	}
+
+	struct rate_dacxo *rate = calloc(1, sizeof(*rate));
+	if (!rate)
+		return -ENOMEM;
+
+	snd_config_t *n;
+	if (conf && snd_config_search((snd_config_t *)conf, "taps", &n) >= 0) {
+		long taps;
+		if (snd_config_get_integer(n, &taps) < 0 || taps < 8 || taps > DACXO_RESAMPLE_TAPS_MAX) {
+			SNDERR("dacxo rate plugin: invalid taps, 8 to %d", DACXO_RESAMPLE_TAPS_MAX);
+			free(rate);
+			return -EINVAL;
+		}
+		rate->taps = taps;
+	}
+
+	*objp = rate;
+	*ops = dacxo_rate_ops;
+	return 0;
+}
+
+int SND_PCM_RATE_PLUGIN_ENTRY(dacxo)(unsigned int version, void **objp, snd_pcm_rate_ops_t *ops)
+{
+	return dacxo_rate_open(version, objp, ops, NULL);
+}
+
+#ifdef SND_PCM_RATE_PLUGIN_CONF_ENTRY
+int SND_PCM_RATE_PLUGIN_CONF_ENTRY(dacxo)(unsigned int version, void **objp, snd_pcm_rate_ops_t *ops,
+                                          const snd_config_t *conf)
+{
+	return dacxo_rate_open(version, objp, ops, conf);
+}
+#endif
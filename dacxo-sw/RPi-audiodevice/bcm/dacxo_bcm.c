@@ -32,6 +32,13 @@
 #include <linux/i2c.h>
 #include <linux/gpio/consumer.h>
 #include <linux/regmap.h>
+#include <linux/workqueue.h>
+#include <linux/interrupt.h>
+#include <linux/mutex.h>
+#include <linux/ktime.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+#include <linux/math64.h>
 
 #include <sound/core.h>
 #include <sound/pcm.h>
@@ -43,6 +50,9 @@
 #include "../codecs/dacxo.h"
 #include "../codecs/pcm1792a.h"
 
+#define CREATE_TRACE_POINTS
+#include "dacxo_bcm_trace.h"
+
 /* refrain from providing these defaults: that avoids potential mismatch with actual reg content
 static const struct reg_default pcm1792a_reg_defaults[] = {
 	{ PCM1792A_DAC_VOL_LEFT,   PCM1792A_DAC_VOL_LEFT_DEFAULT},
@@ -79,7 +89,37 @@ static const struct regmap_config pcm1792_regmap_config = {
   .cache_type       = REGCACHE_RBTREE, // This remembers values while DAC is not powered
 };
 
-static void dacxo_set_attenuation( struct dacxo_bcm_priv *priv, unsigned short vol_l, unsigned short vol_r);
+static unsigned int dacxo_set_attenuation( struct dacxo_bcm_priv *priv, unsigned short vol_l, unsigned short vol_r);
+
+// Stages of the card bring-up, with their boot time as shown in debugfs 'dacxo/probe'
+enum dacxo_probe_stage {
+	DACXO_PROBE_START,       // (last) probe attempt
+	DACXO_PROBE_GPIO,        // uisync gpio acquired
+	DACXO_PROBE_I2C,         // fpga and dac i2c devices found
+	DACXO_PROBE_REGMAPS,
+	DACXO_PROBE_REGISTERED,  // card registered
+	DACXO_PROBE_CARD_INIT,   // dai link init done
+	DACXO_PROBE_PLAYABLE,    // first analog power-up complete
+	DACXO_NUM_PROBE_STAGES
+};
+
+static const char *const dacxo_probe_stage_names[] = {
+	"probe_start", "gpio", "i2c_devices", "regmaps", "card_registered", "card_init", "first_playable"
+};
+
+// Module-level, as the card private data is reallocated on each (deferred) probe attempt
+static struct {
+	ktime_t first_probe;
+	unsigned int attempts;
+	ktime_t stage[DACXO_NUM_PROBE_STAGES];  // boot time, 0 if not reached
+} dacxo_probe_times;
+
+static void dacxo_probe_stage(enum dacxo_probe_stage stage)
+{
+	if (stage == DACXO_PROBE_PLAYABLE && dacxo_probe_times.stage[stage])
+		return;  // only the first one
+	dacxo_probe_times.stage[stage] = ktime_get_boottime();
+}
 
 /* sound card init */
 static int dacxo_pcm1792_init(struct i2c_client *dac, bool is_powered, bool is_right_chan)
@@ -128,30 +168,20 @@ static int dacxo_bcm_init(struct snd_soc_pcm_runtime *rtd)
 	if (!priv)
 	  return -EINVAL;
 
-  // Note that the FPGA has already done its own init during its 'probe()'
-  bool is_powered = false;
-	unsigned int gpi1_val = 0;
-  int err = regmap_read(priv->fpga_regs, REGDAC_GPI1, &gpi1_val);
-	if (!err) {
-		is_powered = (gpi1_val & GPI1_ANAPWR) != 0;
-	}
-
-	if (is_powered) {
-		gpiod_set_value(priv->uisync_gpio, 0);  // pull-down 'uisync' pin: signal UI controller on change and stay silent
-	}
-
-	// the pcm1792 dac chip registers get initial assignment.
-	// When they are not yet powered-up, this initialization remains in the regmap cache,
-  dacxo_pcm1792_init(priv->dac_l, is_powered, false);
-	dacxo_pcm1792_init(priv->dac_r, is_powered, true);
-
-	if (is_powered) {
-		gpiod_set_value(priv->uisync_gpio, 1);
-	}
+	// The pcm1792 dac chip registers get their initial assignment in the regmap cache only,
+	// without i2c traffic during the card registration. They are written on first use:
+	// the power event of the first stream syncs the caches to the chips, also when the
+	// analog power was on already (power_state remains 'off' until then).
+  dacxo_pcm1792_init(priv->dac_l, false, false);
+	dacxo_pcm1792_init(priv->dac_r, false, true);
+	dacxo_probe_stage(DACXO_PROBE_CARD_INIT);
 
 	return 0;
 }
 
+// Delay from a volume control write until its application, to coalesce bursts of writes
+#define DACXO_VOLUME_DELAY_MS 20
+
 // replace the volume control from soc-ops.c
 // which is inserted through e.g. #define SOC_DOUBLE_R in soc.h
 static int bcm_vol_info(struct snd_kcontrol *kcontrol, struct snd_ctl_elem_info *uinfo)
@@ -166,35 +196,55 @@ static int bcm_vol_info(struct snd_kcontrol *kcontrol, struct snd_ctl_elem_info
 
 static int bcm_vol_get(struct snd_kcontrol *kcontrol, struct snd_ctl_elem_value *ucontrol)
 {
-	pr_info("dacxo_bcm:my_snd_soc_get_volsw() private_value = %04lx\n",
-		kcontrol->private_value);
+	struct snd_soc_card *card = snd_kcontrol_chip(kcontrol);
+  struct dacxo_bcm_priv *priv = snd_soc_card_get_drvdata(card);
 
-	unsigned short vol_l = kcontrol->private_value & 0x00ff; // lower 16 bits for left channel, 1dB units
-	unsigned short vol_r = (kcontrol->private_value >> 16) & 0x00ff; // lower 16 bits for left channel
-	ucontrol->value.integer.value[0] = -vol_l; // alsa operates with 0.01dB units
-	ucontrol->value.integer.value[1] = -vol_r;
+	// report the target: that gets applied shortly, if not yet done
+	uint32_t vol = READ_ONCE(priv->target_volume);
+	ucontrol->value.integer.value[0] = vol >> 16;     // left channel, 1dB units
+	ucontrol->value.integer.value[1] = vol & 0xffff;  // right channel
 	
 	return 0;
 }
 
+// Apply the latest volume target of the ALSA control.
+// Running from a work item, a burst of control writes (slider drag, fade) results in few i2c writes.
+static void dacxo_volume_work(struct work_struct *work)
+{
+	struct dacxo_bcm_priv *priv = container_of(to_delayed_work(work), struct dacxo_bcm_priv, volume_work);
+
+	uint32_t new_vol = READ_ONCE(priv->target_volume);
+	if (new_vol == priv->prev_volume)
+		return;
+
+	mutex_lock(&priv->lock);
+	priv->prev_volume = new_vol;
+	if (dacxo_set_attenuation( priv, DAC_max_attenuation_dB - (new_vol >> 16), DAC_max_attenuation_dB - (new_vol & 0xffff)))
+		priv->stats.volume_applies++;
+	mutex_unlock(&priv->lock);
+}
+
 static int bcm_vol_put(struct snd_kcontrol *kcontrol, struct snd_ctl_elem_value *ucontrol)
 {
 	struct snd_soc_card *card = snd_kcontrol_chip(kcontrol);
   struct dacxo_bcm_priv *priv = snd_soc_card_get_drvdata(card);
-  uint16_t vol_l = ucontrol->value.integer.value[0];
-  uint16_t vol_r = ucontrol->value.integer.value[1];
+  long vol_l = ucontrol->value.integer.value[0];
+  long vol_r = ucontrol->value.integer.value[1];
 	
 	// ALSA values are configured to 0 (mute) to 80 (0dB, max volume)
-	pr_info("dacxo_bcm: vol_put() ALSA vol_l=%u, vol_r=%d\n", vol_l, vol_r);
+	pr_debug("dacxo_bcm: vol_put() ALSA vol_l=%ld, vol_r=%ld\n", vol_l, vol_r);
+	if (vol_l < 0 || vol_l > DAC_max_attenuation_dB || vol_r < 0 || vol_r > DAC_max_attenuation_dB)
+		return -EINVAL;
 
 	uint32_t new_vol = (vol_l << 16) | vol_r;
-	int changed = new_vol != priv->prev_volume;
+	if (new_vol == READ_ONCE(priv->target_volume))
+	  return 0;
 
-	if (!changed || !priv->dac_l || !priv->dac_r)
-	  return 1;
-	
-	priv->prev_volume = new_vol;
-	dacxo_set_attenuation( priv, DAC_max_attenuation_dB - vol_l, DAC_max_attenuation_dB - vol_r);
+	WRITE_ONCE(priv->target_volume, new_vol);
+	if (priv->dac_l && priv->dac_r) {
+		// no-op if already pending: the pending work picks up this latest target
+		schedule_delayed_work(&priv->volume_work, msecs_to_jiffies(DACXO_VOLUME_DELAY_MS));
+	}
 
 	return 1;
 }
@@ -235,11 +285,14 @@ static int dacxo_input_put(struct snd_kcontrol *kcontrol,
   if (err) return err;
 
 	unsigned int curr_input_sel = ((gpo0 & GPO0_CLKMASTER) == 0) ? (((gpo0 & GPO0_SLVINPUT) >> 2) + 1) : 0;
-	if (sel == curr_input_sel)
+	if (sel == curr_input_sel) {
+		priv->stats.writes_saved++;
 		return 0;  // no change on input select
+	}
 
-  dev_info(card->dev, "dacxo_bcm: Switching input to %d\n", sel);
-  gpiod_set_value(priv->uisync_gpio, 0);  // pull-down 'uisync' pin: signal UI controller on change and stay silent
+  dev_dbg(card->dev, "dacxo_bcm: Switching input to %d\n", sel);
+  mutex_lock(&priv->lock);
+  dacxo_lease_acquire(priv);
   
   // 2. Perform the I2C write to the FPGA
 	if (sel == 0) {
@@ -252,8 +305,13 @@ static int dacxo_input_put(struct snd_kcontrol *kcontrol,
     err = regmap_update_bits(priv->fpga_regs, REGDAC_GPO0,
 			                       GPO0_CLKMASTER | GPO0_SLVINPUT, (spdif_input << 2));
 	}
-	gpiod_set_value(priv->uisync_gpio, 1);
-  if (err) return err;
+	dacxo_lease_release(priv, true);  // the UI controller reads back the new input
+  mutex_unlock(&priv->lock);
+	trace_dacxo_i2c(priv->fpga->name, REGDAC_GPO0, 1, true, err);
+  if (err) {
+		priv->stats.i2c_errors[DACXO_DEV_FPGA]++;
+		return err;
+	}
 
   return 1; // Return 1 to inform ALSA the value actually changed
 }
@@ -280,6 +338,253 @@ static int dacxo_input_get(struct snd_kcontrol *kcontrol,
   return 0;
 }
 
+// Delay from a rate hint until the oscillator pre-selection, such that a stream open
+// right after the hint does not get a clock switch in between.
+#define DACXO_RATE_HINT_HOLDOFF_MS 100
+
+// Pre-select the oscillator family of the hinted rate, while no stream is open.
+// The multiplier switch is fast: that is left to the codec prepare of the next stream.
+static void dacxo_rate_hint_work(struct work_struct *work)
+{
+	struct dacxo_bcm_priv *priv = container_of(to_delayed_work(work), struct dacxo_bcm_priv, rate_hint_work);
+	const unsigned int family = GPO0_CLKMASTER | GPO0_BASE48KHZ;
+	unsigned int gpo0 = 0;
+	bool preselect = false;
+
+	mutex_lock(&priv->lock);
+	const int rate = priv->rate_hint;
+	if (!rate) {
+		mutex_unlock(&priv->lock);
+		return;  // withdrawn: the clock config of rate 0 is no family
+	}
+	const unsigned int gpo0_new = dacxo_rate_clkconfig(rate);
+	int err = regmap_read(priv->fpga_regs, REGDAC_GPO0, &gpo0);
+	// an open stream keeps its rate, and an s/pdif input stays selected
+	if (!err && !priv->stream_open) {
+		priv->rate_hint = 0;  // consumed
+		preselect = (gpo0 & GPO0_CLKMASTER) && ((gpo0 ^ gpo0_new) & family) != 0;
+	}
+	if (preselect) {
+		dacxo_lease_acquire(priv);
+		err = regmap_update_bits(priv->fpga_regs, REGDAC_GPO0, GPO0_CLKMASK, gpo0_new);
+		dacxo_lease_release(priv, true);
+		trace_dacxo_i2c(priv->fpga->name, REGDAC_GPO0, 1, true, err);
+	}
+	mutex_unlock(&priv->lock);
+
+	if (err)
+		priv->stats.i2c_errors[DACXO_DEV_FPGA]++;
+	else if (preselect)
+		priv->stats.rate_preselects++;
+	trace_dacxo_rate_hint(rate, gpo0_new, preselect && !err, err);
+}
+
+static int dacxo_rate_hint_info(struct snd_kcontrol *kcontrol, struct snd_ctl_elem_info *uinfo)
+{
+	uinfo->type = SNDRV_CTL_ELEM_TYPE_INTEGER;
+	uinfo->count = 1;
+	uinfo->value.integer.min = 0;
+	uinfo->value.integer.max = 192000;
+	return 0;
+}
+
+static int dacxo_rate_hint_get(struct snd_kcontrol *kcontrol, struct snd_ctl_elem_value *ucontrol)
+{
+	struct snd_soc_card *card = snd_kcontrol_chip(kcontrol);
+	struct dacxo_bcm_priv *priv = snd_soc_card_get_drvdata(card);
+
+	ucontrol->value.integer.value[0] = READ_ONCE(priv->rate_hint);
+	return 0;
+}
+
+// A player announces the sample rate of its next track, or 0 for none.
+// Without an open stream, the oscillator family is switched after a short hold-off,
+// otherwise when the stream closes: the next stream then starts without oscillator settling.
+static int dacxo_rate_hint_put(struct snd_kcontrol *kcontrol, struct snd_ctl_elem_value *ucontrol)
+{
+	struct snd_soc_card *card = snd_kcontrol_chip(kcontrol);
+	struct dacxo_bcm_priv *priv = snd_soc_card_get_drvdata(card);
+	long rate = ucontrol->value.integer.value[0];
+
+	if (rate != 0 && (dacxo_rate_clkconfig(rate) & GPO0_CLKRATE) == 0)
+		return -EINVAL;  // not a supported rate
+	if (rate == READ_ONCE(priv->rate_hint))
+		return 0;
+
+	pr_debug("dacxo_bcm: rate_hint_put(rate=%ld)\n", rate);
+	WRITE_ONCE(priv->rate_hint, rate);
+	priv->stats.rate_hints++;
+	if (rate)
+		mod_delayed_work(system_wq, &priv->rate_hint_work, msecs_to_jiffies(DACXO_RATE_HINT_HOLDOFF_MS));
+	else
+		cancel_delayed_work(&priv->rate_hint_work);  // a hint withdrawn within the hold-off
+	return 1;
+}
+
+// Interval of the status work sampling the FPGA clock and fifo state
+#define DACXO_STATUS_POLL_MS 500
+
+static const unsigned int dacxo_rates[] = {
+	0, 0, 44100, 48000, 88200, 96000, 176400, 192000  // indexed by GPI0_RATE
+};
+
+static const char *const dacxo_level_texts[] = {
+	"Nom", "Low", "High"
+};
+
+// Decode the FPGA status registers into the values of the status controls.
+// In master mode the DAC clocks the i2s input: always locked, on the rate set by the RPi in GPO0.
+static void dacxo_status_decode(unsigned int gpo0, unsigned int gpi0, unsigned int *status)
+{
+	const bool is_master = (gpo0 & GPO0_CLKMASTER) != 0;
+	const bool has_lock = is_master || (gpi0 & GPI0_LOCK);
+	const unsigned int rate = is_master ? gpo0 : gpi0;
+
+	status[DACXO_STATUS_LOCK] = has_lock;
+	status[DACXO_STATUS_RATE] = has_lock ? dacxo_rates[(rate & GPI0_RATE) >> 1] : 0;
+	status[DACXO_STATUS_TRIM] = (is_master || !(gpi0 & (GPI0_ADJ_HI | GPI0_ADJ_LO))) ? 0 :
+	                            (gpi0 & GPI0_ADJ_LO) ? 1 : 2;
+	status[DACXO_STATUS_FILL] = (is_master || !(gpi0 & (GPI0_EMPTYISH | GPI0_FULLISH))) ? 0 :
+	                            (gpi0 & GPI0_EMPTYISH) ? 1 : 2;
+}
+
+// Sample the FPGA status at a low rate, and notify ALSA of the controls that changed.
+// Monitoring applications thereby wait on control events, rather than polling the i2c bus.
+static void dacxo_status_work(struct work_struct *work)
+{
+	struct dacxo_bcm_priv *priv = container_of(to_delayed_work(work), struct dacxo_bcm_priv, status_work);
+	unsigned int gpo0 = 0;
+	unsigned int gpi0 = 0;
+
+	// GPI0 is volatile: the lock keeps the uinotify irq from setting the regmap in cache-only mode meanwhile
+	mutex_lock(&priv->lock);
+	dacxo_lease_acquire(priv);
+	int err = regmap_read(priv->fpga_regs, REGDAC_GPO0, &gpo0);
+	if (!err)
+		err = regmap_read(priv->fpga_regs, REGDAC_GPI0, &gpi0);
+	dacxo_lease_release(priv, false);
+	mutex_unlock(&priv->lock);
+
+	if (err) {
+		pr_warn_ratelimited("dacxo_bcm: status_work: fpga read err=%d\n", err);
+	} else {
+		unsigned int status[DACXO_NUM_STATUS];
+		dacxo_status_decode(gpo0, gpi0, status);
+		for (int i = 0; i < DACXO_NUM_STATUS; i++) {
+			if (status[i] == READ_ONCE(priv->status[i]))
+				continue;
+			WRITE_ONCE(priv->status[i], status[i]);
+			if (priv->status_kctl[i])
+				snd_ctl_notify(priv->card->snd_card, SNDRV_CTL_EVENT_MASK_VALUE, &priv->status_kctl[i]->id);
+		}
+	}
+	schedule_delayed_work(&priv->status_work, msecs_to_jiffies(DACXO_STATUS_POLL_MS));
+}
+
+static int dacxo_status_info(struct snd_kcontrol *kcontrol, struct snd_ctl_elem_info *uinfo)
+{
+	switch (kcontrol->private_value) {
+	case DACXO_STATUS_LOCK:
+		return snd_ctl_boolean_mono_info(kcontrol, uinfo);
+	case DACXO_STATUS_RATE:
+		uinfo->type = SNDRV_CTL_ELEM_TYPE_INTEGER;
+		uinfo->count = 1;
+		uinfo->value.integer.min = 0;
+		uinfo->value.integer.max = 192000;
+		return 0;
+	default:
+		return snd_ctl_enum_info(uinfo, 1, ARRAY_SIZE(dacxo_level_texts), dacxo_level_texts);
+	}
+}
+
+// Report the last sample of the status work: reading a status control causes no i2c traffic
+static int dacxo_status_get(struct snd_kcontrol *kcontrol, struct snd_ctl_elem_value *ucontrol)
+{
+	struct snd_soc_card *card = snd_kcontrol_chip(kcontrol);
+	struct dacxo_bcm_priv *priv = snd_soc_card_get_drvdata(card);
+	unsigned int val = READ_ONCE(priv->status[kcontrol->private_value]);
+
+	if (kcontrol->private_value >= DACXO_STATUS_TRIM)
+		ucontrol->value.enumerated.item[0] = val;
+	else
+		ucontrol->value.integer.value[0] = val;
+	return 0;
+}
+
+// The control names, indexed by 'enum dacxo_status_ctl', to look up the registered controls
+static const char *const dacxo_status_names[] = {
+	"Input Lock", "Input Rate", "Clock Trim", "FIFO Fill"
+};
+
+#define DACXO_STATUS_CONTROL(xname, xindex) { \
+	.iface = SNDRV_CTL_ELEM_IFACE_MIXER, \
+	.name = xname, \
+	.access = SNDRV_CTL_ELEM_ACCESS_READ, \
+	.info = dacxo_status_info, \
+	.get = dacxo_status_get, \
+	.private_value = xindex, \
+}
+
+static const char *const dacxo_latency_texts[] = {
+	"Low Latency", "Balanced", "Power Save"  // indexed by 'enum dacxo_latency_profile'
+};
+
+static SOC_ENUM_SINGLE_EXT_DECL(dacxo_latency_enum, dacxo_latency_texts);
+
+static int dacxo_latency_get(struct snd_kcontrol *kcontrol, struct snd_ctl_elem_value *ucontrol)
+{
+	struct snd_soc_card *card = snd_kcontrol_chip(kcontrol);
+	struct dacxo_bcm_priv *priv = snd_soc_card_get_drvdata(card);
+
+	ucontrol->value.enumerated.item[0] = READ_ONCE(priv->latency_profile);
+	return 0;
+}
+
+// The latency profile applies from the next stream open
+static int dacxo_latency_put(struct snd_kcontrol *kcontrol, struct snd_ctl_elem_value *ucontrol)
+{
+	struct snd_soc_card *card = snd_kcontrol_chip(kcontrol);
+	struct dacxo_bcm_priv *priv = snd_soc_card_get_drvdata(card);
+	unsigned int profile = ucontrol->value.enumerated.item[0];
+
+	if (profile >= DACXO_NUM_LATENCY_PROFILES)
+		return -EINVAL;
+	if (profile == READ_ONCE(priv->latency_profile))
+		return 0;
+	WRITE_ONCE(priv->latency_profile, profile);
+	return 1;
+}
+
+static const char *const dacxo_family_texts[] = {
+	"Auto", "44.1kHz", "48kHz"  // indexed by 'enum dacxo_rate_family'
+};
+
+static SOC_ENUM_SINGLE_EXT_DECL(dacxo_family_enum, dacxo_family_texts);
+
+static int dacxo_family_get(struct snd_kcontrol *kcontrol, struct snd_ctl_elem_value *ucontrol)
+{
+	struct snd_soc_card *card = snd_kcontrol_chip(kcontrol);
+	struct dacxo_bcm_priv *priv = snd_soc_card_get_drvdata(card);
+
+	ucontrol->value.enumerated.item[0] = READ_ONCE(priv->rate_family);
+	return 0;
+}
+
+// A pinned rate family applies from the next stream open, for the whole session of the player
+static int dacxo_family_put(struct snd_kcontrol *kcontrol, struct snd_ctl_elem_value *ucontrol)
+{
+	struct snd_soc_card *card = snd_kcontrol_chip(kcontrol);
+	struct dacxo_bcm_priv *priv = snd_soc_card_get_drvdata(card);
+	unsigned int family = ucontrol->value.enumerated.item[0];
+
+	if (family >= DACXO_NUM_RATE_FAMILIES)
+		return -EINVAL;
+	if (family == READ_ONCE(priv->rate_family))
+		return 0;
+	WRITE_ONCE(priv->rate_family, family);
+	return 1;
+}
+
 static const struct snd_kcontrol_new dacxo_controls[] = {
 	{
         .iface = SNDRV_CTL_ELEM_IFACE_MIXER,
@@ -293,14 +598,105 @@ static const struct snd_kcontrol_new dacxo_controls[] = {
 	SOC_ENUM_EXT("Input Source",
 		           dacxo_input_enum, 
                dacxo_input_get,
-               dacxo_input_put)
+               dacxo_input_put),
+	{
+        .iface = SNDRV_CTL_ELEM_IFACE_MIXER,
+        .name = "Rate Hint",
+        .access = SNDRV_CTL_ELEM_ACCESS_READWRITE,
+        .info = dacxo_rate_hint_info,
+        .get  = dacxo_rate_hint_get,
+        .put  = dacxo_rate_hint_put,
+  },
+	SOC_ENUM_EXT("Latency Profile",
+	             dacxo_latency_enum,
+	             dacxo_latency_get,
+	             dacxo_latency_put),
+	SOC_ENUM_EXT("Rate Family",
+	             dacxo_family_enum,
+	             dacxo_family_get,
+	             dacxo_family_put),
+	DACXO_STATUS_CONTROL("Input Lock", DACXO_STATUS_LOCK),
+	DACXO_STATUS_CONTROL("Input Rate", DACXO_STATUS_RATE),
+	DACXO_STATUS_CONTROL("Clock Trim", DACXO_STATUS_TRIM),
+	DACXO_STATUS_CONTROL("FIFO Fill", DACXO_STATUS_FILL),
+};
+
+// Period constraints per latency profile, indexed by 'enum dacxo_latency_profile'.
+// The buffer must fit the 512KiB i2s dma buffer of the bcm2835, at 192kHz in 32-bit slots:
+// 1.5MB/s, so at most 340ms buffered.
+struct dacxo_latency_constraints {
+	unsigned int period_us_min;
+	unsigned int period_us_max;
+	unsigned int periods_min;
+	unsigned int periods_max;
+};
+
+static const struct dacxo_latency_constraints dacxo_latency_constraints[] = {
+	{   1000,   5000, 2, 4 },  // Low Latency: at most 20ms buffered
+	{  10000,  50000, 2, 6 },  // Balanced: at most 300ms buffered
+	{  20000,  80000, 2, 4 },  // Power Save: at most 320ms buffered, 480KiB at 192kHz
+};
+
+// Period sizes in whole multiples of 16 frames: of 64 bytes with 16-bit samples, 128 bytes with 24-bit
+// samples in their 32-bit slots of the 64x bclk frame. That gives whole dma bursts.
+#define DACXO_PERIOD_STEP_FRAMES 16
+
+// Install the period and buffer constraints of the latency profile, such that players
+// get a predictable buffer size rather than an arbitrary one.
+static int dacxo_set_latency_constraints(struct snd_pcm_runtime *runtime, enum dacxo_latency_profile profile)
+{
+	const struct dacxo_latency_constraints *c = &dacxo_latency_constraints[profile];
+	int err = snd_pcm_hw_constraint_minmax(runtime, SNDRV_PCM_HW_PARAM_PERIOD_TIME,
+	                                       c->period_us_min, c->period_us_max);
+	if (!err)
+		err = snd_pcm_hw_constraint_minmax(runtime, SNDRV_PCM_HW_PARAM_PERIODS, c->periods_min, c->periods_max);
+	if (!err)
+		err = snd_pcm_hw_constraint_integer(runtime, SNDRV_PCM_HW_PARAM_PERIODS);
+	if (!err)
+		err = snd_pcm_hw_constraint_step(runtime, 0, SNDRV_PCM_HW_PARAM_PERIOD_SIZE, DACXO_PERIOD_STEP_FRAMES);
+	return err;
+}
+
+// Stream rates per pinned oscillator family, indexed by 'enum dacxo_rate_family'.
+// Intersected with DACXO_RATES by the pcm core.
+static const unsigned int dacxo_family_rates[][3] = {
+	[DACXO_FAMILY_44K1] = { 44100, 88200, 176400 },
+	[DACXO_FAMILY_48K]  = { 48000, 96000, 192000 },
+};
+
+static const struct snd_pcm_hw_constraint_list dacxo_family_constraints[] = {
+	[DACXO_FAMILY_44K1] = { .count = 3, .list = dacxo_family_rates[DACXO_FAMILY_44K1] },
+	[DACXO_FAMILY_48K]  = { .count = 3, .list = dacxo_family_rates[DACXO_FAMILY_48K] },
 };
 
 /* startup */
 static int snd_rpi_dacxo_startup(struct snd_pcm_substream *substream) {
 	struct snd_soc_pcm_runtime *rtd = substream->private_data;
 	struct snd_soc_component *component = snd_soc_rtd_to_codec(rtd, 0)->component;
-	pr_info("dacxo_bcm:snd_rpi_dacxo_startup(): codec=%s Dummy!\n", component->name);
+	struct dacxo_bcm_priv *priv = snd_soc_card_get_drvdata(rtd->card);
+	const enum dacxo_latency_profile profile = READ_ONCE(priv->latency_profile);
+	pr_debug("dacxo_bcm:snd_rpi_dacxo_startup(): codec=%s latency profile %d\n", component->name, profile);
+
+	int err = dacxo_set_latency_constraints(substream->runtime, profile);
+	if (err) {
+		dev_err(rtd->card->dev, "dacxo_bcm: startup: latency constraints error %d\n", err);
+		return err;
+	}
+
+	// a pinned family: the ALSA plug resamples to the nearest rate of that family
+	const enum dacxo_rate_family family = READ_ONCE(priv->rate_family);
+	if (family != DACXO_FAMILY_AUTO) {
+		err = snd_pcm_hw_constraint_list(substream->runtime, 0, SNDRV_PCM_HW_PARAM_RATE,
+		                                 &dacxo_family_constraints[family]);
+		if (err) {
+			dev_err(rtd->card->dev, "dacxo_bcm: startup: rate family constraint error %d\n", err);
+			return err;
+		}
+	}
+
+	mutex_lock(&priv->lock);
+	priv->stream_open++;  // a pending rate hint waits for the stream to close
+	mutex_unlock(&priv->lock);
 	return 0;
 }
 
@@ -308,20 +704,85 @@ static int snd_rpi_dacxo_startup(struct snd_pcm_substream *substream) {
 static void snd_rpi_dacxo_shutdown(struct snd_pcm_substream *substream) {
 	struct snd_soc_pcm_runtime *rtd = substream->private_data;
 	struct snd_soc_component *component = snd_soc_rtd_to_codec(rtd, 0)->component;
-	pr_info("dacxo_bcm:snd_rpi_dacxo_shutdown() codec=%s Dummy\n", component->name);
+	struct dacxo_bcm_priv *priv = snd_soc_card_get_drvdata(rtd->card);
+	pr_debug("dacxo_bcm:snd_rpi_dacxo_shutdown() codec=%s\n", component->name);
+
+	mutex_lock(&priv->lock);
+	priv->stream_open--;
+	const bool has_hint = !priv->stream_open && priv->rate_hint;
+	mutex_unlock(&priv->lock);
+	if (has_hint)
+		schedule_delayed_work(&priv->rate_hint_work, 0);
+}
+
+// Idle time without stream after which the analog power is switched off, 0 disables
+static unsigned int autosuspend_ms = 300000;
+module_param(autosuspend_ms, uint, 0644);
+MODULE_PARM_DESC(autosuspend_ms, "Idle time in ms until analog power-down of the DAC, 0 to disable");
+
+static void dacxo_pcm1792_hold(struct i2c_client *dac);
+
+// Switch off the analog power, keeping the pcm1792 registers in their regmap caches for the next power-up.
+// Only the POWERUP bit gets cleared: the input selection and rate family remain, such that
+// the next stream at the same rate starts without clock config writes.
+static void dacxo_suspend(struct dacxo_bcm_priv *priv, const char *reason)
+{
+	unsigned int gpo0 = 0;
+
+	mutex_lock(&priv->lock);
+	int err = regmap_read(priv->fpga_regs, REGDAC_GPO0, &gpo0);
+	// Leave the power as is when the UI controller selected an s/pdif input,
+	// or when it is not on or not controlled by this driver
+	if (err || priv->stream_open || !(gpo0 & GPO0_CLKMASTER) || !(gpo0 & GPO0_POWERUP) ||
+	    priv->power_state != DACXO_POWER_ON) {
+		mutex_unlock(&priv->lock);
+		return;
+	}
+
+	dacxo_lease_acquire(priv);
+	dacxo_pcm1792_hold(priv->dac_l);
+	dacxo_pcm1792_hold(priv->dac_r);
+	err = regmap_update_bits(priv->fpga_regs, REGDAC_GPO0, GPO0_POWERUP, 0);
+	trace_dacxo_i2c(priv->fpga->name, REGDAC_GPO0, 1, true, err);
+	dacxo_lease_release(priv, true);
+	if (err) {
+		priv->stats.i2c_errors[DACXO_DEV_FPGA]++;
+	} else {
+		priv->power_state = DACXO_POWER_OFF;
+		priv->autosuspended = true;
+		priv->stats.autosuspends++;
+	}
+	mutex_unlock(&priv->lock);
+	trace_dacxo_power(DACXO_POWER_OFF, 0, 0, err);
+	pr_info("dacxo_bcm: %s: analog power off, err=%d\n", reason, err);
+}
+
+static void dacxo_autosuspend_work(struct work_struct *work)
+{
+	struct dacxo_bcm_priv *priv = container_of(to_delayed_work(work), struct dacxo_bcm_priv, autosuspend_work);
+	dacxo_suspend(priv, "autosuspend");
 }
 
 /* card suspend */
 static int dacxo_suspend_post(struct snd_soc_card *card)
 {
-	pr_info("dacxo_bcm: dacxo_suspend_post() Dummy\n");
+	struct dacxo_bcm_priv *priv = snd_soc_card_get_drvdata(card);
+	pr_debug("dacxo_bcm: dacxo_suspend_post()\n");
+
+	cancel_delayed_work_sync(&priv->autosuspend_work);
+	cancel_delayed_work_sync(&priv->status_work);
+	dacxo_suspend(priv, "suspend");
 	return 0;
 }
 
 /* card resume */
 static int dacxo_resume_pre(struct snd_soc_card *card)
 {
-	pr_info("dacxo_bcm: dacxo_resume_pre() Dummy\n");
+	struct dacxo_bcm_priv *priv = snd_soc_card_get_drvdata(card);
+	pr_debug("dacxo_bcm: dacxo_resume_pre()\n");
+
+	// the analog power comes back with the next stream, through the DAPM power event
+	schedule_delayed_work(&priv->status_work, 0);
 	return 0;
 }
 
@@ -349,6 +810,85 @@ static struct snd_soc_dai_link dacxo_dai_link[] = {
 },
 };
 
+// The analog power (Vana) comes up about 0.1s after switching the power relay.
+// Poll for it from a work item, such that the DAPM power event does not block the stream open.
+#define DACXO_POWER_POLL_MS      50
+#define DACXO_POWER_TIMEOUT_MS 1000
+
+// Write the regmap cache content to a pcm1792 that just got its power
+static int dacxo_pcm1792_restore(struct i2c_client *dac)
+{
+	struct regmap *regs = dev_get_regmap(&dac->dev, NULL);
+	regcache_cache_only(regs, false);
+	// Mark the register cache as "Dirty", then "Sync" to write cached values
+	regcache_mark_dirty(regs);
+	return regcache_sync(regs);
+}
+
+// Hold a pcm1792 muted while unpowered: register writes go to the cache only
+static void dacxo_pcm1792_hold(struct i2c_client *dac)
+{
+	struct regmap *regs = dev_get_regmap(&dac->dev, NULL);
+	regcache_cache_only(regs, true);
+	regmap_update_bits(regs, PCM1792A_SOFT_MUTE, PCM1792A_MUTE_MASK, PCM1792A_MUTE_MASK);
+}
+
+static void dacxo_power_work(struct work_struct *work)
+{
+	struct dacxo_bcm_priv *priv = container_of(to_delayed_work(work), struct dacxo_bcm_priv, power_work);
+
+	unsigned int gpi1_val = 0;
+	mutex_lock(&priv->lock);
+	dacxo_lease_acquire(priv);
+	int err = regmap_read(priv->fpga_regs, REGDAC_GPI1, &gpi1_val);
+	dacxo_lease_release(priv, false);
+	mutex_unlock(&priv->lock);
+	bool is_powered = !err && (gpi1_val & GPI1_ANAPWR) != 0;
+	priv->power_polls++;
+	if (!is_powered && priv->power_polls * DACXO_POWER_POLL_MS < DACXO_POWER_TIMEOUT_MS) {
+		schedule_delayed_work(&priv->power_work, msecs_to_jiffies(DACXO_POWER_POLL_MS));
+		return;
+	}
+	const u32 elapsed_ms = ktime_ms_delta(ktime_get(), priv->power_start);
+	pr_debug("dacxo_bcm: power_work: DAC rails: regmap_err=%d, gpi1=0x%02x, Vana confirmed=%d after %u ms\n",
+		err, gpi1_val, is_powered, elapsed_ms);
+	if (err)
+		priv->stats.i2c_errors[DACXO_DEV_FPGA]++;
+
+	mutex_lock(&priv->lock);
+	dacxo_lease_acquire(priv);
+	/* Now that DACs have power, initialize them via I2C */
+	if (is_powered) {
+		pr_debug("dacxo_bcm: flush regmap cache to pcm1792 dacs");
+		// one regcache_sync per chip: after an autosuspend, the caches hold the exact register content
+		int err_l = dacxo_pcm1792_restore(priv->dac_l);
+		int err_r = dacxo_pcm1792_restore(priv->dac_r);
+		if (err_l || err_r) {
+			pr_warn("dacxo_bcm: regmap flush&sync: left err=%d, right err=%d!\n", err_l, err_r);
+			priv->stats.i2c_errors[DACXO_DEV_DAC_L] += (err_l != 0);
+			priv->stats.i2c_errors[DACXO_DEV_DAC_R] += (err_r != 0);
+		}
+		// unmute only after both chips have their mode and volume
+		regmap_update_bits(dev_get_regmap(&priv->dac_l->dev, NULL), PCM1792A_SOFT_MUTE, PCM1792A_MUTE_MASK, 0);
+		regmap_update_bits(dev_get_regmap(&priv->dac_r->dev, NULL), PCM1792A_SOFT_MUTE, PCM1792A_MUTE_MASK, 0);
+		priv->power_state = DACXO_POWER_ON;
+		priv->stats.power_ups++;
+		dacxo_hist_add(&priv->stats.power_up_ms, elapsed_ms);
+		dacxo_probe_stage(DACXO_PROBE_PLAYABLE);
+		if (priv->autosuspended)
+			pr_info("dacxo_bcm: resume from autosuspend in %u ms\n", elapsed_ms);
+		priv->autosuspended = false;
+	} else {
+		// the dac registers remain in the cache, to be restored on a next power-up
+		pr_err("dacxo_pcm: power_work: power-up DAC rails failed (err=%d)!", err);
+		priv->power_state = DACXO_POWER_OFF;
+		priv->stats.power_up_timeouts++;
+	}
+	trace_dacxo_power(priv->power_state, gpi1_val, elapsed_ms, err);
+	dacxo_lease_release(priv, true);  // the UI controller reads back the completed power-up
+	mutex_unlock(&priv->lock);
+}
+
 static int dacxo_bcm_power_event(struct snd_soc_dapm_widget *w,
                                  struct snd_kcontrol *kcontrol, int event)
 {
@@ -369,58 +909,253 @@ static int dacxo_bcm_power_event(struct snd_soc_dapm_widget *w,
 	}
 	bool power_is_on = (gpo0_val & GPO0_POWERUP) != 0;
 
+  if (SND_SOC_DAPM_EVENT_OFF(event)) {
+		// no more stream: switch off the analog power after the idle time
+		if (autosuspend_ms)
+			mod_delayed_work(system_wq, &priv->autosuspend_work, msecs_to_jiffies(autosuspend_ms));
+		return 0;
+	}
+
   if (SND_SOC_DAPM_EVENT_ON(event)) {
-    dev_info(card->dev, "DACXO: Powering up DAC rails, (power switch state is %d)\n", power_is_on);
-		if (power_is_on)
-			return 0;
+    dev_dbg(card->dev, "DACXO: Powering up DAC rails, (power switch state is %d)\n", power_is_on);
+		cancel_delayed_work(&priv->autosuspend_work);  // it skips anyway while a stream is open
+		if (power_is_on && priv->power_state != DACXO_POWER_OFF)
+			return 0;  // powered, or a power-up is still in progress
+		// else: power off, or switched on outside the DAPM framework with unknown dac register state
+
+    /* A. Hold playback muted until the DACs are powered, volume changes go to the cache meanwhile */
+		mutex_lock(&priv->lock);
+		dacxo_lease_acquire(priv);
+		dacxo_pcm1792_hold(priv->dac_l);
+		dacxo_pcm1792_hold(priv->dac_r);
+
+    /* B. Tell FPGA to power ON the DACs */
+		priv->power_start = ktime_get();
+		err = regmap_update_bits(priv->fpga_regs, REGDAC_GPO0, GPO0_POWERUP, GPO0_POWERUP);
+		trace_dacxo_i2c(priv->fpga->name, REGDAC_GPO0, 1, true, err);
+		if (err) {
+			priv->stats.i2c_errors[DACXO_DEV_FPGA]++;
+			dacxo_lease_release(priv, true);
+			mutex_unlock(&priv->lock);
+			pr_err("dacxo_pcm: power_event: power-up DAC rails failed (err=%d)!", err);
+			return err;
+		}
+		// no change signal yet: the UI controller reads back once the power work completed the power-up
+		dacxo_lease_release(priv, false);
+
+    /* C. Wait for analog power to come up slowly, the power work completes the power-up */
+		priv->power_polls = 0;
+		priv->power_state = DACXO_POWER_WAIT;
+		mutex_unlock(&priv->lock);
+		trace_dacxo_power(DACXO_POWER_WAIT, 0, 0, 0);
+		schedule_delayed_work(&priv->power_work, msecs_to_jiffies(DACXO_POWER_POLL_MS));
+  }
+  return 0;
+}
 
-		gpiod_set_value(priv->uisync_gpio, 0);  // pull-down 'uisync' pin: signal UI controller on change and stay silent
+// Re-read a register range in one i2c burst, and put the obtained values in the regmap cache
+static int dacxo_reread_regs(struct regmap *regs, unsigned int first, uint8_t *vals, size_t count)
+{
+	regcache_cache_bypass(regs, true);
+	int err = regmap_raw_read(regs, first, vals, count);
+	regcache_cache_bypass(regs, false);
+	trace_dacxo_i2c(dev_name(regmap_get_device(regs)), first, count, false, err);
+	if (err) {
+		regcache_drop_region(regs, first, first + count - 1);  // unknown: read again on next use
+		return err;
+	}
+	// update the cache without writing back to the chip
+	regcache_cache_only(regs, true);
+	for (size_t i = 0; i < count; i++)
+		regmap_write(regs, first + i, vals[i]);
+	regcache_cache_only(regs, false);
+	return 0;
+}
 
-    /* A. Tell FPGA to power ON the DACs */
-		err = regmap_update_bits(priv->fpga_regs, REGDAC_GPO0, GPO0_POWERUP, GPO0_POWERUP);
+// Both edges of the 'uinotify' line: the bus lease of the UI controller. Its lease held for
+// the change time signals that it changed volume, input select or power: wake the irq thread.
+// A short pulse might show its release level on both edges: only count the leases with a start.
+static irqreturn_t dacxo_uinotify_irq(int irq, void *data)
+{
+	struct dacxo_bcm_priv *priv = data;
+	const ktime_t now = ktime_get();
 
-    /* B. Wait for analog power to come up slowly */
-		bool is_powered = false;
-		for (int i = 0; i < 5; i++) {
-	    unsigned int gpi1_val = 0;
-      err = regmap_read(priv->fpga_regs, REGDAC_GPI1, &gpi1_val);
-		  if (!err) {
-			  is_powered = (gpi1_val & GPI1_ANAPWR) != 0;
-		  }
-			pr_info("dacxo_bcm: power_event: DAC rails: regmap_err=%d, gpi1=0x%02x, Vana confirmed=%d\n",
-				err, gpi1_val, is_powered);
-			if (is_powered)
-			  break;
-
-			msleep(200);  // milliseconds: wait and retry..
-		}
+	if (gpiod_get_value(priv->uinotify_gpio) == 0) {
+		priv->peer_lease_start = now;
+		return IRQ_HANDLED;
+	}
+	if (!priv->peer_lease_start)
+		return IRQ_HANDLED;
+	const s64 hold_us = ktime_us_delta(now, priv->peer_lease_start);
+	priv->peer_lease_start = 0;
+	priv->stats.peer_leases++;
+	return (hold_us >= DACXO_LEASE_CHANGE_US) ? IRQ_WAKE_THREAD : IRQ_HANDLED;
+}
 
-    /* C. Now that DACs have power, initialize them via I2C */
-		if (is_powered) {
-			pr_info("dacxo_bcm: flush regmap cache to pcm1792 dacs");
-      // Mark the register cache as "Dirty", then "Sync" to write cached values
-			struct regmap *regs = dev_get_regmap(&priv->dac_l->dev, NULL);
-      regcache_mark_dirty(regs);
-      int err_l = regcache_sync(regs);
-
-			regs = dev_get_regmap(&priv->dac_r->dev, NULL);
-      regcache_mark_dirty(regs);
-      int err_r = regcache_sync(regs);
-			if (err_l || err_r) {
-			  pr_warn("dacxo_bcm: regmap flush&sync: left err=%d, right err=%d!\n", err_l, err_r);
-			}
+// The UI controller signaled its changes through the 'uinotify' line.
+// Refresh the register caches, and inform ALSA of the control changes, such as for mixer apps.
+static irqreturn_t dacxo_uinotify_thread(int irq, void *data)
+{
+	struct dacxo_bcm_priv *priv = data;
+	uint8_t gpo[2];
+	uint8_t vol_l[2];
+	uint8_t vol_r[2];
+
+	priv->stats.uinotify_irqs++;
+	mutex_lock(&priv->lock);
+	dacxo_lease_acquire(priv);
+	unsigned int prev_gpo0 = 0;
+	regmap_read(priv->fpga_regs, REGDAC_GPO0, &prev_gpo0);  // from the cache
+	int err = dacxo_reread_regs(priv->fpga_regs, REGDAC_GPO0, gpo, ARRAY_SIZE(gpo));
+	if (err) {
+		priv->stats.i2c_errors[DACXO_DEV_FPGA]++;
+		dacxo_lease_release(priv, false);
+		mutex_unlock(&priv->lock);
+		pr_warn("dacxo_bcm: uinotify: fpga read err=%d\n", err);
+		return IRQ_HANDLED;
+	}
+	pr_debug("dacxo_bcm: uinotify: gpo0=0x%02x gpo1=0x%02x\n", gpo[0], gpo[1]);
+
+	// The dacs are only accessible with their power on, and have their registers restored
+	bool vol_changed = false;
+	// (not after a power-up by the UI controller: the regmaps then remain cache-only until the next stream)
+	if ((gpo[0] & GPO0_POWERUP) && priv->power_state == DACXO_POWER_ON) {
+		struct regmap *regs_l = dev_get_regmap(&priv->dac_l->dev, NULL);
+		struct regmap *regs_r = dev_get_regmap(&priv->dac_r->dev, NULL);
+		err = dacxo_reread_regs(regs_l, PCM1792A_DAC_VOL_LEFT, vol_l, ARRAY_SIZE(vol_l));
+		if (err) {
+			priv->stats.i2c_errors[DACXO_DEV_DAC_L]++;
 		} else {
-			pr_err("dacxo_pcm: power_event: power-up DAC rails failed (err=%d)!", err);
+			err = dacxo_reread_regs(regs_r, PCM1792A_DAC_VOL_LEFT, vol_r, ARRAY_SIZE(vol_r));
+			if (err)
+				priv->stats.i2c_errors[DACXO_DEV_DAC_R]++;
 		}
-		gpiod_set_value(priv->uisync_gpio, 1);  // release pull-down 'uisync' pin
-  }
-  return err;
+		if (!err) {
+			// convert the chip attenuation back to the ALSA volume, see dacxo_set_attenuation()
+			const unsigned int relay_att = (gpo[1] & GPO1_ATT20DB) ? 20 : 0;
+			const unsigned int att_l = (vol_l[0] == 0) ? DAC_max_attenuation_dB : (255 - vol_l[0]) / 2 + relay_att;
+			const unsigned int att_r = (vol_r[0] == 0) ? DAC_max_attenuation_dB : (255 - vol_r[0]) / 2 + relay_att;
+			const uint32_t vol = ((DAC_max_attenuation_dB - min_t(unsigned int, att_l, DAC_max_attenuation_dB)) << 16) |
+			                     (DAC_max_attenuation_dB - min_t(unsigned int, att_r, DAC_max_attenuation_dB));
+			vol_changed = (vol != READ_ONCE(priv->target_volume));
+			// the controller applied it already: no need for the volume work to write it again
+			priv->prev_volume = vol;
+			WRITE_ONCE(priv->target_volume, vol);
+		} else {
+			pr_warn("dacxo_bcm: uinotify: pcm1792 read err=%d\n", err);
+		}
+	}
+	dacxo_lease_release(priv, false);
+	mutex_unlock(&priv->lock);
+
+	if (vol_changed && priv->volume_kctl)
+		snd_ctl_notify(priv->card->snd_card, SNDRV_CTL_EVENT_MASK_VALUE, &priv->volume_kctl->id);
+	// the input control reads the refreshed regmap cache
+	const bool input_changed = ((prev_gpo0 ^ gpo[0]) & GPO0_CLKMASK) != 0;
+	if (input_changed && priv->input_kctl)
+		snd_ctl_notify(priv->card->snd_card, SNDRV_CTL_EVENT_MASK_VALUE, &priv->input_kctl->id);
+
+	return IRQ_HANDLED;
+}
+
+// Optional 'uinotify' line from the UI controller, as in the DTS overlay file
+static int dacxo_uinotify_init(struct platform_device *pdev, struct dacxo_bcm_priv *priv)
+{
+	priv->uinotify_gpio = devm_gpiod_get_optional(&pdev->dev, "uinotify", GPIOD_IN);
+	if (IS_ERR(priv->uinotify_gpio))
+		return PTR_ERR(priv->uinotify_gpio);
+	if (!priv->uinotify_gpio) {
+		pr_info("dacxo_bcm: no 'uinotify' gpio pin: UI controller changes are not notified\n");
+		return 0;
+	}
+
+	priv->volume_kctl = snd_soc_card_get_kcontrol(priv->card, "Master");
+	priv->input_kctl = snd_soc_card_get_kcontrol(priv->card, "Input Source");
+
+	int irq = gpiod_to_irq(priv->uinotify_gpio);
+	if (irq < 0)
+		return irq;
+	// not oneshot: the lease edges remain timestamped while the thread refreshes
+	int err = devm_request_threaded_irq(&pdev->dev, irq, dacxo_uinotify_irq, dacxo_uinotify_thread,
+	                                    IRQF_TRIGGER_FALLING | IRQF_TRIGGER_RISING, "dacxo-uinotify", priv);
+	if (!err)
+		pr_info("dacxo_bcm: successfully acquired 'uinotify' gpio pin, irq %d\n", irq);
+	return err;
+}
+
+static void dacxo_hist_show(struct seq_file *s, const char *name, const char *unit, const struct dacxo_hist *hist)
+{
+	u32 count = 0;
+	for (int i = 0; i < DACXO_HIST_BUCKETS; i++)
+		count += hist->count[i];
+	seq_printf(s, "%s: count %u, mean %llu %s, max %u %s\n", name, count,
+	           count ? div_u64(hist->sum, count) : 0, unit, hist->max, unit);
+	for (int i = 0; i < DACXO_HIST_BUCKETS; i++) {
+		if (hist->count[i])
+			seq_printf(s, "  < %8u %s: %u\n", 1u << i, unit, hist->count[i]);
+	}
+}
+
+static int dacxo_stats_show(struct seq_file *s, void *data)
+{
+	const struct dacxo_bcm_priv *priv = s->private;
+	const struct dacxo_stats *stats = &priv->stats;
+
+	seq_printf(s, "rate_switches: %u\n", stats->rate_switches);
+	seq_printf(s, "power_ups: %u\n", stats->power_ups);
+	seq_printf(s, "power_up_timeouts: %u\n", stats->power_up_timeouts);
+	seq_printf(s, "autosuspends: %u\n", stats->autosuspends);
+	seq_printf(s, "volume_applies: %u\n", stats->volume_applies);
+	seq_printf(s, "uinotify_irqs: %u\n", stats->uinotify_irqs);
+	seq_printf(s, "writes_saved: %u\n", stats->writes_saved);
+	seq_printf(s, "rate_hints: %u, preselects: %u, family switches on stream start: %u\n",
+	           stats->rate_hints, stats->rate_preselects, stats->rate_family_switches);
+	seq_printf(s, "i2c_errors: fpga %u, dac_l %u, dac_r %u\n", stats->i2c_errors[DACXO_DEV_FPGA],
+	           stats->i2c_errors[DACXO_DEV_DAC_L], stats->i2c_errors[DACXO_DEV_DAC_R]);
+	seq_printf(s, "lease: acquires %u, contentions %u, timeouts %u, overruns %u, ui controller leases %u\n",
+	           stats->lease_acquires, stats->lease_contentions, stats->lease_timeouts, stats->lease_overruns,
+	           stats->peer_leases);
+	dacxo_hist_show(s, "rate_switch", "us", &stats->rate_switch_us);
+	dacxo_hist_show(s, "power_up", "ms", &stats->power_up_ms);
+	dacxo_hist_show(s, "volume_apply", "us", &stats->volume_apply_us);
+	dacxo_hist_show(s, "lease_wait", "us", &stats->lease_wait_us);
+	dacxo_hist_show(s, "lease_hold", "us", &stats->lease_hold_us);
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(dacxo_stats);
+
+// Writing anything to 'dacxo/reset' clears the statistics
+static int dacxo_stats_reset(void *data, u64 val)
+{
+	struct dacxo_bcm_priv *priv = data;
+	memset(&priv->stats, 0, sizeof(priv->stats));
+	return 0;
+}
+DEFINE_SIMPLE_ATTRIBUTE(dacxo_stats_reset_fops, NULL, dacxo_stats_reset, "%llu\n");
+
+static int dacxo_probe_show(struct seq_file *s, void *data)
+{
+	seq_printf(s, "probe attempts: %u, first at %lld ms since boot\n", dacxo_probe_times.attempts,
+	           ktime_to_ms(dacxo_probe_times.first_probe));
+	ktime_t prev = dacxo_probe_times.stage[DACXO_PROBE_START];
+	for (int i = 0; i < DACXO_NUM_PROBE_STAGES; i++) {
+		ktime_t t = dacxo_probe_times.stage[i];
+		if (!t) {
+			seq_printf(s, "%s: -\n", dacxo_probe_stage_names[i]);
+			continue;
+		}
+		seq_printf(s, "%s: %lld.%03lld ms since boot, +%lld us\n", dacxo_probe_stage_names[i],
+		           ktime_to_us(t) / 1000, ktime_to_us(t) % 1000, ktime_us_delta(t, prev));
+		prev = t;
+	}
+	return 0;
 }
+DEFINE_SHOW_ATTRIBUTE(dacxo_probe);
 
 /* 2. Define the Widget and Route */
 static const struct snd_soc_dapm_widget dacxo_bcm_widgets[] = {
     SND_SOC_DAPM_SUPPLY("DAC_Rails", SND_SOC_NOPM, 0, 0, dacxo_bcm_power_event,
-                        SND_SOC_DAPM_POST_PMU),
+                        SND_SOC_DAPM_POST_PMU | SND_SOC_DAPM_PRE_PMD),
 		SND_SOC_DAPM_HP("Main Output", NULL), // A "Sink" for the audio
 };
 
@@ -472,6 +1207,10 @@ static int snd_dacxo_probe(struct platform_device *pdev)
 	int ret = 0;
 	struct device_node *np = pdev->dev.of_node;
 	dacxo_sound_card.dev = &pdev->dev;
+
+	if (!dacxo_probe_times.attempts++)
+		dacxo_probe_times.first_probe = ktime_get_boottime();
+	dacxo_probe_stage(DACXO_PROBE_START);
 	
 	if (np) {
     pr_info("dacxo_bcm: start probe(), device node \"%s\"\n", np->name);
@@ -488,6 +1227,16 @@ static int snd_dacxo_probe(struct platform_device *pdev)
     return -ENOMEM;
 	}
 	snd_soc_card_set_drvdata(&dacxo_sound_card, priv);
+	priv->card = &dacxo_sound_card;
+	mutex_init(&priv->lock);
+	INIT_DELAYED_WORK(&priv->power_work, dacxo_power_work);
+	INIT_DELAYED_WORK(&priv->volume_work, dacxo_volume_work);
+	INIT_DELAYED_WORK(&priv->status_work, dacxo_status_work);
+	INIT_DELAYED_WORK(&priv->rate_hint_work, dacxo_rate_hint_work);
+	INIT_DELAYED_WORK(&priv->autosuspend_work, dacxo_autosuspend_work);
+	priv->power_state = DACXO_POWER_OFF;
+	priv->latency_profile = DACXO_LATENCY_BALANCED;
+	priv->rate_family = DACXO_FAMILY_AUTO;
 
 	// Obtain access to the gpio pin "uisync" to send signals to the UI controller
 	// The "uisync" name and its gpio pin are defined in the DTS overlay file
@@ -503,6 +1252,7 @@ static int snd_dacxo_probe(struct platform_device *pdev)
 		  pr_info("dacxo_bcm: successfully acquired 'uisync' gpio pin!\n");
 	  }
 	}
+	dacxo_probe_stage(DACXO_PROBE_GPIO);
 
 	struct snd_soc_dai_link *dai = &dacxo_dai_link[0];
 	/* find my three i2c components on the dac board: an FPGA and two PCM1792 */
@@ -532,7 +1282,10 @@ static int snd_dacxo_probe(struct platform_device *pdev)
   priv->fpga  = clients[0];
   priv->dac_l = clients[1];
   priv->dac_r = clients[2];
+	if (ret == 0)
+		dacxo_probe_stage(DACXO_PROBE_I2C);
 	priv->prev_volume = 0;
+	priv->target_volume = 0;
   priv->fpga_regs = NULL;
 
 	// Obtain access to the FPGA i2c registers.
@@ -561,6 +1314,9 @@ static int snd_dacxo_probe(struct platform_device *pdev)
 	  }
   }
 
+	if (ret == 0)
+		dacxo_probe_stage(DACXO_PROBE_REGMAPS);
+
 	// Find the i2s (dai) interface from the card to the codec:
 	struct device_node *i2s_node = of_parse_phandle(np, "i2s-controller", 0);
 	if (!i2s_node) {
@@ -596,6 +1352,19 @@ static int snd_dacxo_probe(struct platform_device *pdev)
     dev_warn(&pdev->dev, "dacxo_bcm: probe: register_card: \"%s\", return %d\n", msg, ret);
 	} else {
 		pr_info("dacxo_bcm: probe: Register_card: Success!\n");
+		dacxo_probe_stage(DACXO_PROBE_REGISTERED);
+		// the status controls get notified from their sampler
+		for (int i = 0; i < DACXO_NUM_STATUS; i++)
+			priv->status_kctl[i] = snd_soc_card_get_kcontrol(priv->card, dacxo_status_names[i]);
+		schedule_delayed_work(&priv->status_work, 0);
+		priv->debugfs = debugfs_create_dir("dacxo", NULL);
+		debugfs_create_file("stats", 0444, priv->debugfs, priv, &dacxo_stats_fops);
+		debugfs_create_file("reset", 0200, priv->debugfs, priv, &dacxo_stats_reset_fops);
+		debugfs_create_file("probe", 0444, priv->debugfs, NULL, &dacxo_probe_fops);
+		// with the card and its controls registered, accept notifications from the UI controller
+		int notify_err = dacxo_uinotify_init(pdev, priv);
+		if (notify_err)
+			dev_warn(&pdev->dev, "dacxo_bcm: probe: 'uinotify' gpio pin error %d, continue without\n", notify_err);
 	}
 
 	// fix refcount of_node_get()/of_node_put()
@@ -609,7 +1378,18 @@ static int snd_dacxo_probe(struct platform_device *pdev)
 /* sound card disconnect */
 static void snd_dacxo_remove(struct platform_device *pdev)
 {
-	pr_info("dacxo_bcm:snd_rpi_dacxo_remove(): power-down DUMMY\n");
+	struct dacxo_bcm_priv *priv = snd_soc_card_get_drvdata(&dacxo_sound_card);
+
+	pr_info("dacxo_bcm:snd_rpi_dacxo_remove()\n");
+	if (priv) {
+		debugfs_remove_recursive(priv->debugfs);
+		priv->debugfs = NULL;
+		cancel_delayed_work_sync(&priv->status_work);
+		cancel_delayed_work_sync(&priv->rate_hint_work);
+		cancel_delayed_work_sync(&priv->autosuspend_work);
+		cancel_delayed_work_sync(&priv->volume_work);
+		cancel_delayed_work_sync(&priv->power_work);
+	}
 }
 
 static const struct of_device_id dacxo_of_match[] = {
@@ -624,56 +1404,102 @@ static struct platform_driver snd_rpi_dacxo_driver = {
 		.name   = "snd-rpi-dacxo_bcm",
 		.owner  = THIS_MODULE,
 		.of_match_table = dacxo_of_match,
+		.probe_type = PROBE_PREFER_ASYNCHRONOUS,  // do not hold up the boot on i2c and deferred probes
 	},
 	.probe          = snd_dacxo_probe,
 	.remove         = snd_dacxo_remove,
 };
 module_platform_driver(snd_rpi_dacxo_driver);
 
-static void dacxo_set_attenuation_pcm1792(struct i2c_client *dac, uint16_t att)
+// @return true if the (cached) register content differs from 'val', or is unknown
+static bool dacxo_reg_differs(struct regmap *regs, unsigned int reg, unsigned int val)
+{
+	unsigned int cur;
+	return regmap_read(regs, reg, &cur) || (cur != val);
+}
+
+static unsigned int dacxo_pcm1792_chip_att(uint16_t att)
 {
-	unsigned int chip_att = (att >= DAC_max_attenuation_dB) ? 0 : (255 - 2 * att);
 	// For the chip register: 255 is 0dB attenuation, full volume. Lower values give 0.5dB per step
-	// write att value to both left and right on-chip channel, as we use mono mode
-	struct regmap *regs = dev_get_regmap(&dac->dev, NULL);
-	int err = regmap_write(regs, PCM1792A_DAC_VOL_LEFT, chip_att);
-	if (!err)
-	  err = regmap_write(regs, PCM1792A_DAC_VOL_RIGHT, chip_att);
+	return (att >= DAC_max_attenuation_dB) ? 0 : (255 - 2 * att);
+}
+
+static bool dacxo_pcm1792_att_differs(struct regmap *regs, unsigned int chip_att)
+{
+	return dacxo_reg_differs(regs, PCM1792A_DAC_VOL_LEFT, chip_att) ||
+	       dacxo_reg_differs(regs, PCM1792A_DAC_VOL_RIGHT, chip_att);
+}
+
+static int dacxo_set_attenuation_pcm1792(struct i2c_client *dac, struct regmap *regs, unsigned int chip_att)
+{
+	// write att value to both left and right on-chip channel, as we use mono mode.
+	// One i2c transaction, using the register auto-increment of the pcm1792
+	const uint8_t vol[2] = { chip_att, chip_att };
+	int err = regmap_bulk_write(regs, PCM1792A_DAC_VOL_LEFT, vol, ARRAY_SIZE(vol));
+	trace_dacxo_i2c(dac->name, PCM1792A_DAC_VOL_LEFT, ARRAY_SIZE(vol), true, err);
 
   if (err) {
 		dev_warn(&dac->dev, "dacxo_bcm: set_attenuation_pcn1792(): write err=%d\n", err);
 	}
+	return err;
 }
 
-static void dacxo_set_attenuation( struct dacxo_bcm_priv *priv, uint16_t att_l, uint16_t att_r)
+// @return The number of written registers: 0 if the registers had this attenuation already
+static unsigned int dacxo_set_attenuation( struct dacxo_bcm_priv *priv, uint16_t att_l, uint16_t att_r)
 {
 	// att_? values are attenuation in dBs: 0 is max volume, 79 is min volume, 80 is mute
   int enable_20dB_att = (att_l >= 20) && (att_r >= 20);
   int mute = (att_l >= DAC_max_attenuation_dB) && (att_r >= DAC_max_attenuation_dB);
 	
-	pr_info("dacxo_bcm: set_attenuation(att_l=%u att_r=%u)\n", att_l, att_r);
+	pr_debug("dacxo_bcm: set_attenuation(att_l=%u att_r=%u)\n", att_l, att_r);
 	
   // adjust the analog volume attenuation -20dB relay if not totally silent
   if (enable_20dB_att && !mute) {
     att_l -= 20; // raise digital (dac) volume
     att_r -= 20; // raise digital (dac) volume
   }
-	
-	gpiod_set_value(priv->uisync_gpio, 0);  // pull-down 'uisync' pin: signal UI controller on change and stay silent
-	// write the board 20dB_attenuation to the fpga:
-	int err = regmap_write(priv->fpga_regs, REGDAC_GPO1, (enable_20dB_att ? GPO1_ATT20DB : 0));
-  if (err) {
-    pr_warn("dacxo_bcm: set_attenuation(): in \"%s\" i2c write: err=%d!\n", priv->fpga->name, err);
-    // continue further operation...
-  } else {
-		pr_info("dacxo_bcm: set_attenuation(): wrote enable_20db_att=%d\n", enable_20dB_att);
+
+	// Skip the writes that do not change the register content, as known by the regmap caches
+	struct regmap *regs_l = dev_get_regmap(&priv->dac_l->dev, NULL);
+	struct regmap *regs_r = dev_get_regmap(&priv->dac_r->dev, NULL);
+	const unsigned int relay = enable_20dB_att ? GPO1_ATT20DB : 0;
+	const unsigned int chip_att_l = dacxo_pcm1792_chip_att(att_l);
+	const unsigned int chip_att_r = dacxo_pcm1792_chip_att(att_r);
+	bool relay_changed = dacxo_reg_differs(priv->fpga_regs, REGDAC_GPO1, relay);
+	bool dac_l_changed = dacxo_pcm1792_att_differs(regs_l, chip_att_l);
+	bool dac_r_changed = dacxo_pcm1792_att_differs(regs_r, chip_att_r);
+	const unsigned int written = relay_changed + 2 * dac_l_changed + 2 * dac_r_changed;
+	priv->stats.writes_saved += 5 - written;
+	if (!written)
+		return 0;
+	ktime_t start = ktime_get();
+
+	dacxo_lease_acquire(priv);
+	if (relay_changed) {
+		// write the board 20dB_attenuation to the fpga:
+		int err = regmap_write(priv->fpga_regs, REGDAC_GPO1, relay);
+		trace_dacxo_i2c(priv->fpga->name, REGDAC_GPO1, 1, true, err);
+		if (err) {
+			priv->stats.i2c_errors[DACXO_DEV_FPGA]++;
+			pr_warn("dacxo_bcm: set_attenuation(): in \"%s\" i2c write: err=%d!\n", priv->fpga->name, err);
+			// continue further operation...
+		} else {
+			pr_debug("dacxo_bcm: set_attenuation(): wrote enable_20db_att=%d\n", enable_20dB_att);
+		}
 	}
 
 	// the pcm1792 dacs are used in dual-mono mode:
 	// write the volume to each of both codecs
-  dacxo_set_attenuation_pcm1792(priv->dac_l, att_l);
-  dacxo_set_attenuation_pcm1792(priv->dac_r, att_r);
-	gpiod_set_value(priv->uisync_gpio, 1);
+	if (dac_l_changed && dacxo_set_attenuation_pcm1792(priv->dac_l, regs_l, chip_att_l))
+		priv->stats.i2c_errors[DACXO_DEV_DAC_L]++;
+	if (dac_r_changed && dacxo_set_attenuation_pcm1792(priv->dac_r, regs_r, chip_att_r))
+		priv->stats.i2c_errors[DACXO_DEV_DAC_R]++;
+	const u32 duration_us = dacxo_elapsed_us(start);
+	dacxo_lease_release(priv, true);  // the UI controller reads back the new volume
+
+	dacxo_hist_add(&priv->stats.volume_apply_us, duration_us);
+	trace_dacxo_volume(att_l, att_r, enable_20dB_att, written, duration_us);
+	return written;
 }
 
 /*****************************************************************************/
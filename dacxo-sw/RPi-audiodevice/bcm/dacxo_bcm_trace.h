@@ -0,0 +1,113 @@
+/*
+ * Tracepoints of the ASOC driver for the 5th generation DAC by Jos van Eijndhoven
+ *
+ * Enable at runtime with, for instance:
+ *   echo 1 > /sys/kernel/tracing/events/dacxo_bcm/enable
+ *   cat /sys/kernel/tracing/trace_pipe
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM dacxo_bcm
+
+#if !defined(_DACXO_BCM_TRACE_H) || defined(TRACE_HEADER_MULTI_READ)
+#define _DACXO_BCM_TRACE_H
+
+#include <linux/tracepoint.h>
+
+// An i2c register access by the driver, on one of the three board devices
+TRACE_EVENT(dacxo_i2c,
+	TP_PROTO(const char *dev, unsigned int reg, unsigned int len, bool is_write, int err),
+	TP_ARGS(dev, reg, len, is_write, err),
+	TP_STRUCT__entry(
+		__string(dev, dev)
+		__field(unsigned int, reg)
+		__field(unsigned int, len)
+		__field(bool, is_write)
+		__field(int, err)
+	),
+	TP_fast_assign(
+		__assign_str(dev);
+		__entry->reg = reg;
+		__entry->len = len;
+		__entry->is_write = is_write;
+		__entry->err = err;
+	),
+	TP_printk("%s %s reg=0x%02x len=%u err=%d", __get_str(dev),
+	          __entry->is_write ? "write" : "read", __entry->reg, __entry->len, __entry->err)
+);
+
+// Analog power: 'state' as in 'enum dacxo_power_state', 'elapsed_ms' since the power relay switched on
+TRACE_EVENT(dacxo_power,
+	TP_PROTO(int state, unsigned int gpi1, unsigned int elapsed_ms, int err),
+	TP_ARGS(state, gpi1, elapsed_ms, err),
+	TP_STRUCT__entry(
+		__field(int, state)
+		__field(unsigned int, gpi1)
+		__field(unsigned int, elapsed_ms)
+		__field(int, err)
+	),
+	TP_fast_assign(
+		__entry->state = state;
+		__entry->gpi1 = gpi1;
+		__entry->elapsed_ms = elapsed_ms;
+		__entry->err = err;
+	),
+	TP_printk("state=%s gpi1=0x%02x elapsed=%ums err=%d",
+	          __print_symbolic(__entry->state, { 0, "off" }, { 1, "wait" }, { 2, "on" }),
+	          __entry->gpi1, __entry->elapsed_ms, __entry->err)
+);
+
+// A volume application: attenuation in dB per channel, and the registers that got written
+TRACE_EVENT(dacxo_volume,
+	TP_PROTO(unsigned int att_l, unsigned int att_r, bool relay, unsigned int written, unsigned int duration_us),
+	TP_ARGS(att_l, att_r, relay, written, duration_us),
+	TP_STRUCT__entry(
+		__field(unsigned int, att_l)
+		__field(unsigned int, att_r)
+		__field(bool, relay)
+		__field(unsigned int, written)
+		__field(unsigned int, duration_us)
+	),
+	TP_fast_assign(
+		__entry->att_l = att_l;
+		__entry->att_r = att_r;
+		__entry->relay = relay;
+		__entry->written = written;
+		__entry->duration_us = duration_us;
+	),
+	TP_printk("att_l=%u att_r=%u relay_20db=%d written=%u regs duration=%uus",
+	          __entry->att_l, __entry->att_r, __entry->relay, __entry->written, __entry->duration_us)
+);
+
+// A rate hint from the "Rate Hint" control: 'preselected' if the oscillator family got switched early
+TRACE_EVENT(dacxo_rate_hint,
+	TP_PROTO(int rate, unsigned int gpo0, bool preselected, int err),
+	TP_ARGS(rate, gpo0, preselected, err),
+	TP_STRUCT__entry(
+		__field(int, rate)
+		__field(unsigned int, gpo0)
+		__field(bool, preselected)
+		__field(int, err)
+	),
+	TP_fast_assign(
+		__entry->rate = rate;
+		__entry->gpo0 = gpo0;
+		__entry->preselected = preselected;
+		__entry->err = err;
+	),
+	TP_printk("rate=%d gpo0=0x%02x preselected=%d err=%d",
+	          __entry->rate, __entry->gpo0, __entry->preselected, __entry->err)
+);
+
+#endif /* _DACXO_BCM_TRACE_H */
+
+/* This part must be outside protection */
+#undef TRACE_INCLUDE_PATH
+#define TRACE_INCLUDE_PATH .
+#undef TRACE_INCLUDE_FILE
+#define TRACE_INCLUDE_FILE dacxo_bcm_trace
+#include <trace/define_trace.h>
@@ -18,17 +18,199 @@
 #ifndef _DACXO_H
 #define _DACXO_H
 
+#include <linux/bitops.h>
+#include <linux/delay.h>
+#include <linux/gpio/consumer.h>
+#include <linux/ktime.h>
+#include <linux/mutex.h>
+#include <linux/types.h>
+#include <linux/workqueue.h>
+
+// Analog power-up state, as advanced by the asynchronous power work in dacxo_bcm
+enum dacxo_power_state {
+	DACXO_POWER_OFF,   // or unknown: power switched on outside the DAPM framework
+	DACXO_POWER_WAIT,  // power relay switched on, waiting for Vana
+	DACXO_POWER_ON,    // Vana confirmed, pcm1792 registers restored
+};
+
+// Read-only status controls of the card, sampled by the status work in dacxo_bcm
+enum dacxo_status_ctl {
+	DACXO_STATUS_LOCK,  // "Input Lock": 1 if the output is locked onto its input
+	DACXO_STATUS_RATE,  // "Input Rate": sample rate in Hz, 0 without lock
+	DACXO_STATUS_TRIM,  // "Clock Trim": output clock steering Nom, Low, High
+	DACXO_STATUS_FILL,  // "FIFO Fill": fifo filling Nom, Low, High
+	DACXO_NUM_STATUS
+};
+
+// Latency profiles for the period and buffer constraints of a stream, as in dacxo_bcm
+enum dacxo_latency_profile {
+	DACXO_LATENCY_LOW,       // lip-sync sensitive sources, such as video
+	DACXO_LATENCY_BALANCED,
+	DACXO_LATENCY_POWERSAVE, // music playback: few wake-ups of the Pi
+	DACXO_NUM_LATENCY_PROFILES
+};
+
+// Restriction of the stream rates to one oscillator, as in dacxo_bcm. With the 'dacxo' rate
+// converter in asound.conf, the streams of the other family get resampled instead of switching.
+enum dacxo_rate_family {
+	DACXO_FAMILY_AUTO,
+	DACXO_FAMILY_44K1,
+	DACXO_FAMILY_48K,
+	DACXO_NUM_RATE_FAMILIES
+};
+
+// Log2 histogram: bucket 0 counts the zero values, bucket i>0 the values in [2^(i-1), 2^i).
+// The last bucket also collects all larger values.
+#define DACXO_HIST_BUCKETS 16
+
+struct dacxo_hist {
+	u32 count[DACXO_HIST_BUCKETS];
+	u32 max;
+	u64 sum;
+};
+
+static inline void dacxo_hist_add(struct dacxo_hist *hist, u32 val)
+{
+	unsigned int bucket = fls(val);
+	hist->count[(bucket < DACXO_HIST_BUCKETS) ? bucket : DACXO_HIST_BUCKETS - 1]++;
+	hist->sum += val;
+	if (val > hist->max)
+		hist->max = val;
+}
+
+static inline u32 dacxo_elapsed_us(ktime_t start)
+{
+	return (u32)ktime_us_delta(ktime_get(), start);
+}
+
+// The i2c devices on the board, to count errors per device
+enum dacxo_i2c_dev {
+	DACXO_DEV_FPGA,
+	DACXO_DEV_DAC_L,
+	DACXO_DEV_DAC_R,
+	DACXO_NUM_DEVS
+};
+
+// Runtime statistics, as reported in debugfs 'dacxo/stats' by dacxo_bcm.
+// Updated without locking: the counts are for profiling, a rare lost increment is acceptable.
+struct dacxo_stats {
+	u32 rate_switches;          // sample rate changes written by the codec
+	u32 power_ups;
+	u32 power_up_timeouts;      // Vana did not come up
+	u32 autosuspends;           // analog power switched off after the idle time
+	u32 volume_applies;         // runs of the volume work that changed the volume
+	u32 uinotify_irqs;
+	u32 i2c_errors[DACXO_NUM_DEVS];
+	u32 writes_saved;           // register writes skipped, as the (cached) content was up to date
+	u32 rate_hints;             // "Rate Hint" control writes
+	u32 rate_preselects;        // oscillator family switched early on a rate hint
+	u32 rate_family_switches;   // oscillator family switched on stream start: a missed or absent hint
+	u32 lease_acquires;         // i2c bus leases, see dacxo_lease_acquire()
+	u32 lease_contentions;      // the UI controller held the bus: waited for its release
+	u32 lease_timeouts;         // the UI controller held the bus beyond the timeout: taken anyway
+	u32 lease_overruns;         // own leases held beyond the timeout
+	u32 peer_leases;            // bus leases of the UI controller
+	struct dacxo_hist rate_switch_us;  // i2c write of the new clock config
+	struct dacxo_hist power_up_ms;     // power relay switch-on until Vana confirmed
+	struct dacxo_hist volume_apply_us; // i2c writes of a volume change
+	struct dacxo_hist lease_wait_us;   // of the contended leases
+	struct dacxo_hist lease_hold_us;
+};
+
 // somewhat dirty architecture to share the card 'private data' struct type
 // with the codec :-(   Just easy and pragmatic...
 struct dacxo_bcm_priv {
 	  struct gpio_desc *uisync_gpio;
+	  struct gpio_desc *uinotify_gpio;  // optional: pulled low by the UI controller after its changes
+		struct snd_soc_card *card;
+		struct snd_kcontrol *volume_kctl;
+		struct snd_kcontrol *input_kctl;
+		struct mutex lock;  // serializes the register update sequences of the controls, works and irq
 		struct i2c_client *fpga;
     struct i2c_client *dac_l;
     struct i2c_client *dac_r;
 		struct regmap *fpga_regs;
-    uint32_t prev_volume;
+    uint32_t prev_volume;    // applied ALSA volume: (left << 16) | right
+    uint32_t target_volume;  // as last set by the ALSA control, applied by the volume work
+		struct delayed_work volume_work;
+		struct delayed_work power_work;
+		enum dacxo_power_state power_state;
+		unsigned int power_polls;
+		ktime_t power_start;  // when the power relay got switched on
+		bool autosuspended;   // the analog power was switched off by the driver, with the dac registers cached
+		struct delayed_work autosuspend_work;
+		struct delayed_work status_work;
+		struct snd_kcontrol *status_kctl[DACXO_NUM_STATUS];
+		unsigned int status[DACXO_NUM_STATUS];  // as last sampled
+		struct dacxo_stats stats;
+		struct dentry *debugfs;
+		int stream_rate;       // of the open stream as from hw_params, applied by the codec prepare
+		unsigned int stream_open;
+		int rate_hint;         // announced rate of the next stream, 0 if none
+		struct delayed_work rate_hint_work;
+		enum dacxo_latency_profile latency_profile;  // for the next stream open
+		enum dacxo_rate_family rate_family;          // rates of the next stream open
+		ktime_t lease_start;       // of the own i2c bus lease
+		ktime_t peer_lease_start;  // of the bus lease of the UI controller, 0 if not seen
 };
 
+// I2c bus lease between this driver and the UI controller, the other master on the i2c bus.
+// Each side claims the bus by pulling its own line low: 'uisync' for the Pi, 'uinotify' for the
+// UI controller, and waits while the other line is low. On a simultaneous claim, the UI controller
+// backs off. A claim held for at least DACXO_LEASE_CHANGE_US signals register changes, for the
+// other side to read them back; shorter claims are read-only.
+// The ESPHome 'i2c_queue' component implements the UI controller side, with the same timing.
+#define DACXO_LEASE_SETTLE_US       5  // own claim visible to the UI controller
+#define DACXO_LEASE_POLL_US       100
+#define DACXO_LEASE_TIMEOUT_US  50000  // max hold time: a longer claim is considered stuck
+#define DACXO_LEASE_CHANGE_US    3000
+
+static inline bool dacxo_lease_peer_holds(struct dacxo_bcm_priv *priv)
+{
+	// without the optional 'uinotify' line, the claims of the UI controller are invisible
+	return priv->uinotify_gpio && gpiod_get_value(priv->uinotify_gpio) == 0;
+}
+
+// Claim the i2c bus for a sequence of register accesses. Call with priv->lock held.
+static inline void dacxo_lease_acquire(struct dacxo_bcm_priv *priv)
+{
+	ktime_t start = ktime_get();
+	bool contended = false;
+
+	gpiod_set_value(priv->uisync_gpio, 0);  // pull-down 'uisync' pin: claim the bus
+	udelay(DACXO_LEASE_SETTLE_US);
+	while (dacxo_lease_peer_holds(priv)) {
+		const s64 wait_us = ktime_us_delta(ktime_get(), start);
+		contended = true;
+		if (wait_us > DACXO_LEASE_TIMEOUT_US) {
+			priv->stats.lease_timeouts++;
+			pr_warn_ratelimited("dacxo: UI controller holds the i2c bus beyond %u us, taking it\n",
+			                    DACXO_LEASE_TIMEOUT_US);
+			break;
+		}
+		usleep_range(DACXO_LEASE_POLL_US, 2 * DACXO_LEASE_POLL_US);
+	}
+	priv->stats.lease_acquires++;
+	if (contended) {
+		priv->stats.lease_contentions++;
+		dacxo_hist_add(&priv->stats.lease_wait_us, dacxo_elapsed_us(start));
+	}
+	priv->lease_start = start;
+}
+
+// Release the i2c bus. 'changed': registers were written, the UI controller reads them back.
+static inline void dacxo_lease_release(struct dacxo_bcm_priv *priv, bool changed)
+{
+	const u32 hold_us = dacxo_elapsed_us(priv->lease_start);
+
+	if (changed && hold_us < DACXO_LEASE_CHANGE_US)
+		usleep_range(DACXO_LEASE_CHANGE_US - hold_us, DACXO_LEASE_CHANGE_US - hold_us + 200);
+	gpiod_set_value(priv->uisync_gpio, 1);  // release pin
+	dacxo_hist_add(&priv->stats.lease_hold_us, hold_us);
+	if (hold_us > DACXO_LEASE_TIMEOUT_US)
+		priv->stats.lease_overruns++;
+}
+
 #define DAC_IS_CLK_MASTER 1
 
 #ifdef DAC_IS_CLK_MASTER
@@ -51,6 +233,13 @@ struct dacxo_bcm_priv {
 #define DACXO_FORMATS (SNDRV_PCM_FMTBIT_S24_LE | SNDRV_PCM_FMTBIT_S16_LE)
 //#define DACXO_FORMATS (SNDRV_PCM_FMTBIT_S32_LE)
 
+// i2s bit clock per frame: two 32-bit slots, also for 16-bit samples
+#define DACXO_BCLK_RATIO 64
+
+// Stream latency after the i2s interface, in frames: the fpga passes the i2s data with about
+// one frame delay, the pcm1792 digital filter (slow roll-off, as configured) has 21 frames group delay.
+#define DACXO_DAI_DELAY_FRAMES (1 + 21)
+
 #define DAC_max_attenuation_dB 80
 #define DAC_step_attenuation_dB 1
 
@@ -79,11 +268,43 @@ struct dacxo_bcm_priv {
 #define GPO1_ATT20DB		0x01
 
 // *** bifields in GPI0 ***
+#define GPI0_LOCK			0x01   // s/pdif receiver lock
+#define GPI0_RATE			0x0e   // detected rate: index in samplerate table, same encoding as GPO0[3:1] in master mode
+#define GPI0_ADJ_HI			0x10   // output clock runs 'High'
+#define GPI0_ADJ_LO			0x20   // output clock runs 'Low'
+#define GPI0_EMPTYISH		0x40   // fifo almost empty
+#define GPI0_FULLISH		0x80   // fifo almost full
 
 // *** bifields in GPI1 ***
 #define GPI1_ANAPWR			0x01   // measured Vana: 1 is 'on' (with 0.1s delay), 0 is 'off'
 
+// GPO0 clock config for the i2s input at 'samplerate': oscillator family and multiplier.
+// An unsupported rate gives multiplier 0.
+static inline unsigned int dacxo_rate_clkconfig(int samplerate)
+{
+	// the 48kHz family uses the other xtal oscillator
+	unsigned int freq_base = (samplerate == 48000 || samplerate == 96000 || samplerate == 192000);
+	unsigned int freq_mult;
+
+	switch (samplerate) {
+		case 44100:
+		case 48000: freq_mult = 1;
+		break;
+		case 88200:
+		case 96000: freq_mult = 2;
+		break;
+		case 176400:
+		case 192000: freq_mult = 3;
+		break;
+		default:
+			freq_mult = 0; // illegal/unsupported samplerate
+	}
+	return GPO0_CLKMASTER | (freq_base << 1) | (freq_mult << 2);
+}
+
 // GPIO pin number on RPi Zero to interact with EspHome UI controller
 #define GPIO_UI_TRIG    27
+// GPIO pin number on which the UI controller signals its own changes (optional)
+#define GPIO_UI_NOTIFY  22
 		  
 #endif /* _DACXO_H */
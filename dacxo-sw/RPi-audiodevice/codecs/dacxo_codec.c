@@ -32,6 +32,7 @@
 #include <linux/i2c.h>
 #include <linux/gpio/consumer.h>
 #include <linux/regmap.h>
+#include <linux/ktime.h>
 
 #include <sound/core.h>
 #include <sound/pcm.h>
@@ -42,6 +43,9 @@
 
 #include "dacxo.h"
 
+#define CREATE_TRACE_POINTS
+#include "dacxo_codec_trace.h"
+
 /* refrain from providing these defaults: that avoids potential mismatch with actual reg content
 static const struct reg_default dacxo_reg_defaults[] = {
 	{ REGDAC_GPO0,          0x00 },
@@ -82,53 +86,49 @@ static int codec_set_dai_fmt(struct snd_soc_dai *codec_dai,
 	return 0;
 }
 
-static int dacxo_set_i2s_rate(struct snd_soc_component *codec, int samplerate, struct gpio_desc *sync_pin)
+static int dacxo_set_i2s_rate(struct snd_soc_component *codec, int samplerate, struct dacxo_bcm_priv *card_priv)
 {
-	int freq_base, freq_mult;
-	
-	if (samplerate == 48000 || samplerate == 96000 || samplerate == 192000)
-		freq_base = 1; // enable other xtal oscillator
-	else
-		freq_base = 0; // default xtal oscillator
-	
-	switch (samplerate) {
-		case 44100:
-		case 48000: freq_mult = 1;
-		break;
-		case 88200:
-		case 96000: freq_mult = 2;
-		break;
-		case 176400:
-		case 192000: freq_mult = 3;
-		break;
-		default:
-			freq_mult = 0; // illegal/unsupported samplerate
-	}
-	
 	struct regmap *map = dev_get_regmap(codec->dev, NULL);
 	if (!map) {
 		pr_err("dacxo codec: regmap not found error!");
     return -EINVAL;
 	}
 
-	unsigned int gpo0_new = GPO0_CLKMASTER | (freq_base << 1) | (freq_mult << 2);
+	unsigned int gpo0_new = dacxo_rate_clkconfig(samplerate);
 	unsigned int gpo0_curr = 0;
+	mutex_lock(&card_priv->lock);
   int reg_err = regmap_read(map, REGDAC_GPO0, &gpo0_curr);
 	if (reg_err || ((gpo0_new & GPO0_CLKMASK) == (gpo0_curr & GPO0_CLKMASK))) {
-		return reg_err;  // return early when gpo0 needs no update
+		mutex_unlock(&card_priv->lock);
+		if (!reg_err)
+			card_priv->stats.writes_saved++;
+		trace_dacxo_rate_switch(samplerate, gpo0_new, false, 0, reg_err);
+		return reg_err;  // return early when gpo0 needs no update, such as after a matching rate hint
 	}
+	// the oscillator family switch is the slow one, to be done early on a rate hint
+	const bool family_switch = ((gpo0_new ^ gpo0_curr) & (GPO0_CLKMASTER | GPO0_BASE48KHZ)) != 0;
 
-	// Create the 'uisync' gpio signal, surrounding the write on the i2c bus
-	gpiod_set_value(sync_pin, 0);  // pull-down 'uisync' pin: signal UI controller on change and stay silent
+	// Hold the i2c bus lease around the write, the UI controller then reads back the new state
+	ktime_t start = ktime_get();
+	dacxo_lease_acquire(card_priv);
 
 	// set clock config. Be carefull to not write the 'power' status bit:
 	reg_err = regmap_update_bits(map, REGDAC_GPO0, GPO0_CLKMASK, gpo0_new);
-	gpiod_set_value(sync_pin, 1);  // release pin
-
-	if (reg_err == 0)
-	  pr_info("dacxo_codec: set_i2s_rate: write GPO0=0x%02x with mask 0x%02x OK!\n", (int)(gpo0_new), GPO0_CLKMASK);
-	else
+	u32 duration_us = dacxo_elapsed_us(start);
+	dacxo_lease_release(card_priv, true);
+	mutex_unlock(&card_priv->lock);
+	trace_dacxo_rate_switch(samplerate, gpo0_new, true, duration_us, reg_err);
+
+	if (reg_err == 0) {
+	  card_priv->stats.rate_switches++;
+	  if (family_switch)
+	    card_priv->stats.rate_family_switches++;
+	  dacxo_hist_add(&card_priv->stats.rate_switch_us, duration_us);
+	  pr_debug("dacxo_codec: set_i2s_rate: write GPO0=0x%02x with mask 0x%02x OK!\n", (int)(gpo0_new), GPO0_CLKMASK);
+	} else {
+	  card_priv->stats.i2c_errors[DACXO_DEV_FPGA]++;
 	  pr_warn("dacxo_codec: set_i2s_rate: write GPO0=0x%02x, i2c write error=%d\n", (int)(gpo0_new), reg_err);
+	}
 	return reg_err;
 }
 
@@ -143,21 +143,42 @@ static int codec_hw_params(struct snd_pcm_substream *substream,
 	struct snd_soc_dai *cpu_dai = snd_soc_rtd_to_cpu(rtd, 0);
 	int samplerate = params_rate(params);
 	int samplewidth = snd_pcm_format_width(params_format(params));
-	int clk_ratio = 64; // fixed bclk ratio is easiest for my HW
+	int clk_ratio = DACXO_BCLK_RATIO; // fixed bclk ratio is easiest for my HW
 
 	int err_clk = snd_soc_dai_set_bclk_ratio(cpu_dai, clk_ratio);
-	int err_rate = dacxo_set_i2s_rate(codec, samplerate, card_priv->uisync_gpio);
+	// Players may call hw_params several times while negotiating the format:
+	// only the last rate gets applied, in prepare, to not bounce the oscillators meanwhile
+	card_priv->stream_rate = samplerate;
 	
 	//	snd_pcm_format_physical_width(params_format(params));
-	pr_info("dacxo_codec: hw_params(rate=%d, width=%d) err_clk=%d err_rate=%d\n",
-		samplerate, samplewidth, err_clk, err_rate);
+	pr_debug("dacxo_codec: hw_params(rate=%d, width=%d) err_clk=%d\n",
+		samplerate, samplewidth, err_clk);
 
 	return err_clk;
 }
 
+static int codec_prepare(struct snd_pcm_substream *substream, struct snd_soc_dai *dai)
+{
+  struct snd_soc_component *codec = dai->component;
+  struct dacxo_bcm_priv *card_priv = snd_soc_card_get_drvdata(codec->card);
+
+	// also called on xrun recovery: then the rate is unchanged, without i2c write
+	int err_rate = dacxo_set_i2s_rate(codec, card_priv->stream_rate, card_priv);
+	pr_debug("dacxo_codec: prepare(rate=%d) err_rate=%d\n", card_priv->stream_rate, err_rate);
+	return 0;
+}
+
+// Report the latency in the DAC after the i2s interface, for accurate audio/video sync
+static snd_pcm_sframes_t codec_delay(struct snd_pcm_substream *substream, struct snd_soc_dai *dai)
+{
+	return DACXO_DAI_DELAY_FRAMES;
+}
+
 static const struct snd_soc_dai_ops codec_dai_ops = {
 	.set_fmt	   = codec_set_dai_fmt,
 	.hw_params	 = codec_hw_params,
+	.prepare     = codec_prepare,
+	.delay       = codec_delay,
 	// .mute_stream = codec_digital_mute
 };
 
@@ -259,6 +280,7 @@ static struct i2c_driver codec_i2c_driver = {
 		.owner = THIS_MODULE,
 //		.pm = &dacxo_pm,
 		.of_match_table = dacxo_of_match,
+		.probe_type = PROBE_PREFER_ASYNCHRONOUS,
 	},
 	.probe = codec_i2c_probe,
 	.remove = codec_i2c_remove,
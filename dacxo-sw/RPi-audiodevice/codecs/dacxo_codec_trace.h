@@ -0,0 +1,51 @@
+/*
+ * Tracepoints of the codec driver for the 5th generation DAC by Jos van Eijndhoven
+ *
+ * Enable at runtime with, for instance:
+ *   echo 1 > /sys/kernel/tracing/events/dacxo_codec/enable
+ *   cat /sys/kernel/tracing/trace_pipe
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ */
+
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM dacxo_codec
+
+#if !defined(_DACXO_CODEC_TRACE_H) || defined(TRACE_HEADER_MULTI_READ)
+#define _DACXO_CODEC_TRACE_H
+
+#include <linux/tracepoint.h>
+
+// A sample rate request from hw_params: 'gpo0' is the new clock config, 'switched' if it got written
+TRACE_EVENT(dacxo_rate_switch,
+	TP_PROTO(int samplerate, unsigned int gpo0, bool switched, unsigned int duration_us, int err),
+	TP_ARGS(samplerate, gpo0, switched, duration_us, err),
+	TP_STRUCT__entry(
+		__field(int, samplerate)
+		__field(unsigned int, gpo0)
+		__field(bool, switched)
+		__field(unsigned int, duration_us)
+		__field(int, err)
+	),
+	TP_fast_assign(
+		__entry->samplerate = samplerate;
+		__entry->gpo0 = gpo0;
+		__entry->switched = switched;
+		__entry->duration_us = duration_us;
+		__entry->err = err;
+	),
+	TP_printk("rate=%d gpo0=0x%02x switched=%d duration=%uus err=%d", __entry->samplerate,
+	          __entry->gpo0, __entry->switched, __entry->duration_us, __entry->err)
+);
+
+#endif /* _DACXO_CODEC_TRACE_H */
+
+/* This part must be outside protection */
+#undef TRACE_INCLUDE_PATH
+#define TRACE_INCLUDE_PATH .
+#undef TRACE_INCLUDE_FILE
+#define TRACE_INCLUDE_FILE dacxo_codec_trace
+#include <trace/define_trace.h>
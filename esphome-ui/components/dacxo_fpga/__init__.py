@@ -0,0 +1,51 @@
+import esphome.codegen as cg
+import esphome.config_validation as cv
+from esphome.components import i2c, i2c_queue, text_sensor
+from esphome.const import CONF_ID
+
+DEPENDENCIES = ["i2c"]
+AUTO_LOAD = ["i2c_queue", "text_sensor"]
+CODEOWNERS = ["@JosVanEijndhoven"]
+
+CONF_QUEUE_ID = "queue_id"
+CONF_DAC_STATUS = "dac_status"
+CONF_CLOCK_STATUS = "clock_status"
+CONF_BUFFER_STATUS = "buffer_status"
+CONF_FAST_INTERVAL = "fast_interval"
+CONF_SETTLE_TIME = "settle_time"
+
+dacxo_fpga_ns = cg.esphome_ns.namespace("dacxo_fpga")
+
+DacxoFpga = dacxo_fpga_ns.class_(
+    "DacxoFpga", cg.PollingComponent, i2c.I2CDevice
+)
+
+CONFIG_SCHEMA = (
+    cv.Schema(
+        {
+            cv.GenerateID(CONF_ID): cv.declare_id(DacxoFpga),
+            cv.Required(CONF_QUEUE_ID): cv.use_id(i2c_queue.I2cQueue),
+            cv.Optional(CONF_DAC_STATUS): text_sensor.text_sensor_schema(),
+            cv.Optional(CONF_CLOCK_STATUS): text_sensor.text_sensor_schema(),
+            cv.Optional(CONF_BUFFER_STATUS): text_sensor.text_sensor_schema(),
+            cv.Optional(CONF_FAST_INTERVAL, default="50ms"): cv.positive_time_period_milliseconds,
+            cv.Optional(CONF_SETTLE_TIME, default="3s"): cv.positive_time_period_milliseconds,
+        }
+    )
+    .extend(cv.polling_component_schema("1s"))
+    .extend(i2c.i2c_device_schema(0x10))
+)
+
+
+async def to_code(config):
+    var = cg.new_Pvariable(config[CONF_ID])
+    await cg.register_component(var, config)
+    await i2c.register_i2c_device(var, config)
+    queue = await cg.get_variable(config[CONF_QUEUE_ID])
+    cg.add(var.set_queue(queue))
+    cg.add(var.set_fast_interval(config[CONF_FAST_INTERVAL].total_milliseconds))
+    cg.add(var.set_settle_time(config[CONF_SETTLE_TIME].total_milliseconds))
+    for key in (CONF_DAC_STATUS, CONF_CLOCK_STATUS, CONF_BUFFER_STATUS):
+        if key in config:
+            sens = await text_sensor.new_text_sensor(config[key])
+            cg.add(getattr(var, f"set_{key}_sensor")(sens))
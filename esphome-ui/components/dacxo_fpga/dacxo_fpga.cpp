@@ -0,0 +1,156 @@
+#include "dacxo_fpga.h"
+#include "esphome/core/log.h"
+#include "esphome/core/hal.h"
+#include <array>
+#include <cinttypes>
+#include <utility>
+
+namespace esphome {
+namespace dacxo_fpga {
+
+static const char *const TAG = "dacxo_fpga";
+
+static const std::array<const char *, 8> SAMPLERATE_TEXTS =
+    {"No Lock", "No Lock", "44kHz", "48kHz", "88kHz", "96kHz", "176kHz", "192kHz"};
+
+const char *Snapshot::rate_text() const {
+  // In master mode, the RPi sets the rate through GPO0 bits [3:1], in slave mode the FPGA detects it
+  const uint8_t rate = is_master() ? gpo0 : gpi0;
+  return SAMPLERATE_TEXTS[(rate & GPI0_RATE) >> 1];
+}
+
+const char *Snapshot::clock_text() const {
+  if (!is_valid() || is_master() || !(gpi0 & GPI0_CLK_ADJ))
+    return "Nom";
+  return (gpi0 & GPI0_ADJ_LO) ? "Low" : "High";
+}
+
+const char *Snapshot::buffer_text() const {
+  if (!is_valid() || is_master() || !(gpi0 & GPI0_FILL))
+    return "Nom";
+  return (gpi0 & GPI0_EMPTYISH) ? "Low" : "High";
+}
+
+const char *Snapshot::status_text() const {
+  if (!is_valid())
+    return "i2c bus error";
+  if (!has_lock())
+    return "No signal";
+  return rate_text();
+}
+
+void DacxoFpga::setup() {
+  slow_interval_ms_ = get_update_interval();
+  // start fast: the input gets selected on boot
+  poll_fast();
+}
+
+void DacxoFpga::dump_config() {
+  ESP_LOGCONFIG(TAG, "Dacxo FPGA");
+  LOG_I2C_DEVICE(this);
+  ESP_LOGCONFIG(TAG, "  Update interval: %" PRIu32 " ms, fast: %" PRIu32 " ms, settle time: %" PRIu32 " ms",
+                slow_interval_ms_, fast_interval_ms_, settle_time_ms_);
+  LOG_TEXT_SENSOR("  ", "Dac Status", dac_status_);
+  LOG_TEXT_SENSOR("  ", "Clock Status", clock_status_);
+  LOG_TEXT_SENSOR("  ", "Buffer Status", buffer_status_);
+}
+
+void DacxoFpga::update() {
+  i2c_queue::OperationScope scope(queue_, i2c_queue::OP_STATUS);
+  read_snapshot_(i2c_queue::PRIO_STATUS, nullptr);
+}
+
+void DacxoFpga::refresh(SnapshotCallback &&callback) {
+  read_snapshot_(i2c_queue::PRIO_CONTROL, std::move(callback));
+}
+
+void DacxoFpga::read_snapshot_(i2c_queue::Priority prio, SnapshotCallback &&callback) {
+  queue_->read(this, REG_GPO0, NUM_SNAPSHOT_REGS, prio,
+               [this, callback = std::move(callback)](i2c::ErrorCode err, const uint8_t *regs, size_t) {
+    snapshot_.err = err;
+    snapshot_.timestamp_ms = millis();
+    if (!err) {
+      snapshot_.gpo0 = regs[REG_GPO0 - REG_GPO0];
+      snapshot_.gpo1 = regs[REG_GPO1 - REG_GPO0];
+      snapshot_.gpi0 = regs[REG_GPI0 - REG_GPO0];
+      snapshot_.gpi1 = regs[REG_GPI1 - REG_GPO0];
+    }
+    publish_status_();
+    adapt_interval_();
+    snapshot_callback_.call(snapshot_);
+    if (callback)
+      callback(snapshot_);
+  });
+}
+
+void DacxoFpga::write_gpo0(uint8_t value, i2c_queue::Priority prio, i2c_queue::Callback &&callback) {
+  snapshot_.gpo0 = value;
+  queue_->write(this, REG_GPO0, &value, 1, prio, std::move(callback));
+  if (value & GPO0_POWERUP)
+    poll_fast();  // input switch or power-up: the receiver needs to (re-)lock
+}
+
+void DacxoFpga::write_gpo1(uint8_t value, i2c_queue::Priority prio, i2c_queue::Callback &&callback) {
+  snapshot_.gpo1 = value;
+  queue_->write(this, REG_GPO1, &value, 1, prio, std::move(callback));
+}
+
+void DacxoFpga::publish_status_() {
+  // The texts are static strings: compare pointers to publish only on a change of decoded fields
+  const char *status = snapshot_.status_text();
+  const char *clock = snapshot_.clock_text();
+  const char *buffer = snapshot_.buffer_text();
+  if (status != published_status_ && dac_status_ != nullptr)
+    dac_status_->publish_state(status);
+  if (clock != published_clock_ && clock_status_ != nullptr)
+    clock_status_->publish_state(clock);
+  if (buffer != published_buffer_ && buffer_status_ != nullptr)
+    buffer_status_->publish_state(buffer);
+  published_status_ = status;
+  published_clock_ = clock;
+  published_buffer_ = buffer;
+}
+
+void DacxoFpga::poll_fast() {
+  stable_since_ms_ = millis();
+  set_poll_interval_(fast_interval_ms_);
+}
+
+void DacxoFpga::poll_fast_at(uint32_t delay_ms, uint32_t duration_ms) {
+  set_timeout("poll_fast", delay_ms, [this, duration_ms]() {
+    window_start_ms_ = millis();
+    window_ms_ = duration_ms;
+    poll_fast();
+  });
+}
+
+void DacxoFpga::adapt_interval_() {
+  if (!snapshot_.is_valid())
+    return;  // keep the current rate on bus errors
+  const uint16_t state = (snapshot_.gpo0 << 8) | (snapshot_.gpi0 & GPI0_STABLE);
+  const uint32_t now = millis();
+  if (state != stable_state_) {
+    // a lock change, or a new rate or clock adjustment: follow it closely.
+    // A lasting loss of lock, such as without s/pdif input or in standby, settles as any other state.
+    stable_state_ = state;
+    stable_since_ms_ = now;
+    set_poll_interval_(fast_interval_ms_);
+  } else if (polls_fast_ && now - stable_since_ms_ >= settle_time_ms_ && now - window_start_ms_ >= window_ms_) {
+    ESP_LOGD(TAG, "Status stable: %s", snapshot_.status_text());
+    set_poll_interval_(slow_interval_ms_);
+  }
+}
+
+void DacxoFpga::set_poll_interval_(uint32_t interval_ms) {
+  const bool fast = interval_ms != slow_interval_ms_;
+  if (fast == polls_fast_)
+    return;
+  polls_fast_ = fast;
+  set_update_interval(interval_ms);
+  // restart the poller to have the new interval take effect now
+  stop_poller();
+  start_poller();
+}
+
+}  // namespace dacxo_fpga
+}  // namespace esphome
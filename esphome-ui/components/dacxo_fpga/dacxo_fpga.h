@@ -0,0 +1,163 @@
+#pragma once
+
+#include <functional>
+#include <utility>
+#include "esphome/core/component.h"
+#include "esphome/core/helpers.h"
+#include "esphome/components/i2c/i2c.h"
+#include "esphome/components/i2c_queue/i2c_queue.h"
+#include "esphome/components/text_sensor/text_sensor.h"
+
+namespace esphome {
+namespace dacxo_fpga {
+
+// i2c registers in the dac board FPGA, similar as in the RPi driver 'codecs/dacxo.h'
+// 'GPO*' registers are read/write, 'GPI*' registers are read-only
+enum Reg : uint8_t {
+  REG_GPO0 = 0x30,
+  REG_GPO1 = 0x31,
+  REG_GPI0 = 0x34,
+  REG_GPI1 = 0x35
+};
+
+static const uint8_t NUM_SNAPSHOT_REGS = REG_GPI1 - REG_GPO0 + 1;  // regs 0x32, 0x33 are unused
+
+// *** bitfields in GPO0 ***
+static const uint8_t GPO0_CLKMASTER = 0x01;  // use i2s (RPi) input, else one of the s/pdif inputs
+static const uint8_t GPO0_BASE48KHZ = 0x02;
+static const uint8_t GPO0_SLVINPUT  = 0x0c;  // in slave mode: s/pdif input select 0..3
+static const uint8_t GPO0_POWERUP   = 0x80;  // analog power relay
+// *** bitfields in GPO1 ***
+static const uint8_t GPO1_ATT20DB   = 0x01;
+// *** bitfields in GPI0 ***
+static const uint8_t GPI0_LOCK      = 0x01;  // s/pdif receiver lock
+static const uint8_t GPI0_RATE      = 0x0e;  // rate_sel and enbl_osc49M: index in samplerate table
+static const uint8_t GPI0_ADJ_HI    = 0x10;  // output clock runs 'High'
+static const uint8_t GPI0_ADJ_LO    = 0x20;  // output clock runs 'Low'
+static const uint8_t GPI0_CLK_ADJ   = GPI0_ADJ_HI | GPI0_ADJ_LO;
+static const uint8_t GPI0_EMPTYISH  = 0x40;  // fifo almost empty
+static const uint8_t GPI0_FULLISH   = 0x80;  // fifo almost full
+static const uint8_t GPI0_FILL      = GPI0_EMPTYISH | GPI0_FULLISH;
+// *** bitfields in GPI1 ***
+static const uint8_t GPI1_ANAPWR    = 0x01;  // measured Vana
+
+// GPI0 bits that must remain constant for the adaptive poller to back off to the slow interval
+static const uint8_t GPI0_STABLE    = GPI0_LOCK | GPI0_RATE | GPI0_CLK_ADJ;
+
+// Register content of the FPGA, as obtained in a single i2c burst read
+struct Snapshot {
+  uint8_t gpo0{0};
+  uint8_t gpo1{0};
+  uint8_t gpi0{0};
+  uint8_t gpi1{0};
+  uint32_t timestamp_ms{0};  // millis() when the read completed
+  i2c::ErrorCode err{i2c::ERROR_NOT_INITIALIZED};
+
+  bool is_valid() const { return err == i2c::ERROR_OK; }
+  bool is_master() const { return gpo0 & GPO0_CLKMASTER; }
+  bool is_powered() const { return gpo0 & GPO0_POWERUP; }
+  /// @return input channel 0..3 for s/pdif, 4 for the RPi i2s input
+  uint8_t channel() const { return is_master() ? 4 : (gpo0 & GPO0_SLVINPUT) >> 2; }
+  /// @return true if the output is locked onto its input: always in master mode
+  bool has_lock() const { return is_master() || (gpi0 & GPI0_LOCK); }
+  /// @return Sample rate text, such as "96kHz"
+  const char *rate_text() const;
+  /// @return Clock adjustment text: "Nom", "Low", or "High"
+  const char *clock_text() const;
+  /// @return Fifo buffer filling text: "Nom", "Low", or "High"
+  const char *buffer_text() const;
+  /// @return Summary text, such as "i2c bus error", "No signal", or the sample rate
+  const char *status_text() const;
+};
+
+using SnapshotCallback = std::function<void(const Snapshot &snapshot)>;
+
+/**
+ * Polls the FPGA status at the 'update_interval' while the input is stable.
+ * After an input switch, power-up, or a change of lock or clock state, it polls at the
+ * 'fast_interval' until that state has been stable during 'settle_time'.
+ */
+class DacxoFpga : public PollingComponent, public i2c::I2CDevice {
+  public:
+    void setup() override;
+    void update() override;
+    void dump_config() override;
+    float get_setup_priority() const override { return setup_priority::DATA; }
+    void set_queue(i2c_queue::I2cQueue *queue) { queue_ = queue; }
+    void set_fast_interval(uint32_t fast_interval_ms) { fast_interval_ms_ = fast_interval_ms; }
+    void set_settle_time(uint32_t settle_time_ms) { settle_time_ms_ = settle_time_ms; }
+    void set_dac_status_sensor(text_sensor::TextSensor *sensor) { dac_status_ = sensor; }
+    void set_clock_status_sensor(text_sensor::TextSensor *sensor) { clock_status_ = sensor; }
+    void set_buffer_status_sensor(text_sensor::TextSensor *sensor) { buffer_status_ = sensor; }
+
+    /**
+     * @return The last obtained register content. Consumers like the display
+     * use this, rather than reading the i2c bus themselves.
+     */
+    const Snapshot &snapshot() const { return snapshot_; }
+
+    /**
+     * @param callback Called on completion of every status read, such as for telemetry.
+     */
+    void add_on_snapshot_callback(SnapshotCallback &&callback) { snapshot_callback_.add(std::move(callback)); }
+
+    /**
+     * Read all registers in one burst at control priority, such as on a uisync pulse.
+     *
+     * @param callback Optional, called with the new snapshot on completion.
+     */
+    void refresh(SnapshotCallback &&callback = nullptr);
+
+    /**
+     * Switch to polling at the fast interval, until the status is stable again.
+     */
+    void poll_fast();
+
+    /**
+     * Schedule a fast polling window, such as just before a predicted status change.
+     *
+     * @param delay_ms Time until the window starts.
+     * @param duration_ms Minimum duration of the window.
+     */
+    void poll_fast_at(uint32_t delay_ms, uint32_t duration_ms);
+
+    /**
+     * Queue a write of the power and input select register. The snapshot is updated directly.
+     * This starts fast polling, to quickly report the new input status.
+     */
+    void write_gpo0(uint8_t value, i2c_queue::Priority prio = i2c_queue::PRIO_CONTROL,
+                    i2c_queue::Callback &&callback = nullptr);
+
+    /**
+     * Queue a write of the attenuation relay register. The snapshot is updated directly.
+     */
+    void write_gpo1(uint8_t value, i2c_queue::Priority prio = i2c_queue::PRIO_VOLUME,
+                    i2c_queue::Callback &&callback = nullptr);
+
+  protected:
+    void read_snapshot_(i2c_queue::Priority prio, SnapshotCallback &&callback);
+    void publish_status_();
+    void adapt_interval_();
+    void set_poll_interval_(uint32_t interval_ms);
+
+    i2c_queue::I2cQueue *queue_{nullptr};
+    Snapshot snapshot_;
+    uint32_t slow_interval_ms_{1000};  // the configured 'update_interval'
+    uint32_t fast_interval_ms_{50};
+    uint32_t settle_time_ms_{3000};
+    uint32_t stable_since_ms_{0};
+    uint32_t window_start_ms_{0};  // scheduled fast polling window
+    uint32_t window_ms_{0};
+    uint16_t stable_state_{0};  // GPO0 and GPI0_STABLE bits since 'stable_since_ms_'
+    bool polls_fast_{false};
+    const char *published_status_{nullptr};  // decoded texts as last published
+    const char *published_clock_{nullptr};
+    const char *published_buffer_{nullptr};
+    text_sensor::TextSensor *dac_status_{nullptr};
+    text_sensor::TextSensor *clock_status_{nullptr};
+    text_sensor::TextSensor *buffer_status_{nullptr};
+    CallbackManager<void(const Snapshot &)> snapshot_callback_;
+};
+
+}  // namespace dacxo_fpga
+}  // namespace esphome
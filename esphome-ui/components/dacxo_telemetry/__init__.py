@@ -0,0 +1,96 @@
+import esphome.codegen as cg
+import esphome.config_validation as cv
+from esphome.components import dacxo_fpga, sensor, text_sensor
+from esphome.const import (
+    CONF_ID,
+    STATE_CLASS_MEASUREMENT,
+    UNIT_PARTS_PER_MILLION,
+    UNIT_PERCENT,
+    UNIT_SECOND,
+)
+
+DEPENDENCIES = ["dacxo_fpga"]
+AUTO_LOAD = ["sensor", "text_sensor"]
+CODEOWNERS = ["@JosVanEijndhoven"]
+
+CONF_DACXO_FPGA_ID = "dacxo_fpga_id"
+CONF_CLOCK_LOW = "clock_low"
+CONF_CLOCK_HIGH = "clock_high"
+CONF_BUFFER_LOW = "buffer_low"
+CONF_BUFFER_HIGH = "buffer_high"
+CONF_CLOCK_DWELL = "clock_dwell"
+CONF_CLOCK_SWITCHES = "clock_switches"
+CONF_HISTORY = "history"
+CONF_PPM = "ppm"
+CONF_PPM_CI = "ppm_ci"
+CONF_NEXT_SWITCH = "next_switch"
+
+dacxo_telemetry_ns = cg.esphome_ns.namespace("dacxo_telemetry")
+
+DacxoTelemetry = dacxo_telemetry_ns.class_("DacxoTelemetry", cg.PollingComponent)
+
+PERCENT_SCHEMA = sensor.sensor_schema(
+    unit_of_measurement=UNIT_PERCENT,
+    accuracy_decimals=1,
+    state_class=STATE_CLASS_MEASUREMENT,
+)
+
+CONFIG_SCHEMA = cv.Schema(
+    {
+        cv.GenerateID(CONF_ID): cv.declare_id(DacxoTelemetry),
+        cv.GenerateID(CONF_DACXO_FPGA_ID): cv.use_id(dacxo_fpga.DacxoFpga),
+        cv.Optional(CONF_CLOCK_LOW): PERCENT_SCHEMA,
+        cv.Optional(CONF_CLOCK_HIGH): PERCENT_SCHEMA,
+        cv.Optional(CONF_BUFFER_LOW): PERCENT_SCHEMA,
+        cv.Optional(CONF_BUFFER_HIGH): PERCENT_SCHEMA,
+        cv.Optional(CONF_CLOCK_DWELL): sensor.sensor_schema(
+            unit_of_measurement=UNIT_SECOND,
+            accuracy_decimals=0,
+            state_class=STATE_CLASS_MEASUREMENT,
+        ),
+        cv.Optional(CONF_CLOCK_SWITCHES): sensor.sensor_schema(
+            unit_of_measurement="switches/h",
+            accuracy_decimals=1,
+            state_class=STATE_CLASS_MEASUREMENT,
+        ),
+        cv.Optional(CONF_HISTORY): text_sensor.text_sensor_schema(),
+        cv.Optional(CONF_PPM): sensor.sensor_schema(
+            unit_of_measurement=UNIT_PARTS_PER_MILLION,
+            accuracy_decimals=1,
+            state_class=STATE_CLASS_MEASUREMENT,
+        ),
+        cv.Optional(CONF_PPM_CI): sensor.sensor_schema(
+            unit_of_measurement=UNIT_PARTS_PER_MILLION,
+            accuracy_decimals=1,
+            state_class=STATE_CLASS_MEASUREMENT,
+        ),
+        cv.Optional(CONF_NEXT_SWITCH): sensor.sensor_schema(
+            unit_of_measurement=UNIT_SECOND,
+            accuracy_decimals=0,
+        ),
+    }
+).extend(cv.polling_component_schema("60s"))
+
+
+async def to_code(config):
+    var = cg.new_Pvariable(config[CONF_ID])
+    await cg.register_component(var, config)
+    fpga = await cg.get_variable(config[CONF_DACXO_FPGA_ID])
+    cg.add(var.set_fpga(fpga))
+    for key in (
+        CONF_CLOCK_LOW,
+        CONF_CLOCK_HIGH,
+        CONF_BUFFER_LOW,
+        CONF_BUFFER_HIGH,
+        CONF_CLOCK_DWELL,
+        CONF_CLOCK_SWITCHES,
+        CONF_PPM,
+        CONF_PPM_CI,
+        CONF_NEXT_SWITCH,
+    ):
+        if key in config:
+            sens = await sensor.new_sensor(config[key])
+            cg.add(getattr(var, f"set_{key}_sensor")(sens))
+    if CONF_HISTORY in config:
+        sens = await text_sensor.new_text_sensor(config[CONF_HISTORY])
+        cg.add(var.set_history_sensor(sens))
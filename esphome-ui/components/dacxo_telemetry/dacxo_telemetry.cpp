@@ -0,0 +1,236 @@
+#include "dacxo_telemetry.h"
+#include "esphome/core/log.h"
+#include "esphome/core/hal.h"
+#include <algorithm>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+
+namespace esphome {
+namespace dacxo_telemetry {
+
+static const char *const TAG = "dacxo_telemetry";
+
+static const char LEVEL_CHARS[] = {'N', 'L', 'H', '-'};  // indexed by Level
+static const size_t HISTORY_TEXT_LEN = 256;  // home assistant limits text sensor states to 255 chars
+
+using dacxo_fpga::GPO0_CLKMASTER;
+using dacxo_fpga::GPO0_SLVINPUT;
+using dacxo_fpga::GPO0_POWERUP;
+
+void DacxoTelemetry::setup() {
+  fpga_->add_on_snapshot_callback([this](const dacxo_fpga::Snapshot &snapshot) { on_snapshot_(snapshot); });
+}
+
+void DacxoTelemetry::dump_config() {
+  ESP_LOGCONFIG(TAG, "Dacxo clock telemetry");
+  LOG_UPDATE_INTERVAL(this);
+  LOG_SENSOR("  ", "Clock Low", clock_low_);
+  LOG_SENSOR("  ", "Clock High", clock_high_);
+  LOG_SENSOR("  ", "Buffer Low", buffer_low_);
+  LOG_SENSOR("  ", "Buffer High", buffer_high_);
+  LOG_SENSOR("  ", "Clock Dwell", clock_dwell_);
+  LOG_SENSOR("  ", "Clock Switches", clock_switches_);
+  LOG_TEXT_SENSOR("  ", "History", history_sensor_);
+  LOG_SENSOR("  ", "Source Offset", ppm_);
+  LOG_SENSOR("  ", "Source Offset CI", ppm_ci_);
+  LOG_SENSOR("  ", "Next Switch", next_switch_);
+}
+
+Level DacxoTelemetry::clock_level_(uint8_t gpi0) {
+  if (!(gpi0 & dacxo_fpga::GPI0_CLK_ADJ))
+    return LEVEL_NOM;
+  return (gpi0 & dacxo_fpga::GPI0_ADJ_LO) ? LEVEL_LOW : LEVEL_HIGH;
+}
+
+Level DacxoTelemetry::buffer_level_(uint8_t gpi0) {
+  if (!(gpi0 & dacxo_fpga::GPI0_FILL))
+    return LEVEL_NOM;
+  return (gpi0 & dacxo_fpga::GPI0_EMPTYISH) ? LEVEL_LOW : LEVEL_HIGH;
+}
+
+void DacxoTelemetry::on_snapshot_(const dacxo_fpga::Snapshot &snapshot) {
+  const uint32_t now = snapshot.timestamp_ms;
+  accumulate_(now);  // the time since the previous read counts for the previous state
+  if (!snapshot.is_valid())
+    return;  // bus error: keep the current state
+
+  const uint16_t source = snapshot.gpo0 & (GPO0_CLKMASTER | GPO0_SLVINPUT | GPO0_POWERUP);
+  if (source != source_)
+    restart_(source);
+
+  const bool is_locked = snapshot.is_powered() && !snapshot.is_master() && (snapshot.gpi0 & dacxo_fpga::GPI0_LOCK);
+  if (!is_locked) {
+    if (is_tracking_) {
+      is_tracking_ = false;
+      has_clock_switch_ = false;  // the dwell time and cycle over a lock loss are meaningless
+      has_cycle_ = false;
+      has_prediction_ = false;
+      record_(now, LEVEL_UNLOCKED, LEVEL_UNLOCKED);
+    }
+    return;
+  }
+
+  const Level clock = clock_level_(snapshot.gpi0);
+  const Level buffer = buffer_level_(snapshot.gpi0);
+  if (!is_tracking_) {
+    is_tracking_ = true;
+    last_sample_ms_ = now;
+  } else if (clock != clock_) {
+    num_clock_switches_++;
+    if (has_clock_switch_) {
+      dwell_sum_ms_[clock_] += now - last_clock_switch_ms_;
+      num_dwells_[clock_]++;
+    }
+    last_clock_switch_ms_ = now;
+    has_clock_switch_ = true;
+    if (clock != LEVEL_NOM)
+      end_cycle_();  // a steering period starts
+    clock_ = clock;
+    predict_switch_(now);
+  } else if (buffer == buffer_ && history_len_ > 0) {
+    return;  // no transition
+  }
+  clock_ = clock;
+  buffer_ = buffer;
+  record_(now, clock, buffer);
+}
+
+void DacxoTelemetry::restart_(uint16_t source) {
+  if (tracked_ms_() > 0) {
+    ESP_LOGI(TAG, "Input 0x%02x: tracked %" PRIu32 " s, %" PRIu32 " clock switches",
+             source_, tracked_ms_() / 1000, num_clock_switches_);
+  }
+  source_ = source;
+  is_tracking_ = false;
+  clock_ms_.fill(0);
+  buffer_ms_.fill(0);
+  num_clock_switches_ = 0;
+  has_clock_switch_ = false;
+  dwell_sum_ms_.fill(0);
+  num_dwells_.fill(0);
+  has_cycle_ = false;
+  num_cycles_ = 0;
+  ppm_mean_ = 0;
+  ppm_m2_ = 0;
+  has_prediction_ = false;
+  history_head_ = 0;
+  history_len_ = 0;
+}
+
+void DacxoTelemetry::accumulate_(uint32_t now) {
+  if (!is_tracking_)
+    return;
+  const uint32_t elapsed = now - last_sample_ms_;
+  clock_ms_[clock_] += elapsed;
+  buffer_ms_[buffer_] += elapsed;
+  last_sample_ms_ = now;
+}
+
+void DacxoTelemetry::record_(uint32_t now, Level clock, Level buffer) {
+  Transition &t = history_[history_head_];
+  t.timestamp_ms = now;
+  t.clock = clock;
+  t.buffer = buffer;
+  history_head_ = (history_head_ + 1) % HISTORY_LEN;
+  if (history_len_ < HISTORY_LEN)
+    history_len_++;
+}
+
+void DacxoTelemetry::end_cycle_() {
+  const uint32_t cycle_ms = tracked_ms_() - (cycle_start_ms_[LEVEL_NOM] + cycle_start_ms_[LEVEL_LOW] +
+                                             cycle_start_ms_[LEVEL_HIGH]);
+  if (has_cycle_ && cycle_ms > 0) {
+    const int32_t high_ms = clock_ms_[LEVEL_HIGH] - cycle_start_ms_[LEVEL_HIGH];
+    const int32_t low_ms = clock_ms_[LEVEL_LOW] - cycle_start_ms_[LEVEL_LOW];
+    const float ppm = ADJ_PPM * (high_ms - low_ms) / cycle_ms;
+    // Welford's running mean and variance
+    num_cycles_++;
+    const float delta = ppm - ppm_mean_;
+    ppm_mean_ += delta / num_cycles_;
+    ppm_m2_ += delta * (ppm - ppm_mean_);
+    ESP_LOGD(TAG, "Cycle of %" PRIu32 " s: %.1f ppm, mean %.1f ppm over %" PRIu32 " cycles",
+             cycle_ms / 1000, ppm, ppm_mean_, num_cycles_);
+  }
+  has_cycle_ = true;
+  cycle_start_ms_ = clock_ms_;
+}
+
+void DacxoTelemetry::predict_switch_(uint32_t now) {
+  if (num_dwells_[clock_] == 0) {
+    has_prediction_ = false;
+    return;
+  }
+  const uint32_t dwell_ms = dwell_sum_ms_[clock_] / num_dwells_[clock_];
+  has_prediction_ = true;
+  next_switch_ms_ = now + dwell_ms;
+  // Have the fpga poll fast around the predicted switch, to timestamp it accurately
+  const uint32_t margin_ms = std::min(dwell_ms / 8, MAX_POLL_WINDOW_MS / 2);
+  fpga_->poll_fast_at(dwell_ms - margin_ms, 2 * margin_ms);
+}
+
+uint32_t DacxoTelemetry::tracked_ms_() const {
+  return clock_ms_[LEVEL_NOM] + clock_ms_[LEVEL_LOW] + clock_ms_[LEVEL_HIGH];
+}
+
+size_t DacxoTelemetry::history_to_string(char *buf, size_t buf_len) const {
+  size_t pos = 0;
+  if (buf_len > 0)
+    buf[0] = '\0';
+  uint32_t end_ms = is_tracking_ ? last_sample_ms_ : 0;
+  for (size_t i = 0; i < history_len_; i++) {
+    const Transition &t = history_[(history_head_ + HISTORY_LEN - 1 - i) % HISTORY_LEN];
+    // the newest entry has no end when unlocked: it continues until the next lock
+    const uint32_t duration_s = (i == 0 && !is_tracking_) ? 0 : (end_ms - t.timestamp_ms) / 1000;
+    const int len = std::snprintf(buf + pos, buf_len - pos, "%s%c%c:%" PRIu32, (i == 0) ? "" : " ",
+                                  LEVEL_CHARS[t.clock], LEVEL_CHARS[t.buffer], duration_s);
+    if (len < 0 || pos + len >= buf_len) {
+      buf[pos] = '\0';  // drop the truncated entry
+      break;
+    }
+    pos += len;
+    end_ms = t.timestamp_ms;
+  }
+  return pos;
+}
+
+void DacxoTelemetry::update() {
+  accumulate_(millis());
+  const uint32_t tracked_ms = tracked_ms_();
+  const float to_percent = (tracked_ms > 0) ? 100.0f / tracked_ms : NAN;
+  if (clock_low_ != nullptr)
+    clock_low_->publish_state(clock_ms_[LEVEL_LOW] * to_percent);
+  if (clock_high_ != nullptr)
+    clock_high_->publish_state(clock_ms_[LEVEL_HIGH] * to_percent);
+  if (buffer_low_ != nullptr)
+    buffer_low_->publish_state(buffer_ms_[LEVEL_LOW] * to_percent);
+  if (buffer_high_ != nullptr)
+    buffer_high_->publish_state(buffer_ms_[LEVEL_HIGH] * to_percent);
+  if (clock_dwell_ != nullptr) {
+    const uint32_t num_dwells = num_dwells_[LEVEL_NOM] + num_dwells_[LEVEL_LOW] + num_dwells_[LEVEL_HIGH];
+    const uint32_t dwell_ms = dwell_sum_ms_[LEVEL_NOM] + dwell_sum_ms_[LEVEL_LOW] + dwell_sum_ms_[LEVEL_HIGH];
+    clock_dwell_->publish_state((num_dwells > 0) ? dwell_ms / 1000.0f / num_dwells : NAN);
+  }
+  if (clock_switches_ != nullptr)
+    clock_switches_->publish_state((tracked_ms > 0) ? num_clock_switches_ * 3600000.0f / tracked_ms : NAN);
+  if (ppm_ != nullptr)
+    ppm_->publish_state((num_cycles_ > 0) ? ppm_mean_ : NAN);
+  if (ppm_ci_ != nullptr) {
+    // half width of the 95% confidence interval of the mean: 1.96 * sd / sqrt(n)
+    const float ci = (num_cycles_ > 1) ? 1.96f * std::sqrt(ppm_m2_ / (num_cycles_ - 1) / num_cycles_) : NAN;
+    ppm_ci_->publish_state(ci);
+  }
+  if (next_switch_ != nullptr) {
+    // negative when overdue
+    next_switch_->publish_state(has_prediction_ ? (int32_t) (next_switch_ms_ - millis()) / 1000.0f : NAN);
+  }
+  if (history_sensor_ != nullptr) {
+    char history[HISTORY_TEXT_LEN];
+    history_to_string(history, sizeof(history));
+    if (history_sensor_->state != history)
+      history_sensor_->publish_state(history);
+  }
+}
+
+}  // namespace dacxo_telemetry
+}  // namespace esphome
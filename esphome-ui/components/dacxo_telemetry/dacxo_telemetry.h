@@ -0,0 +1,119 @@
+#pragma once
+
+#include <array>
+#include "esphome/core/component.h"
+#include "esphome/components/sensor/sensor.h"
+#include "esphome/components/text_sensor/text_sensor.h"
+#include "esphome/components/dacxo_fpga/dacxo_fpga.h"
+
+namespace esphome {
+namespace dacxo_telemetry {
+
+// Decoded state of the clock adjustment (adj_lo/adj_hi) and of the fifo filling (almost_empty/almost_full)
+enum Level : uint8_t {
+  LEVEL_NOM  = 0,
+  LEVEL_LOW  = 1,
+  LEVEL_HIGH = 2,
+  LEVEL_UNLOCKED = 3  // only in the history: input lost its lock
+};
+static const size_t NUM_LEVELS = 3;  // time-in-state is accumulated for NOM, LOW and HIGH
+
+static const size_t HISTORY_LEN = 32;  // max number of remembered status transitions
+
+// Deviation of the 'Low' and 'High' output clock from nominal: 1/1024, as by ADJ in clock.v
+static const float ADJ_PPM = 1e6f / 1024;
+static const uint32_t MAX_POLL_WINDOW_MS = 10000;  // max fast polling around a predicted clock switch
+
+struct Transition {
+  uint32_t timestamp_ms{0};
+  Level clock{LEVEL_NOM};
+  Level buffer{LEVEL_NOM};
+};
+
+/**
+ * Collects the clock steering behavior of the FPGA from the 'dacxo_fpga' status reads:
+ * while the s/pdif input is locked, the clock and buffer state transitions are recorded in a
+ * ring buffer, and the time spent in each state is accumulated.
+ * The statistics restart when another input is selected.
+ *
+ * The clock steering keeps the fifo filling in range, so over a cycle between the starts of two
+ * steering periods (Low or High) the output clock on average matches the source clock:
+ * offset_ppm = ADJ_PPM * (t_high - t_low) / t_cycle
+ * The published estimate is the mean over these cycles, with its 95% confidence interval.
+ */
+class DacxoTelemetry : public PollingComponent {
+  public:
+    void setup() override;
+    void update() override;
+    void dump_config() override;
+    float get_setup_priority() const override { return setup_priority::DATA; }
+    void set_fpga(dacxo_fpga::DacxoFpga *fpga) { fpga_ = fpga; }
+    void set_clock_low_sensor(sensor::Sensor *sensor) { clock_low_ = sensor; }
+    void set_clock_high_sensor(sensor::Sensor *sensor) { clock_high_ = sensor; }
+    void set_buffer_low_sensor(sensor::Sensor *sensor) { buffer_low_ = sensor; }
+    void set_buffer_high_sensor(sensor::Sensor *sensor) { buffer_high_ = sensor; }
+    void set_clock_dwell_sensor(sensor::Sensor *sensor) { clock_dwell_ = sensor; }
+    void set_clock_switches_sensor(sensor::Sensor *sensor) { clock_switches_ = sensor; }
+    void set_history_sensor(text_sensor::TextSensor *sensor) { history_sensor_ = sensor; }
+    void set_ppm_sensor(sensor::Sensor *sensor) { ppm_ = sensor; }
+    void set_ppm_ci_sensor(sensor::Sensor *sensor) { ppm_ci_ = sensor; }
+    void set_next_switch_sensor(sensor::Sensor *sensor) { next_switch_ = sensor; }
+
+    /**
+     * Format the recorded transitions, newest first, as "<clock><buffer>:<seconds>" entries,
+     * such as "HN:75 NN:312 LN:64". The first entry is the current state, with its duration so far.
+     * An input without lock shows as "--".
+     *
+     * @return The formatted length, excluding the terminating zero.
+     */
+    size_t history_to_string(char *buf, size_t buf_len) const;
+
+  protected:
+    void on_snapshot_(const dacxo_fpga::Snapshot &snapshot);
+    void restart_(uint16_t source);
+    void accumulate_(uint32_t now);
+    void record_(uint32_t now, Level clock, Level buffer);
+    void end_cycle_();
+    void predict_switch_(uint32_t now);
+    /// @return Time since the session start during which the input was locked, in ms
+    uint32_t tracked_ms_() const;
+    static Level clock_level_(uint8_t gpi0);
+    static Level buffer_level_(uint8_t gpi0);
+
+    dacxo_fpga::DacxoFpga *fpga_{nullptr};
+    uint16_t source_{0xffff};  // GPO0 input selection of the current session
+    bool is_tracking_{false};  // valid status with a locked s/pdif input
+    uint32_t last_sample_ms_{0};
+    Level clock_{LEVEL_NOM};
+    Level buffer_{LEVEL_NOM};
+    std::array<uint32_t, NUM_LEVELS> clock_ms_{};   // time in state, indexed by Level
+    std::array<uint32_t, NUM_LEVELS> buffer_ms_{};
+    uint32_t num_clock_switches_{0};
+    uint32_t last_clock_switch_ms_{0};
+    bool has_clock_switch_{false};  // 'last_clock_switch_ms_' is valid
+    std::array<uint32_t, NUM_LEVELS> dwell_sum_ms_{};  // complete dwell times between clock switches, per Level
+    std::array<uint32_t, NUM_LEVELS> num_dwells_{};
+    bool has_cycle_{false};         // a steering cycle started, at these values of 'clock_ms_'
+    std::array<uint32_t, NUM_LEVELS> cycle_start_ms_{};
+    uint32_t num_cycles_{0};        // completed cycles, with running mean and variance of their ppm offset
+    float ppm_mean_{0};
+    float ppm_m2_{0};
+    bool has_prediction_{false};
+    uint32_t next_switch_ms_{0};    // predicted time of the next clock switch
+    std::array<Transition, HISTORY_LEN> history_;
+    size_t history_head_{0};  // slot for the next transition
+    size_t history_len_{0};
+    sensor::Sensor *clock_low_{nullptr};
+    sensor::Sensor *clock_high_{nullptr};
+    sensor::Sensor *buffer_low_{nullptr};
+    sensor::Sensor *buffer_high_{nullptr};
+    sensor::Sensor *clock_dwell_{nullptr};
+    sensor::Sensor *clock_switches_{nullptr};
+    text_sensor::TextSensor *history_sensor_{nullptr};
+    sensor::Sensor *ppm_{nullptr};
+    sensor::Sensor *ppm_ci_{nullptr};
+    sensor::Sensor *next_switch_{nullptr};
+};
+
+}  // namespace dacxo_telemetry
+}  // namespace esphome
@@ -0,0 +1,61 @@
+import esphome.codegen as cg
+import esphome.config_validation as cv
+from esphome import automation, pins
+from esphome.const import CONF_ID, CONF_FREQUENCY, CONF_PIN, CONF_TIMEOUT, CONF_TRIGGER_ID
+
+DEPENDENCIES = ["i2c"]
+CODEOWNERS = ["@JosVanEijndhoven"]
+
+CONF_MAX_LOOP_TIME = "max_loop_time"
+CONF_LEASE = "lease"
+CONF_PEER_PIN = "peer_pin"
+CONF_CHANGE_TIME = "change_time"
+CONF_ON_PEER_CHANGE = "on_peer_change"
+
+i2c_queue_ns = cg.esphome_ns.namespace("i2c_queue")
+
+I2cQueue = i2c_queue_ns.class_("I2cQueue", cg.Component)
+PeerChangeTrigger = i2c_queue_ns.class_("PeerChangeTrigger", automation.Trigger.template())
+
+# Bus lease with the RPi driver, the other master on the i2c bus
+LEASE_SCHEMA = cv.Schema(
+    {
+        # own claim line, 'uinotify' towards the RPi: open drain, active low
+        cv.Required(CONF_PIN): pins.internal_gpio_output_pin_schema,
+        # claim line of the RPi, 'uisync'
+        cv.Required(CONF_PEER_PIN): pins.internal_gpio_input_pin_schema,
+        # as DACXO_LEASE_TIMEOUT_US and DACXO_LEASE_CHANGE_US in the RPi driver
+        cv.Optional(CONF_TIMEOUT, default="50ms"): cv.positive_time_period_microseconds,
+        cv.Optional(CONF_CHANGE_TIME, default="3ms"): cv.positive_time_period_microseconds,
+        cv.Optional(CONF_ON_PEER_CHANGE): automation.validate_automation(
+            {cv.GenerateID(CONF_TRIGGER_ID): cv.declare_id(PeerChangeTrigger)}
+        ),
+    }
+)
+
+CONFIG_SCHEMA = cv.Schema(
+    {
+        cv.GenerateID(CONF_ID): cv.declare_id(I2cQueue),
+        cv.Optional(CONF_MAX_LOOP_TIME, default="2ms"): cv.positive_time_period_microseconds,
+        # should match the i2c bus frequency, to model the bus time in the traffic statistics
+        cv.Optional(CONF_FREQUENCY, default="100kHz"): cv.All(cv.frequency, cv.Range(min=0, min_included=False)),
+        cv.Optional(CONF_LEASE): LEASE_SCHEMA,
+    }
+).extend(cv.COMPONENT_SCHEMA)
+
+
+async def to_code(config):
+    var = cg.new_Pvariable(config[CONF_ID])
+    await cg.register_component(var, config)
+    cg.add(var.set_max_loop_time(config[CONF_MAX_LOOP_TIME].total_microseconds))
+    cg.add(var.set_bus_frequency(int(config[CONF_FREQUENCY])))
+    if CONF_LEASE in config:
+        lease = config[CONF_LEASE]
+        pin = await cg.gpio_pin_expression(lease[CONF_PIN])
+        peer_pin = await cg.gpio_pin_expression(lease[CONF_PEER_PIN])
+        cg.add(var.set_lease_pins(pin, peer_pin))
+        cg.add(var.set_lease_timeout(lease[CONF_TIMEOUT].total_microseconds))
+        cg.add(var.set_change_time(lease[CONF_CHANGE_TIME].total_microseconds))
+        for conf in lease.get(CONF_ON_PEER_CHANGE, []):
+            trigger = cg.new_Pvariable(conf[CONF_TRIGGER_ID], var)
+            await automation.build_automation(trigger, [], conf)
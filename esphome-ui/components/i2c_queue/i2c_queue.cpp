@@ -0,0 +1,338 @@
+#include "i2c_queue.h"
+#include "esphome/core/log.h"
+#include "esphome/core/hal.h"
+#include <algorithm>
+#include <cinttypes>
+#include <utility>
+
+namespace esphome {
+namespace i2c_queue {
+
+static const char *const TAG = "i2c_queue";
+
+static const std::array<const char *, NUM_OPERATIONS> OPERATION_NAMES =
+    {"other", "volume", "input", "power-up", "power-off", "uisync", "status"};
+
+// i2c bits per transaction: start, device address byte, register byte, stop;
+// a register read adds a repeated start and the device address byte.
+// Each byte takes 9 clocks including its ack.
+static const uint32_t WRITE_OVERHEAD_BITS = 1 + 9 + 9 + 1;
+static const uint32_t READ_OVERHEAD_BITS = WRITE_OVERHEAD_BITS + 1 + 9;
+
+// Bus lease: time for an own claim to become visible on the line, before checking the RPi claim
+static const uint32_t LEASE_SETTLE_US = 5;
+// Retry interval of a deferred transaction, doubling while the RPi keeps the bus
+static const uint32_t LEASE_BACKOFF_MIN_US = 100;
+static const uint32_t LEASE_BACKOFF_MAX_US = 3200;
+
+void I2cQueue::setup() {
+  if (lease_pin_ == nullptr)
+    return;
+  lease_pin_->setup();
+  lease_pin_->digital_write(false);  // released
+  peer_pin_->setup();
+  peer_isr_pin_ = peer_pin_->to_isr();
+  peer_pin_->attach_interrupt(&I2cQueue::peer_isr_, this, gpio::INTERRUPT_ANY_EDGE);
+}
+
+// Edges of the RPi claim line. The RPi holding its claim for the change time signals its register changes.
+void IRAM_ATTR I2cQueue::peer_isr_(I2cQueue *queue) {
+  const uint32_t now = micros();
+  if (queue->peer_isr_pin_.digital_read()) {
+    queue->peer_since_us_ = now;
+    queue->peer_held_ = true;
+  } else if (queue->peer_held_) {
+    // a short pulse may show its release level on both edges: only count pulses with a start
+    queue->peer_held_ = false;
+    queue->peer_leases_++;
+    if (now - queue->peer_since_us_ >= queue->change_time_us_) {
+      queue->peer_changes_++;
+      queue->peer_changed_ = true;
+    }
+  }
+}
+
+void I2cQueue::dump_config() {
+  ESP_LOGCONFIG(TAG, "I2c transaction queue");
+  ESP_LOGCONFIG(TAG, "  Max loop time: %" PRIu32 " us", max_loop_time_us_);
+  ESP_LOGCONFIG(TAG, "  Bus frequency: %" PRIu32 " Hz", bus_frequency_);
+  ESP_LOGCONFIG(TAG, "  Coalesced: %" PRIu32 ", overflows: %" PRIu32, num_coalesced_, num_overflows_);
+  if (lease_pin_ != nullptr) {
+    LOG_PIN("  Lease Pin: ", lease_pin_);
+    LOG_PIN("  Peer Lease Pin: ", peer_pin_);
+    ESP_LOGCONFIG(TAG, "  Lease timeout: %" PRIu32 " us, change time: %" PRIu32 " us", lease_timeout_us_,
+                  change_time_us_);
+  }
+}
+
+LeaseStats I2cQueue::get_lease_stats() const {
+  LeaseStats stats = lease_stats_;
+  // changes first: a claim counted in between keeps 'peer_changes' within 'peer_leases'
+  stats.peer_changes = peer_changes_.load();
+  stats.peer_leases = peer_leases_.load();
+  return stats;
+}
+
+void I2cQueue::log_stats() const {
+  ESP_LOGI(TAG, "Bus traffic per operation: count, transactions, bytes, coalesced, bus time, exec time");
+  for (size_t op = 0; op < NUM_OPERATIONS; op++) {
+    const Stats &s = stats_[op];
+    if (s.transactions == 0 && s.coalesced == 0 && s.dropped == 0)
+      continue;
+    ESP_LOGI(TAG, "  %-9s %6" PRIu32 " %6" PRIu32 " %7" PRIu32 " %6" PRIu32 " %8" PRIu32 " us %8" PRIu32 " us",
+             OPERATION_NAMES[op], s.operations, s.transactions, s.bytes, s.coalesced, s.bus_time_us,
+             s.exec_time_us);
+    if (s.dropped > 0)
+      ESP_LOGW(TAG, "  %-9s %" PRIu32 " transactions dropped on a full queue", "", s.dropped);
+    if (s.operations > 0) {
+      ESP_LOGI(TAG, "  %-9s per operation: %.1f transactions, %.1f bytes, %" PRIu32 " us bus time", "",
+               (float) s.transactions / s.operations, (float) s.bytes / s.operations,
+               s.bus_time_us / s.operations);
+    }
+  }
+  if (lease_pin_ != nullptr) {
+    const LeaseStats l = get_lease_stats();
+    ESP_LOGI(TAG, "Bus lease: %" PRIu32 " acquires, %" PRIu32 " contentions, %" PRIu32 " collisions, %" PRIu32
+             " expired, wait max %" PRIu32 " us total %" PRIu32 " us",
+             l.acquires, l.contentions, l.collisions, l.expired, l.max_wait_us, l.total_wait_us);
+    ESP_LOGI(TAG, "RPi bus lease: %" PRIu32 " claims, %" PRIu32 " with changes", l.peer_leases, l.peer_changes);
+  }
+}
+
+bool I2cQueue::begin_operation(Operation op, bool count_operation) {
+  if (operation_ != OP_OTHER)
+    return false;
+  operation_ = op;
+  if (count_operation)
+    stats_[op].operations++;
+  return true;
+}
+
+uint32_t I2cQueue::bus_time_us_(bool is_read, size_t len) const {
+  const uint32_t bits = (is_read ? READ_OVERHEAD_BITS : WRITE_OVERHEAD_BITS) + 9 * len;
+  return (uint64_t) bits * 1000000 / bus_frequency_;
+}
+
+bool I2cQueue::write(i2c::I2CDevice *device, uint8_t reg, const uint8_t *data, size_t len,
+                     Priority prio, Callback &&callback) {
+  return submit_(device, false, reg, data, len, prio, std::move(callback));
+}
+
+bool I2cQueue::read(i2c::I2CDevice *device, uint8_t reg, size_t len, Priority prio, Callback &&callback) {
+  return submit_(device, true, reg, nullptr, len, prio, std::move(callback));
+}
+
+bool I2cQueue::submit_(i2c::I2CDevice *device, bool is_read, uint8_t reg, const uint8_t *data, size_t len,
+                       Priority prio, Callback &&callback) {
+  if (device == nullptr || len == 0 || len > MAX_DATA_LEN) {
+    ESP_LOGE(TAG, "Illegal transaction: reg=0x%02x len=%u", reg, (unsigned) len);
+    return false;
+  }
+
+  Transaction *t = find_pending_(device, is_read, reg, len);
+  if (t != nullptr) {
+    // Supersede (write) or share (read) the pending transaction
+    num_coalesced_++;
+    stats_[operation_].coalesced++;
+    t->prio = std::min(t->prio, prio);
+    // A superseding write moves to the end, as if newly submitted: it must not pass a pending
+    // overlapping write of another length, such as a shorter one of a pcm1792 flush() burst.
+    if (!is_read)
+      t->seq = next_seq_++;
+    if (callback && t->callback) {
+      t->callback = [first = std::move(t->callback), second = std::move(callback)]
+                    (ErrorCode err, const uint8_t *rdata, size_t rlen) {
+        first(err, rdata, rlen);
+        second(err, rdata, rlen);
+      };
+    } else if (callback) {
+      t->callback = std::move(callback);
+    }
+  } else {
+    if (num_pending_ == QUEUE_LEN) {
+      // Should not happen with the coalescing: make room by executing the most urgent one now.
+      // Not while the RPi holds the bus: waiting for the lease would stall the main loop.
+      if (num_overflows_++ == 0) {
+        ESP_LOGW(TAG, "Queue overflow: executing transaction synchronously");
+      }
+      if (!acquire_lease_()) {
+        stats_[operation_].dropped++;
+        ESP_LOGE(TAG, "Queue overflow while the RPi holds the bus lease: dropped reg=0x%02x len=%u", reg,
+                 (unsigned) len);
+        return false;
+      }
+      execute_(next_());
+      release_lease_();
+    }
+    // the callback of an executed transaction might have taken the freed slot
+    t = std::find_if(queue_.begin(), queue_.end(), [](const Transaction &s) { return s.device == nullptr; });
+    if (t == queue_.end()) {
+      stats_[operation_].dropped++;
+      ESP_LOGE(TAG, "Queue overflow: dropped reg=0x%02x len=%u", reg, (unsigned) len);
+      return false;
+    }
+    t->device = device;
+    t->seq = next_seq_++;
+    t->prio = prio;
+    t->op = operation_;
+    t->is_read = is_read;
+    t->reg = reg;
+    t->len = len;
+    t->callback = std::move(callback);
+    num_pending_++;
+    high_freq_.start();  // have loop() called without delay until the queue is drained
+  }
+  if (!is_read) {
+    std::copy(data, data + len, t->data.begin());
+  }
+  return true;
+}
+
+I2cQueue::Transaction *I2cQueue::find_pending_(i2c::I2CDevice *device, bool is_read, uint8_t reg, size_t len) {
+  for (auto &t : queue_) {
+    if (t.device == device && t.is_read == is_read && t.reg == reg && t.len == len)
+      return &t;
+  }
+  return nullptr;
+}
+
+I2cQueue::Transaction *I2cQueue::next_() {
+  Transaction *best = nullptr;
+  for (auto &t : queue_) {
+    if (t.device == nullptr)
+      continue;
+    // seq comparison by subtraction, to be robust against wrap-around
+    if (best == nullptr || t.prio < best->prio ||
+        (t.prio == best->prio && (int32_t) (t.seq - best->seq) < 0))
+      best = &t;
+  }
+  return best;
+}
+
+void I2cQueue::execute_(Transaction *t) {
+  const uint32_t start = micros();
+  ErrorCode err = t->is_read ? t->device->read_register(t->reg, t->data.data(), t->len)
+                             : t->device->write_register(t->reg, t->data.data(), t->len);
+  Stats &stats = stats_[t->op];
+  stats.exec_time_us += micros() - start;
+  stats.transactions++;
+  stats.bytes += t->len;
+  stats.bus_time_us += bus_time_us_(t->is_read, t->len);
+  if (err) {
+    ESP_LOGW(TAG, "i2c %s of reg 0x%02x len %u: bus error %d", t->is_read ? "read" : "write",
+             t->reg, t->len, err);
+  }
+  // Free the slot before the callback runs, as it might submit a new transaction
+  Callback callback = std::move(t->callback);
+  const std::array<uint8_t, MAX_DATA_LEN> data = t->data;
+  const uint8_t len = t->len;
+  const Operation op = t->op;
+  t->device = nullptr;
+  t->callback = nullptr;
+  num_pending_--;
+  if (callback) {
+    // follow-up transactions belong to the same operation
+    const Operation prev_op = operation_;
+    operation_ = op;
+    callback(err, data.data(), len);
+    operation_ = prev_op;
+  }
+}
+
+void I2cQueue::signal_change() {
+  if (lease_pin_ == nullptr)
+    return;
+  change_pending_ = true;
+  high_freq_.start();
+}
+
+bool I2cQueue::acquire_lease_() {
+  if (lease_pin_ == nullptr || lease_held_)
+    return true;
+  const uint32_t now = micros();
+  if (lease_waiting_ && (int32_t) (now - retry_at_us_) < 0)
+    return false;  // backing off
+
+  // a claim without its edge seen yet counts as just started
+  const bool peer_stuck = peer_held_ && (now - peer_since_us_) >= lease_timeout_us_;
+  if (peer_pin_->digital_read() && !peer_stuck)
+    return defer_lease_(now, false);
+  lease_pin_->digital_write(true);
+  delayMicroseconds(LEASE_SETTLE_US);
+  if (peer_pin_->digital_read()) {
+    if (!peer_stuck) {
+      // simultaneous claim: the RPi has priority
+      lease_pin_->digital_write(false);
+      return defer_lease_(now, true);
+    }
+    if (lease_stats_.expired++ == 0)
+      ESP_LOGW(TAG, "RPi holds the bus lease beyond %" PRIu32 " us: taking the bus", lease_timeout_us_);
+  }
+
+  lease_held_ = true;
+  lease_stats_.acquires++;
+  if (lease_waiting_) {
+    const uint32_t wait_us = now - wait_start_us_;
+    lease_stats_.total_wait_us += wait_us;
+    lease_stats_.max_wait_us = std::max(lease_stats_.max_wait_us, wait_us);
+    lease_waiting_ = false;
+  }
+  return true;
+}
+
+bool I2cQueue::defer_lease_(uint32_t now, bool is_collision) {
+  if (is_collision)
+    lease_stats_.collisions++;
+  if (!lease_waiting_) {
+    lease_waiting_ = true;
+    wait_start_us_ = now;
+    backoff_us_ = LEASE_BACKOFF_MIN_US;
+    lease_stats_.contentions++;
+  } else {
+    backoff_us_ = std::min(2 * backoff_us_, LEASE_BACKOFF_MAX_US);
+  }
+  retry_at_us_ = now + backoff_us_;
+  return false;
+}
+
+void I2cQueue::release_lease_() {
+  if (lease_pin_ == nullptr || change_holding_)
+    return;
+  lease_pin_->digital_write(false);
+  lease_held_ = false;
+}
+
+void I2cQueue::loop() {
+  if (peer_changed_.exchange(false)) {
+    peer_change_callback_.call();  // might submit transactions, as the readback of the changes
+  }
+
+  // Execute transactions until the time budget of this loop iteration is spent,
+  // so that the rest of the main loop (display, cec) never waits long for the bus.
+  // Each transaction takes the bus lease: the RPi never waits longer than one transaction.
+  const uint32_t start = micros();
+  while (num_pending_ > 0 && (micros() - start) < max_loop_time_us_) {
+    if (!acquire_lease_())
+      break;
+    execute_(next_());
+    release_lease_();
+  }
+
+  // Signal own changes, once written: hold the lease for the change time, without blocking the loop
+  if (change_pending_ && num_pending_ == 0 && acquire_lease_()) {
+    change_pending_ = false;
+    change_holding_ = true;
+    change_start_us_ = micros();
+  }
+  if (change_holding_ && (micros() - change_start_us_) >= change_time_us_) {
+    change_holding_ = false;
+    release_lease_();
+  }
+
+  if (num_pending_ == 0 && !change_pending_ && !change_holding_) {
+    high_freq_.stop();
+  }
+}
+
+}  // namespace i2c_queue
+}  // namespace esphome
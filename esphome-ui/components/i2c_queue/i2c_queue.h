@@ -0,0 +1,253 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <functional>
+#include "esphome/core/automation.h"
+#include "esphome/core/component.h"
+#include "esphome/core/hal.h"
+#include "esphome/core/helpers.h"
+#include "esphome/components/i2c/i2c.h"
+
+namespace esphome {
+namespace i2c_queue {
+
+// Transaction priority classes. Lower values are executed first.
+enum Priority : uint8_t {
+  PRIO_VOLUME  = 0,  // volume and mute: directly noticed by the user
+  PRIO_CONTROL = 1,  // power, input select, readback of RPi changes
+  PRIO_STATUS  = 2   // periodic status polling
+};
+
+// User level operations, to account the bus traffic that they cause
+enum Operation : uint8_t {
+  OP_OTHER     = 0,
+  OP_VOLUME    = 1,  // volume step or mute
+  OP_INPUT     = 2,  // input channel switch
+  OP_POWER_UP  = 3,
+  OP_POWER_OFF = 4,
+  OP_UISYNC    = 5,  // state refresh on a change signal from the RPi
+  OP_STATUS    = 6,  // periodic status polling
+  NUM_OPERATIONS
+};
+
+// Bus traffic accounting per Operation
+struct Stats {
+  uint32_t operations{0};    // number of begin_operation() calls
+  uint32_t transactions{0};  // executed transactions
+  uint32_t bytes{0};         // data bytes, excluding address and register bytes
+  uint32_t coalesced{0};     // submitted transactions merged into a pending one
+  uint32_t dropped{0};       // submitted transactions rejected on a full queue
+  uint32_t bus_time_us{0};   // modeled time on the bus, at the configured frequency
+  uint32_t exec_time_us{0};  // measured execution time, including the i2c driver overhead
+};
+
+// Bus lease with the RPi driver, the other master on the i2c bus
+struct LeaseStats {
+  uint32_t acquires{0};
+  uint32_t contentions{0};    // transactions deferred, as the RPi held the bus
+  uint32_t collisions{0};     // simultaneous claims, on which the RPi has priority
+  uint32_t expired{0};        // RPi claims held beyond the timeout: the bus got taken anyway
+  uint32_t max_wait_us{0};    // longest deferral of a transaction
+  uint32_t total_wait_us{0};
+  uint32_t peer_leases{0};    // bus claims by the RPi
+  uint32_t peer_changes{0};   // of which signaled register changes
+};
+
+using ErrorCode = i2c::ErrorCode;
+
+/**
+ * Called in the esphome main loop on completion of a queued transaction.
+ * For a read, 'data' and 'len' provide the obtained register content.
+ */
+using Callback = std::function<void(ErrorCode err, const uint8_t *data, size_t len)>;
+
+static const size_t MAX_DATA_LEN = 8;   // max bytes per transaction
+static const size_t QUEUE_LEN    = 16;  // max pending transactions
+
+class I2cQueue : public Component {
+  public:
+    void setup() override;
+    void loop() override;
+    void dump_config() override;
+    float get_setup_priority() const override { return setup_priority::BUS; }
+    void set_max_loop_time(uint32_t max_loop_time_us) { max_loop_time_us_ = max_loop_time_us; }
+    void set_bus_frequency(uint32_t bus_frequency) { bus_frequency_ = bus_frequency; }
+
+    /**
+     * Share the bus with the RPi driver, through a lease on two lines. Each side claims the bus
+     * by pulling its own line low, and waits while the other one holds its line.
+     * On a simultaneous claim the RPi has priority. A claim held for at least the change time
+     * signals register changes, for the other side to read them back.
+     * See 'codecs/dacxo.h' of the RPi driver for the other side.
+     *
+     * @param pin Own claim line: 'uinotify' of the RPi driver.
+     * @param peer_pin Claim line of the RPi: 'uisync'.
+     */
+    void set_lease_pins(InternalGPIOPin *pin, InternalGPIOPin *peer_pin) {
+      lease_pin_ = pin;
+      peer_pin_ = peer_pin;
+    }
+    /// Max hold time of a claim by the RPi: a claim held longer is considered stuck, and ignored
+    void set_lease_timeout(uint32_t timeout_us) { lease_timeout_us_ = timeout_us; }
+    void set_change_time(uint32_t change_time_us) { change_time_us_ = change_time_us; }
+
+    /**
+     * Signal own register changes to the RPi, once the pending transactions are done.
+     * Without lease pins, this has no effect.
+     */
+    void signal_change();
+
+    /// Called from the main loop when the RPi signaled its register changes
+    void add_on_peer_change_callback(std::function<void()> &&callback) {
+      peer_change_callback_.add(std::move(callback));
+    }
+    /// A copy, as the RPi claims are counted in the interrupt handler
+    LeaseStats get_lease_stats() const;
+
+    /**
+     * Queue a register write. A pending write of the same length to the same device register
+     * is superseded: it gets the new data, moves to the end of the queue as a new submit would,
+     * and both callbacks are called.
+     *
+     * @param device The i2c device, such as a Pcm1792I2C or the FPGA 'i2c_device'.
+     * @param reg First register to write, using the device register auto-increment.
+     * @param data Register content, is copied into the queue.
+     * @param len Number of bytes, at most MAX_DATA_LEN.
+     * @param prio Priority class of this transaction.
+     * @param callback Optional, called on completion.
+     * @return false if the transaction could not be queued.
+     */
+    bool write(i2c::I2CDevice *device, uint8_t reg, const uint8_t *data, size_t len,
+               Priority prio, Callback &&callback = nullptr);
+
+    /**
+     * Queue a register read. An identical pending read is shared, calling both callbacks.
+     *
+     * @param device The i2c device.
+     * @param reg First register to read, using the device register auto-increment.
+     * @param len Number of bytes, at most MAX_DATA_LEN.
+     * @param prio Priority class of this transaction.
+     * @param callback Receives the read data on completion.
+     * @return false if the transaction could not be queued.
+     */
+    bool read(i2c::I2CDevice *device, uint8_t reg, size_t len, Priority prio, Callback &&callback);
+
+    /**
+     * @return true if no transactions are pending.
+     */
+    bool is_idle() const { return num_pending_ == 0; }
+
+    /**
+     * Account the transactions that are submitted until end_operation() to this operation.
+     * Transactions submitted from their completion callbacks are accounted to the same operation.
+     * Preferably use an OperationScope.
+     *
+     * @param count_operation false if this continues a previous operation, such as after a delay.
+     * @return false if another operation is active: the transactions remain accounted to that one.
+     */
+    bool begin_operation(Operation op, bool count_operation = true);
+    void end_operation() { operation_ = OP_OTHER; }
+
+    const Stats &get_stats(Operation op) const { return stats_[op]; }
+    void reset_stats() {
+      stats_.fill(Stats());
+      lease_stats_ = LeaseStats();
+      peer_leases_ = 0;
+      peer_changes_ = 0;
+    }
+
+    /**
+     * Log the bus traffic per operation, such as to compare the effect of optimizations.
+     */
+    void log_stats() const;
+
+  protected:
+    struct Transaction {
+      i2c::I2CDevice *device{nullptr};
+      uint32_t seq{0};  // submission order, for FIFO behavior within a priority class
+      Priority prio{PRIO_STATUS};
+      Operation op{OP_OTHER};
+      bool is_read{false};
+      uint8_t reg{0};
+      uint8_t len{0};
+      std::array<uint8_t, MAX_DATA_LEN> data{};
+      Callback callback;
+    };
+
+    bool submit_(i2c::I2CDevice *device, bool is_read, uint8_t reg, const uint8_t *data, size_t len,
+                 Priority prio, Callback &&callback);
+    Transaction *find_pending_(i2c::I2CDevice *device, bool is_read, uint8_t reg, size_t len);
+    Transaction *next_();
+    void execute_(Transaction *t);
+    /// @return Modeled time on the bus of a transaction with 'len' data bytes
+    uint32_t bus_time_us_(bool is_read, size_t len) const;
+    /// @return true if this side holds the bus lease, false to retry later
+    bool acquire_lease_();
+    void release_lease_();
+    bool defer_lease_(uint32_t now, bool is_collision);
+    static void peer_isr_(I2cQueue *queue);
+
+    std::array<Transaction, QUEUE_LEN> queue_;  // slots with a 'device' are pending
+    size_t num_pending_{0};
+    uint32_t next_seq_{0};
+    uint32_t max_loop_time_us_{2000};
+    uint32_t num_coalesced_{0};
+    uint32_t num_overflows_{0};
+    uint32_t bus_frequency_{100000};
+    Operation operation_{OP_OTHER};
+    std::array<Stats, NUM_OPERATIONS> stats_{};
+    HighFrequencyLoopRequester high_freq_;
+
+    InternalGPIOPin *lease_pin_{nullptr};
+    InternalGPIOPin *peer_pin_{nullptr};
+    ISRInternalGPIOPin peer_isr_pin_;
+    uint32_t lease_timeout_us_{50000};
+    uint32_t change_time_us_{3000};
+    bool lease_held_{false};
+    bool lease_waiting_{false};   // a transaction is deferred
+    uint32_t wait_start_us_{0};
+    uint32_t retry_at_us_{0};
+    uint32_t backoff_us_{0};
+    bool change_pending_{false};  // signal_change() called
+    bool change_holding_{false};  // holding the lease for the change time
+    uint32_t change_start_us_{0};
+    // peer claim state, as maintained by the interrupt handler
+    volatile bool peer_held_{false};
+    volatile uint32_t peer_since_us_{0};
+    std::atomic<bool> peer_changed_{false};
+    std::atomic<uint32_t> peer_leases_{0};
+    std::atomic<uint32_t> peer_changes_{0};
+    LeaseStats lease_stats_;  // without the peer counts above, updated in the main loop only
+    CallbackManager<void()> peer_change_callback_;
+};
+
+class PeerChangeTrigger : public Trigger<> {
+  public:
+    explicit PeerChangeTrigger(I2cQueue *queue) {
+      queue->add_on_peer_change_callback([this]() { this->trigger(); });
+    }
+};
+
+/**
+ * Accounts the bus traffic to an operation, for the lifetime of this object. Nested scopes have no effect.
+ * In a lambda: i2c_queue::OperationScope scope(id(i2c_bus_queue), i2c_queue::OP_VOLUME);
+ */
+class OperationScope {
+  public:
+    OperationScope(I2cQueue *queue, Operation op, bool count_operation = true)
+        : queue_(queue), is_outer_(queue->begin_operation(op, count_operation)) {}
+    ~OperationScope() {
+      if (is_outer_)
+        queue_->end_operation();
+    }
+    OperationScope(const OperationScope &) = delete;
+    OperationScope &operator=(const OperationScope &) = delete;
+
+  protected:
+    I2cQueue *queue_;
+    bool is_outer_;
+};
+
+}  // namespace i2c_queue
+}  // namespace esphome
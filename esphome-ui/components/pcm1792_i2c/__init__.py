@@ -1,13 +1,16 @@
 import esphome.codegen as cg
 import esphome.config_validation as cv
-from esphome.components import i2c
+from esphome.components import i2c, i2c_queue
 from esphome.const import CONF_ID
 from esphome.const import CONF_MODE
 
 DEPENDENCIES = ["i2c"]
+AUTO_LOAD = ["i2c_queue"]
 CODEOWNERS = ["@JosVanEijndhoven"]
 MULTI_CONF = True
 
+CONF_QUEUE_ID = "queue_id"
+
 pcm1792_i2c_ns = cg.esphome_ns.namespace("pcm1792_i2c")
 
 Pcm1792I2C = pcm1792_i2c_ns.class_(
@@ -18,6 +21,7 @@ CONFIG_SCHEMA = cv.Schema(
     {
         cv.GenerateID(CONF_ID): cv.declare_id(Pcm1792I2C),
         cv.Optional(CONF_MODE): cv.uint32_t,
+        cv.Optional(CONF_QUEUE_ID): cv.use_id(i2c_queue.I2cQueue),
     }
 ).extend(i2c.i2c_device_schema(None))
 
@@ -26,4 +30,7 @@ async def to_code(config):
     var = cg.new_Pvariable(config[CONF_ID])
     await cg.register_component(var, config)
     await i2c.register_i2c_device(var, config)
+    if CONF_QUEUE_ID in config:
+        queue = await cg.get_variable(config[CONF_QUEUE_ID])
+        cg.add(var.set_queue(queue))
     cg.add(var.set_mode(config[CONF_MODE]))
@@ -1,63 +1,231 @@
 #include "pcm1792_i2c.h"
 #include "esphome/core/log.h"
 #include "esphome/core/hal.h"
+#include <algorithm>
 #include <cinttypes>
+#include <cstdio>
  
 namespace esphome {
 namespace pcm1792_i2c {
  
 static const char *const TAG = "pcm1792";
+
+// Names of the mode field values, as printed by mode_to_string().
+// Single-bit fields have no name for their '0' value.
+struct FieldNames {
+  uint32_t mask;
+  uint8_t shift;
+  uint8_t num_names;
+  const char *const *names;
+};
+
+template<typename Field, size_t N>
+static constexpr FieldNames field_names(const char *const (&names)[N]) {
+  static_assert(N == Field::num_values, "Need one name per legal field value");
+  return {Field::mask, Field::shift, N, names};
+}
+
+static const char *const DME_NAMES[]  = {nullptr, "Dme"};
+static const char *const DMF_NAMES[]  = {"DmfNo", "Dmf48", "Dmf44", "Dmf32"};
+static const char *const FMT_NAMES[]  = {"Fmt16R", "Fmt20R", "Fmt24R", "Fmt24L", "Fmt16I", "Fmt24I"};
+static const char *const MUTE_NAMES[] = {nullptr, "Mute"};
+static const char *const ATLD_NAMES[] = {nullptr, "Atld"};
+static const char *const INZD_NAMES[] = {nullptr, "Inzd"};
+static const char *const FLT_NAMES[]  = {nullptr, "Flt"};
+static const char *const DFMS_NAMES[] = {nullptr, "Dfms"};
+static const char *const OPE_NAMES[]  = {nullptr, "Ope"};
+static const char *const ATS_NAMES[]  = {"AtsLr1", "AtsLr2", "AtsLr4", "AtsLr8"};
+static const char *const OS_NAMES[]   = {"Os64", "Os32", "Os128"};
+static const char *const CHSL_NAMES[] = {nullptr, "Right"};
+static const char *const MONO_NAMES[] = {nullptr, "Mono"};
+static const char *const DFTH_NAMES[] = {nullptr, "Dfth"};
+static const char *const DSD_NAMES[]  = {nullptr, "Dsd"};
+static const char *const SRST_NAMES[] = {nullptr, "Srst"};
+static const char *const RSV_NAMES[]  = {nullptr, "Rsv"};
+
+static constexpr FieldNames MODE_FIELD_NAMES[] = {
+  field_names<FIELD_MUTE>(MUTE_NAMES),
+  field_names<FIELD_DME>(DME_NAMES),
+  field_names<FIELD_DMF>(DMF_NAMES),
+  field_names<FIELD_FMT>(FMT_NAMES),
+  field_names<FIELD_ATLD>(ATLD_NAMES),
+  field_names<FIELD_INZD>(INZD_NAMES),
+  field_names<FIELD_FLT>(FLT_NAMES),
+  field_names<FIELD_DFMS>(DFMS_NAMES),
+  field_names<FIELD_OPE>(OPE_NAMES),
+  field_names<FIELD_ATS>(ATS_NAMES),
+  field_names<FIELD_OS>(OS_NAMES),
+  field_names<FIELD_CHSL>(CHSL_NAMES),
+  field_names<FIELD_MONO>(MONO_NAMES),
+  field_names<FIELD_DFTH>(DFTH_NAMES),
+  field_names<FIELD_DSD>(DSD_NAMES),
+  field_names<FIELD_SRST>(SRST_NAMES),
+  field_names<FIELD_RSV>(RSV_NAMES)
+};
  
 void Pcm1792I2C::dump_config() {
   ESP_LOGCONFIG(TAG, "Pcm1792");
   LOG_I2C_DEVICE(this);
-  ESP_LOGCONFIG(TAG, "  Mode: 0x%08x {%s}", mode_, mode_to_string().c_str());
+  char mode_names[128];
+  mode_to_string(mode_, mode_names, sizeof(mode_names));
+  ESP_LOGCONFIG(TAG, "  Mode: 0x%08x {%s}", mode_, mode_names);
 }
  
 ErrorCode Pcm1792I2C::set_mode(uint32_t mode) {
   mode_ = mode;
-  ESP_LOGI(TAG, "Init PCM1792 mode=0x%08x on i2c bus_addr=0x%02x", mode, address_);
   std::array<uint8_t, 4> dacmode = {0, 0, 0, 0};
   for (int i = 0; i < 4; i++, mode >>= 8) {
     dacmode[i] = mode & 0xff;
   }
-  return write_register(REG_MODE, dacmode.data(), dacmode.size());
+  if (update_shadow_(REG_MODE, dacmode.data(), dacmode.size())) {
+    ESP_LOGI(TAG, "Init PCM1792 mode=0x%08x on i2c bus_addr=0x%02x", mode_, address_);
+  }
+  return flush();
 }
 
 ErrorCode Pcm1792I2C::set_volume64(uint8_t volume) {
   volume = std::min(volume, (uint8_t)64u);  // protect against out-of-bound argument
   const uint8_t vol_dac = (volume == 0) ? 0 : 2 * volume + 127; // pcm1792 uses 0..255
   const std::array<uint8_t, 2> i2c_data = {vol_dac, vol_dac};
-  ESP_LOGI(TAG, "Set PCM1792 volume=%02d on i2c bus_addr=0x%02x", volume, address_);
-  return write_register(REG_VOLUME, i2c_data.data(), i2c_data.size());
+  if (update_shadow_(REG_VOLUME, i2c_data.data(), i2c_data.size())) {
+    ESP_LOGI(TAG, "Set PCM1792 volume=%02d on i2c bus_addr=0x%02x", volume, address_);
+  }
+  return flush();
 }
 
-std::string Pcm1792I2C::mode_to_string() const {
-  uint32_t mode = mode_;
-  std::string names;
-  std::string sep = "";
-  // for multi-bit fields
-  for (const auto& field: mode_names_field_zero) {
-    uint32_t field_mask = field.first;
-    if (mode & field_mask) {
-      auto it = mode_names.find(mode & field_mask);
-      if (it != mode_names.end()) {
-        names += sep + it->second;
-      }
-      mode &= ~field_mask;  // remove processed non-zero field
+ErrorCode Pcm1792I2C::read_state(State *state) {
+  std::array<uint8_t, NUM_STATE_REGS> regs;
+  ErrorCode err = read_register(REG_FIRST, regs.data(), regs.size());  // uses chip register auto-increment
+  if (err) {
+    ESP_LOGW(TAG, "Read PCM1792 state on i2c bus_addr=0x%02x: i2c error %d", address_, err);
+    return err;
+  }
+  load_state_(regs.data(), state);
+  return i2c::ERROR_OK;
+}
+
+void Pcm1792I2C::read_state(std::function<void(ErrorCode err, const State &state)> &&callback) {
+  if (queue_ == nullptr) {
+    State state{};
+    ErrorCode err = read_state(&state);
+    callback(err, state);
+    return;
+  }
+  queue_->read(this, REG_FIRST, NUM_STATE_REGS, i2c_queue::PRIO_CONTROL,
+               [this, callback = std::move(callback)](ErrorCode err, const uint8_t *data, size_t) {
+    State state{};
+    if (err) {
+      ESP_LOGW(TAG, "Read PCM1792 state on i2c bus_addr=0x%02x: i2c error %d", address_, err);
     } else {
-      names += sep + field.second;
+      load_state_(data, &state);
+    }
+    callback(err, state);
+  });
+}
+
+void Pcm1792I2C::load_state_(const uint8_t *regs, State *state) {
+  const uint8_t mask = (1u << NUM_STATE_REGS) - 1;
+  std::copy(regs, regs + NUM_STATE_REGS, shadow_.begin());
+  valid_ |= mask;
+  dirty_ &= ~mask;
+  mode_ = 0;
+  for (int i = 3; i >= 0; i--) {
+    mode_ = (mode_ << 8) | regs[REG_MODE - REG_FIRST + i];
+  }
+  state->volume_l = regs[0];
+  state->volume_r = regs[1];
+  state->mode = mode_;
+}
+
+ErrorCode Pcm1792I2C::get_volume64(uint8_t *volume) {
+  State state;
+  ErrorCode err = read_state(&state);
+  if (err)
+    return err;
+  *volume = volume64_from_reg(state.volume_l);
+  return i2c::ERROR_OK;
+}
+
+uint8_t Pcm1792I2C::volume64_from_reg(uint8_t vol_dac) {
+  // inverse of set_volume64(). The RPi writes odd values 255 - 2 * attenuation_dB,
+  // where attenuations beyond 63dB still produce some (1) volume, only 0 is silent.
+  return (vol_dac == 0) ? 0 : (vol_dac <= 129) ? 1 : (vol_dac - 127) / 2;
+}
+
+ErrorCode Pcm1792I2C::get_mode(uint32_t *mode) {
+  State state;
+  ErrorCode err = read_state(&state);
+  if (!err)
+    *mode = state.mode;
+  return err;
+}
+
+bool Pcm1792I2C::update_shadow_(uint8_t reg, const uint8_t *data, size_t len) {
+  // Returns true if any register content changed, which then needs a flush()
+  bool changed = false;
+  for (size_t i = 0; i < len; i++) {
+    const uint8_t idx = reg - REG_FIRST + i;
+    const uint8_t bit = 1u << idx;
+    if (!(valid_ & bit) || shadow_[idx] != data[i]) {
+      shadow_[idx] = data[i];
+      valid_ |= bit;
+      dirty_ |= bit;
+      changed = true;
     }
-    sep = ",";
   }
-  // for single-bit fields
-  for (const auto& field: mode_names) {
-    uint32_t field_mask = field.first;  // presumably has a only single bit raised
-    if (mode & field_mask) {
-      names += sep + field.second;
+  return changed;
+}
+
+ErrorCode Pcm1792I2C::flush() {
+  while (dirty_) {
+    // Start a burst at the first dirty register. Extend it over further dirty registers,
+    // also bridging clean (but valid) registers in between: one longer burst is cheaper than two.
+    const uint8_t first = __builtin_ctz(dirty_);
+    uint8_t last = first;
+    for (uint8_t idx = first + 1; idx < NUM_CACHED_REGS && (valid_ & (1u << idx)); idx++) {
+      if (dirty_ & (1u << idx))
+        last = idx;
+    }
+    const uint8_t len = last - first + 1;
+    const uint8_t mask = ((1u << len) - 1) << first;
+    if (queue_ != nullptr) {
+      queue_->write(this, REG_FIRST + first, &shadow_[first], len, i2c_queue::PRIO_VOLUME,
+                    [this, mask](ErrorCode err, const uint8_t *, size_t) {
+        if (err) {
+          ESP_LOGW(TAG, "Flush PCM1792 on i2c bus_addr=0x%02x: i2c error %d", address_, err);
+          dirty_ |= mask & valid_;  // retry on next flush, unless the cache got invalidated
+        }
+      });
+      dirty_ &= ~mask;
+      continue;
+    }
+    ErrorCode err = write_register(REG_FIRST + first, &shadow_[first], len);
+    if (err) {
+      ESP_LOGW(TAG, "Flush PCM1792 regs %d..%d on i2c bus_addr=0x%02x: i2c error %d",
+               REG_FIRST + first, REG_FIRST + last, address_, err);
+      return err;  // keep these registers dirty, for a later retry
     }
+    dirty_ &= ~mask;
+  }
+  return i2c::ERROR_OK;
+}
+
+size_t Pcm1792I2C::mode_to_string(uint32_t mode, char *buf, size_t buf_len) {
+  size_t len = 0;
+  if (buf_len == 0)
+    return 0;
+  buf[0] = '\0';
+  for (const auto &field : MODE_FIELD_NAMES) {
+    const uint32_t value = (mode & field.mask) >> field.shift;
+    const char *name = (value < field.num_names) ? field.names[value] : "Rsv";
+    if (name == nullptr)
+      continue;  // single-bit field which is not set
+    int n = std::snprintf(buf + len, buf_len - len, "%s%s", (len == 0) ? "" : ",", name);
+    if (n < 0 || len + n >= buf_len)
+      return buf_len - 1;  // truncated
+    len += n;
   }
-  return names;
+  return len;
 }
 
 }  // namespace pcm1792_i2c
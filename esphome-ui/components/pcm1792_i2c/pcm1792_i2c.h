@@ -1,90 +1,107 @@
 #pragma once
 
-#include <map>
+#include <array>
 #include "esphome/core/component.h"
 #include "esphome/components/i2c/i2c.h"
+#include "esphome/components/i2c_queue/i2c_queue.h"
  
 namespace esphome {
 namespace pcm1792_i2c {
  
-// pcm1792 operation modes, corresponding to i2c reg 18 (lsb) to reg 21 (msb)
-// For MOXO_XXX field names, the XXX name corrsponds to the name in the datasheet
-enum Mode: uint32_t {
-  MODE_MUTE = 0x000001,
-  MODE_DME  = 0x000002,
-  MODE_DMF  = 0x00000c,
-  MODE_DMF_NO   = 0x000000,
-  MODE_DMF_48   = 0x000004,
-  MODE_DMF_44   = 0x000008,
-  MODE_DMF_32   = 0x00000c,
-  MODE_FMT  = 0x000070,
-  MODE_FMT_16R  = 0x000000,
-  MODE_FMT_20R  = 0x000010,
-  MODE_FMT_24R  = 0x000020,
-  MODE_FMT_24L  = 0x000030,
-  MODE_FMT_16I  = 0x000040,
-  MODE_FMT_24I  = 0x000050,
-  MODE_ATLD = 0x000080,
-  MODE_INZD = 0x000100,
-  MODE_FLT  = 0x000200,
-  MODE_DFMS = 0x000400,
-  MODE_OPE  = 0x001000,
-  MODE_ATS  = 0x006000,
-  MODE_ATS_LR1  = 0x000000,
-  MODE_ATS_LR2  = 0x002000,
-  MODE_ATS_LR4  = 0x004000,
-  MODE_ATS_LR8  = 0x006000,
-  MODE_OS   = 0x030000,
-  MODE_OS_64    = 0x000000,
-  MODE_OS_32    = 0x010000,
-  MODE_OS_128   = 0x020000,
-  MODE_CHSL = 0x040000,
-  MODE_MONO = 0x080000,
-  MODE_DFTH = 0x100000,
-  MODE_DSD  = 0x200000,
-  MODE_SRST = 0x400000,
-  MODE_RSV  = 0x800000
-};
+// Compile-time description of a bit field in the pcm1792 operation mode,
+// which corresponds to i2c reg 18 (lsb) to reg 21 (msb).
+// NumValues limits the legal field values, for fields with reserved encodings.
+template<uint8_t Shift, uint8_t Width, uint8_t NumValues = (1u << Width)>
+struct ModeField {
+  static_assert(Width >= 1 && Shift + Width <= 32, "Field exceeds the mode registers");
+  static_assert(Shift / 8 == (Shift + Width - 1) / 8, "Field must not cross a register boundary");
+  static_assert(NumValues >= 1 && NumValues <= (1u << Width), "Too many values for field width");
+  static constexpr uint8_t shift = Shift;
+  static constexpr uint8_t num_values = NumValues;
+  static constexpr uint32_t mask = ((1u << Width) - 1) << Shift;
 
-const static std::map<uint32_t, const char *> mode_names = {
-  {MODE_MUTE,    "Mute"},
-  {MODE_DME,     "Dme"},
-  {MODE_DMF_48,  "Dmf48"},
-  {MODE_DMF_44,  "Dmf44"},
-  {MODE_DMF_32,  "Dmf32"},
-  {MODE_FMT_20R, "Fmt20R"},
-  {MODE_FMT_24R, "Fmt24R"},
-  {MODE_FMT_24L, "Fmt24L"},
-  {MODE_FMT_16I, "Fmt16I"},
-  {MODE_FMT_24I, "Fmt24I"},
-  {MODE_ATLD,    "Atld"},
-  {MODE_INZD,    "Inzd"},
-  {MODE_FLT,     "Flt"},
-  {MODE_DFMS,    "Dfms"},
-  {MODE_OPE,     "Ope"},
-  {MODE_ATS_LR2, "AtsLr2"},
-  {MODE_ATS_LR4, "AtsLr4"},
-  {MODE_ATS_LR8, "AtsLr8"},
-  {MODE_OS_32,   "Os32"},
-  {MODE_OS_128,  "Os128"},
-  {MODE_CHSL,    "Right"},
-  {MODE_MONO,    "Mono"},
-  {MODE_DFTH,    "Dfth"},
-  {MODE_DSD,     "Dsd"},
-  {MODE_SRST,    "Srst"},
-  {MODE_RSV,     "Rsv"}
+  static constexpr bool is_legal(uint32_t value) { return value < NumValues; }
+  static constexpr uint32_t get(uint32_t mode) { return (mode & mask) >> Shift; }
+  static constexpr uint32_t set(uint32_t mode, uint32_t value) { return (mode & ~mask) | ((value << Shift) & mask); }
+  template<uint32_t Value> static constexpr uint32_t encode() {
+    static_assert(Value < NumValues, "Illegal value for this mode field");
+    return Value << Shift;
+  }
 };
 
-const static std::map<uint32_t, const char *> mode_names_field_zero = {
-  {MODE_DMF,     "DmfNo"},
-  {MODE_FMT,     "Fmt16R"},
-  {MODE_ATS,     "AtsLr1"},
-  {MODE_OS,      "Os64"}
+// For FIELD_XXX names, the XXX name corrsponds to the name in the datasheet
+using FIELD_MUTE = ModeField<0, 1>;
+using FIELD_DME  = ModeField<1, 1>;
+using FIELD_DMF  = ModeField<2, 2>;
+using FIELD_FMT  = ModeField<4, 3, 6>;   // values 6 and 7 are reserved
+using FIELD_ATLD = ModeField<7, 1>;
+using FIELD_INZD = ModeField<8, 1>;
+using FIELD_FLT  = ModeField<9, 1>;
+using FIELD_DFMS = ModeField<10, 1>;
+using FIELD_OPE  = ModeField<12, 1>;
+using FIELD_ATS  = ModeField<13, 2>;
+using FIELD_OS   = ModeField<16, 2, 3>;  // value 3 is reserved
+using FIELD_CHSL = ModeField<18, 1>;
+using FIELD_MONO = ModeField<19, 1>;
+using FIELD_DFTH = ModeField<20, 1>;
+using FIELD_DSD  = ModeField<21, 1>;
+using FIELD_SRST = ModeField<22, 1>;
+using FIELD_RSV  = ModeField<23, 1>;
+
+// pcm1792 operation modes, as bit-wise OR-able constants of above fields
+// For MOXO_XXX field names, the XXX name corrsponds to the name in the datasheet
+enum Mode: uint32_t {
+  MODE_MUTE = FIELD_MUTE::mask,
+  MODE_DME  = FIELD_DME::mask,
+  MODE_DMF  = FIELD_DMF::mask,
+  MODE_DMF_NO   = FIELD_DMF::encode<0>(),
+  MODE_DMF_48   = FIELD_DMF::encode<1>(),
+  MODE_DMF_44   = FIELD_DMF::encode<2>(),
+  MODE_DMF_32   = FIELD_DMF::encode<3>(),
+  MODE_FMT  = FIELD_FMT::mask,
+  MODE_FMT_16R  = FIELD_FMT::encode<0>(),
+  MODE_FMT_20R  = FIELD_FMT::encode<1>(),
+  MODE_FMT_24R  = FIELD_FMT::encode<2>(),
+  MODE_FMT_24L  = FIELD_FMT::encode<3>(),
+  MODE_FMT_16I  = FIELD_FMT::encode<4>(),
+  MODE_FMT_24I  = FIELD_FMT::encode<5>(),
+  MODE_ATLD = FIELD_ATLD::mask,
+  MODE_INZD = FIELD_INZD::mask,
+  MODE_FLT  = FIELD_FLT::mask,
+  MODE_DFMS = FIELD_DFMS::mask,
+  MODE_OPE  = FIELD_OPE::mask,
+  MODE_ATS  = FIELD_ATS::mask,
+  MODE_ATS_LR1  = FIELD_ATS::encode<0>(),
+  MODE_ATS_LR2  = FIELD_ATS::encode<1>(),
+  MODE_ATS_LR4  = FIELD_ATS::encode<2>(),
+  MODE_ATS_LR8  = FIELD_ATS::encode<3>(),
+  MODE_OS   = FIELD_OS::mask,
+  MODE_OS_64    = FIELD_OS::encode<0>(),
+  MODE_OS_32    = FIELD_OS::encode<1>(),
+  MODE_OS_128   = FIELD_OS::encode<2>(),
+  MODE_CHSL = FIELD_CHSL::mask,
+  MODE_MONO = FIELD_MONO::mask,
+  MODE_DFTH = FIELD_DFTH::mask,
+  MODE_DSD  = FIELD_DSD::mask,
+  MODE_SRST = FIELD_SRST::mask,
+  MODE_RSV  = FIELD_RSV::mask
 };
 
 enum Reg: uint8_t {
   REG_MODE   = 18,
-  REG_VOLUME = 16
+  REG_VOLUME = 16,
+  REG_FIRST  = 16,  // first register held in the shadow cache
+  REG_LAST   = 23   // last register held in the shadow cache. Regs 22 and 23 are read-only
+};
+
+static const uint8_t NUM_CACHED_REGS = REG_LAST - REG_FIRST + 1;
+static const uint8_t NUM_STATE_REGS  = 6;  // regs 16..21: volume and mode
+
+// Chip register content as obtained by read_state()
+struct State {
+  uint8_t volume_l;  // raw attenuation register 16: 255 is 0dB, 0.5dB per step
+  uint8_t volume_r;  // raw attenuation register 17
+  uint32_t mode;     // bit-wise OR of 'enum Mode' constants, from regs 18..21
 };
 
 using ErrorCode = i2c::ErrorCode;
@@ -93,6 +110,12 @@ class Pcm1792I2C : public Component, public i2c::I2CDevice {
   public:
     void dump_config() override;
     float get_setup_priority() const override { return setup_priority::DATA; }
+
+    /**
+     * Optionally have all i2c writes and the read_state() with callback performed
+     * through a transaction queue, so that they do not block the esphome main loop.
+     */
+    void set_queue(i2c_queue::I2cQueue *queue) { queue_ = queue; }
     /**
      * Set operating mode of the dac chip. Although not common,
      * this could be modified at run-time.
@@ -109,10 +132,114 @@ class Pcm1792I2C : public Component, public i2c::I2CDevice {
      * @return Result of the I2C bus operation, with 0 indicating success.
      */
     ErrorCode set_volume64(uint8_t volume);
+
+    /**
+     * Write all pending register changes of the shadow cache to the chip,
+     * as one i2c burst per contiguous range of changed registers.
+     * Registers that failed to write remain pending for a next flush.
+     *
+     * With a queue, the writes are submitted rather than executed: a later bus error
+     * is logged, and marks the registers pending again.
+     *
+     * @return Result of the I2C bus operation, with 0 indicating success.
+     */
+    ErrorCode flush();
+
+    /**
+     * Read the volume and mode registers (16..21) from the chip in one i2c burst.
+     * The chip content replaces the shadow cache, discarding pending writes:
+     * another i2c master (the RPi) might have written these registers.
+     *
+     * @param state Receives the register content.
+     * @return Result of the I2C bus operation, with 0 indicating success.
+     */
+    ErrorCode read_state(State *state);
+
+    /**
+     * As above, but without blocking: through the queue if available.
+     * The callback is called from the esphome main loop on completion.
+     */
+    void read_state(std::function<void(ErrorCode err, const State &state)> &&callback);
+
+    /**
+     * Read back the volume of the dac chip, as set by set_volume64(), or by the RPi.
+     * Performs a read_state(), and converts the left channel attenuation register.
+     *
+     * @param volume Receives 0: silent, 1: lowest volume, 64: max volume
+     * @return Result of the I2C bus operation, with 0 indicating success.
+     */
+    ErrorCode get_volume64(uint8_t *volume);
+
+    /**
+     * Convert a raw attenuation register value to the 0..64 volume of set_volume64().
+     */
+    static uint8_t volume64_from_reg(uint8_t vol_dac);
+
+    /**
+     * Read back the operating mode of the dac chip. Performs a read_state().
+     *
+     * @param mode Receives a bit-wise OR of various 'enum Mode' constants.
+     * @return Result of the I2C bus operation, with 0 indicating success.
+     */
+    ErrorCode get_mode(uint32_t *mode);
+
+    /**
+     * Read-modify-write of a single mode field, such as FIELD_OS or FIELD_FLT.
+     * Only the register holding this field is written, and only if it changed.
+     *
+     * @param value New field value, such as 2 for 128x oversampling in FIELD_OS.
+     * @return Result of the I2C bus operation, or ERROR_INVALID_ARGUMENT on an illegal value.
+     */
+    template<typename Field> ErrorCode set_field(uint32_t value) {
+      if (!Field::is_legal(value))
+        return i2c::ERROR_INVALID_ARGUMENT;
+      return set_mode(Field::set(mode_, value));
+    }
+
+    /**
+     * As above, with the field value checked at compile time,
+     * such as: set_field<FIELD_OS, 2>()
+     */
+    template<typename Field, uint32_t Value> ErrorCode set_field() {
+      return set_mode((mode_ & ~Field::mask) | Field::template encode<Value>());
+    }
+
+    /**
+     * @return The value of a single field from the last written or read-back mode.
+     */
+    template<typename Field> uint32_t get_field() const { return Field::get(mode_); }
+
+    /**
+     * Format the field names of a mode into a caller-supplied buffer, without heap allocation.
+     * Like: "DmfNo,Fmt24L,Atld,Flt,AtsLr8,Os64,Mono"
+     *
+     * @return The number of characters written, excluding the terminating 0.
+     */
+    static size_t mode_to_string(uint32_t mode, char *buf, size_t buf_len);
+
+    /**
+     * Mark all cached registers as pending, so that the next flush rewrites them.
+     * To be used after the chip lost its register content, such as on analog power-up.
+     */
+    void mark_dirty() { dirty_ = valid_; }
+
+    /**
+     * Forget the cached register content, because another i2c master (the RPi)
+     * might have changed the chip registers.
+     * Subsequent set_xxx() calls will then always write to the chip.
+     */
+    void invalidate_cache() { valid_ = 0; dirty_ = 0; }
  
   protected:
-    uint32_t mode_;
-    std::string mode_to_string() const;
+    uint32_t mode_{0};
+
+    // Shadow copy of chip registers REG_FIRST..REG_LAST, indexed by (reg - REG_FIRST)
+    std::array<uint8_t, NUM_CACHED_REGS> shadow_{};
+    uint8_t valid_{0};  // bit i set: shadow_[i] matches the (intended) chip register content
+    uint8_t dirty_{0};  // bit i set: shadow_[i] is not yet written to the chip
+    bool update_shadow_(uint8_t reg, const uint8_t *data, size_t len);
+    void load_state_(const uint8_t *regs, State *state);
+    i2c_queue::I2cQueue *queue_{nullptr};
 };
  
 }  // namespace pcm1792_i2c
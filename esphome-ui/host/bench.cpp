@@ -0,0 +1,524 @@
+// Bus traffic benchmark of the dac UI controller on a simulated i2c bus, see 'README.md' in esphome-ui.
+// Runs the user operations of dac.yaml in simulated time, and reports the i2c transactions, bytes and
+// modeled bus time per operation. With --check, it fails when a scenario exceeds its budget.
+
+#include "esphome_host.h"
+#include "sim_bus.h"
+#include "esphome/components/dacxo_fpga/dacxo_fpga.h"
+#include "esphome/components/i2c_queue/i2c_queue.h"
+#include "esphome/components/pcm1792_i2c/pcm1792_i2c.h"
+#include "esphome/components/text_sensor/text_sensor.h"
+#include "esphome/core/log.h"
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <getopt.h>
+#include <vector>
+
+using namespace esphome;
+using i2c_queue::I2cQueue;
+using i2c_queue::Operation;
+
+static const char *const TAG = "bench";
+
+static const char *const OPERATION_NAMES[i2c_queue::NUM_OPERATIONS] =
+    {"other", "volume", "input", "power-up", "power-off", "uisync", "status"};
+
+/**
+ * The lambdas and scripts of dac.yaml that drive the i2c bus, on the components of the bench.
+ * Keep these in sync with dac.yaml: the yaml lambdas cannot be built outside esphome.
+ */
+class DacUi : public Component {
+  public:
+    DacUi(I2cQueue *queue, dacxo_fpga::DacxoFpga *fpga, pcm1792_i2c::Pcm1792I2C *dac_l,
+          pcm1792_i2c::Pcm1792I2C *dac_r)
+        : queue_(queue), fpga_(fpga), dac_l_(dac_l), dac_r_(dac_r) {}
+
+    /// The rotary encoder: number.set of the volume per detent
+    void turn_knob(int steps) {
+      set_volume(std::max(0, std::min(64, (int) volume_ + steps)));
+    }
+
+    /// The 'volume' number on_value
+    void set_volume(uint8_t volume) {
+      volume_ = volume;
+      if (mute_)
+        set_mute(false);  // de-activate mute on a volume change
+      if (only_update_ui_)
+        return;  // a volume read back from the RPi driver
+      if (!pipeline_running_) {
+        // script volume_pipeline
+        pipeline_running_ = true;
+        set_volume_mute_(false);
+        set_timeout("volume_pipeline", 50, [this]() {
+          set_volume_mute_(false);
+          pipeline_running_ = false;
+        });
+      }
+      if (!cec_report_running_) {
+        // script cec_volume_report
+        cec_report_running_ = true;
+        send_cec_volume_(false);
+        set_timeout("cec_volume_report", 300, [this]() {
+          send_cec_volume_(true);
+          cec_report_running_ = false;
+        });
+      }
+    }
+
+    /// The 'Mute' switch
+    void set_mute(bool mute) {
+      if (mute == mute_)
+        return;
+      mute_ = mute;
+      set_volume_mute_(false);
+    }
+
+    /// The 'channel' number on_value: 0..3 for s/pdif, 4 for the RPi
+    void select_channel(uint8_t chan) {
+      channel_ = chan;
+      if (only_update_ui_)
+        return;
+      i2c_queue::OperationScope scope(queue_, i2c_queue::OP_INPUT);
+      const uint8_t val = (chan <= 3) ? 0x80 | (chan << 2) : 0x80 | 0x01;
+      fpga_->write_gpo0(val, i2c_queue::PRIO_CONTROL);
+      queue_->signal_change();  // script notify_pi
+    }
+
+    /// The 'Power' switch on_turn_on
+    void power_on() {
+      {
+        i2c_queue::OperationScope scope(queue_, i2c_queue::OP_POWER_UP);
+        const uint8_t seldata = (channel_ <= 3) ? 0x80 | (channel_ << 2) : 0x80 | 0x01;
+        fpga_->write_gpo0(seldata, i2c_queue::PRIO_CONTROL);
+        att20db_state_ = 1;  // attenuate relay for silent power-up
+        fpga_->write_gpo1(1, i2c_queue::PRIO_CONTROL);
+      }
+      set_timeout("power_on", 500, [this]() {
+        i2c_queue::OperationScope scope(queue_, i2c_queue::OP_POWER_UP, false);
+        const uint32_t mode = pcm1792_i2c::MODE_FMT_24L | pcm1792_i2c::MODE_ATLD | pcm1792_i2c::MODE_FLT |
+                              pcm1792_i2c::MODE_ATS_LR8 | pcm1792_i2c::MODE_MONO;
+        dac_l_->mark_dirty();
+        dac_r_->mark_dirty();
+        dac_l_->set_mode(mode);
+        dac_r_->set_mode(mode | pcm1792_i2c::MODE_CHSL);
+        power_is_on_ = true;
+        set_volume_mute_(false);
+      });
+    }
+
+    /// The 'Power' switch on_turn_off
+    void power_off() {
+      i2c_queue::OperationScope scope(queue_, i2c_queue::OP_POWER_OFF);
+      set_volume_mute_(true);
+      power_is_on_ = false;
+      fpga_->write_gpo0(0x00, i2c_queue::PRIO_CONTROL);
+      queue_->signal_change();
+    }
+
+    /// The i2c_queue lease on_peer_change: read back the changes of the RPi driver
+    void ui_sync() {
+      i2c_queue::OperationScope scope(queue_, i2c_queue::OP_UISYNC);
+      dac_r_->invalidate_cache();
+      fpga_->refresh([this](const dacxo_fpga::Snapshot &fpga) {
+        if (!fpga.is_valid())
+          return;
+        const uint8_t has_att20db = fpga.gpo1 & dacxo_fpga::GPO1_ATT20DB;
+        att20db_state_ = has_att20db;
+        only_update_ui_ = true;
+        select_channel(fpga.channel());
+        only_update_ui_ = false;
+        power_is_on_ = fpga.is_powered();
+        if (!power_is_on_)
+          return;
+        dac_l_->read_state([this, has_att20db](i2c::ErrorCode err, const pcm1792_i2c::State &state) {
+          if (err)
+            return;
+          const uint8_t pcm_volume = pcm1792_i2c::Pcm1792I2C::volume64_from_reg(state.volume_l);
+          uint8_t vol = pcm_volume;
+          if (has_att20db)
+            vol = (pcm_volume >= 20) ? pcm_volume - 20 : 0;
+          only_update_ui_ = true;
+          set_volume(vol);
+          mute_ = (vol == 0);
+          only_update_ui_ = false;
+        });
+      });
+    }
+
+    uint8_t get_volume() const { return volume_; }
+    uint32_t get_cec_frames() const { return cec_frames_; }
+    void reset_cec_frames() { cec_frames_ = 0; }
+
+  protected:
+    // global set_volume_mute
+    void set_volume_mute_(bool mute_override) {
+      if (only_update_ui_)
+        return;
+      i2c_queue::OperationScope scope(queue_, i2c_queue::OP_VOLUME);
+      uint8_t vol = volume_;
+      if (mute_ || mute_override)
+        vol = 0;
+      const uint8_t attenuate = (vol <= 44);
+      if (attenuate && vol != 0)
+        vol += 20;  // compensate on-chip attenuation for relay use
+      if (attenuate != att20db_state_) {
+        att20db_state_ = attenuate;
+        fpga_->write_gpo1(attenuate, i2c_queue::PRIO_VOLUME, [this](i2c::ErrorCode err, const uint8_t *, size_t) {
+          if (err)
+            att20db_state_ = -1;
+        });
+      }
+      if (power_is_on_) {
+        dac_l_->set_volume64(vol);
+        dac_r_->set_volume64(vol);
+      }
+      queue_->signal_change();  // script notify_pi
+    }
+
+    // global send_cec_volume, with hdmi connected
+    void send_cec_volume_(bool only_on_change) {
+      if (only_on_change && volume_ == cec_reported_volume_)
+        return;
+      cec_reported_volume_ = volume_;
+      cec_frames_++;
+    }
+
+    I2cQueue *queue_;
+    dacxo_fpga::DacxoFpga *fpga_;
+    pcm1792_i2c::Pcm1792I2C *dac_l_;
+    pcm1792_i2c::Pcm1792I2C *dac_r_;
+    uint8_t volume_{20};
+    uint8_t channel_{0};
+    bool mute_{false};
+    bool power_is_on_{false};
+    bool only_update_ui_{false};
+    int att20db_state_{-1};
+    int cec_reported_volume_{-1};
+    bool pipeline_running_{false};
+    bool cec_report_running_{false};
+    uint32_t cec_frames_{0};
+};
+
+/// The components of dac.yaml on the simulated bus
+class Bench {
+  public:
+    Bench() {
+      host::app.register_component(&queue_);
+      host::app.register_component(&fpga_);
+      host::app.register_component(&dac_l_);
+      host::app.register_component(&dac_r_);
+
+      // as in dac.yaml
+      queue_.set_max_loop_time(2000);
+      queue_.set_bus_frequency(100000);
+      queue_.set_lease_pins(&uinotify_, &uisync_);
+      queue_.set_lease_timeout(50000);
+      queue_.set_change_time(3000);
+      queue_.add_on_peer_change_callback([this]() { ui_.ui_sync(); });
+      fpga_.set_i2c_bus(&bus_);
+      fpga_.set_i2c_address(host::SimFpga::ADDRESS);
+      fpga_.set_queue(&queue_);
+      fpga_.set_update_interval(5000);
+      fpga_.set_fast_interval(50);
+      fpga_.set_settle_time(3000);
+      fpga_.set_dac_status_sensor(&dac_status_);
+      for (auto *dac : {&dac_l_, &dac_r_}) {
+        dac->set_i2c_bus(&bus_);
+        dac->set_queue(&queue_);
+      }
+      dac_l_.set_i2c_address(host::SimBus::DAC_L_ADDRESS);
+      dac_r_.set_i2c_address(host::SimBus::DAC_R_ADDRESS);
+      // a 44.1kHz source on input 0, 96kHz on input 1, none on inputs 2 and 3
+      bus_.fpga.set_input_rates({2, 5, 0, 0});
+    }
+
+    void setup() {
+      host::app.setup();
+      ui_.power_on();  // on boot
+      host::app.run_for_ms(5000);
+      reset_counts();
+    }
+
+    void reset_counts() {
+      queue_.reset_stats();
+      bus_.reset_counts();
+      rpi_.reset_counts();
+      ui_.reset_cec_frames();
+      start_us_ = host::app.now_us();
+    }
+
+    host::SimBus &bus() { return bus_; }
+    host::SimRpi &rpi() { return rpi_; }
+    I2cQueue &queue() { return queue_; }
+    dacxo_fpga::DacxoFpga &fpga() { return fpga_; }
+    pcm1792_i2c::Pcm1792I2C &dac_l() { return dac_l_; }
+    pcm1792_i2c::Pcm1792I2C &dac_r() { return dac_r_; }
+    DacUi &ui() { return ui_; }
+    const text_sensor::TextSensor &dac_status() const { return dac_status_; }
+    uint32_t elapsed_ms() const { return (host::app.now_us() - start_us_) / 1000; }
+
+  protected:
+    host::SimBus bus_{100000};
+    host::SimPin uinotify_{"uinotify (sim)"};
+    host::SimPin uisync_{"uisync (sim)"};
+    host::SimRpi rpi_{&bus_, &uisync_, &uinotify_};
+    I2cQueue queue_;
+    dacxo_fpga::DacxoFpga fpga_;
+    pcm1792_i2c::Pcm1792I2C dac_l_;
+    pcm1792_i2c::Pcm1792I2C dac_r_;
+    text_sensor::TextSensor dac_status_{"DAC Status"};
+    DacUi ui_{&queue_, &fpga_, &dac_l_, &dac_r_};
+    uint64_t start_us_{0};
+};
+
+/// Max transactions of one operation in a scenario, for --check
+struct Budget {
+  Operation op;
+  uint32_t max_transactions;
+};
+
+struct Scenario {
+  const char *name;
+  const char *description;
+  std::function<bool(Bench &bench)> run;  // @return false if the simulated hardware ends in a wrong state
+  std::vector<Budget> budgets;
+};
+
+static const std::vector<Scenario> SCENARIOS = {
+  {"volume_step", "10 single knob steps, 1s apart",
+   [](Bench &b) {
+     for (int i = 0; i < 10; i++) {
+       b.ui().turn_knob(+1);
+       host::app.run_for_ms(1000);
+     }
+     // 30 -> 20dB relay compensated: chip volume 30 + 20
+     return b.bus().dac_l.reg(16) == 2 * (30 + 20) + 127 && b.bus().dac_r.reg(16) == b.bus().dac_l.reg(16);
+   },
+   {{i2c_queue::OP_VOLUME, 20}, {i2c_queue::OP_STATUS, 2}}},
+  {"volume_burst", "a fast knob turn: 30 steps 8ms apart",
+   [](Bench &b) {
+     for (int i = 0; i < 30; i++) {
+       b.ui().turn_knob(+1);
+       host::app.run_for_ms(8);
+     }
+     host::app.run_for_ms(1000);
+     return b.bus().dac_l.reg(16) == 2 * 50 + 127 && b.bus().fpga.gpo1() == 0;  // crossed the relay threshold
+   },
+   {{i2c_queue::OP_VOLUME, 21}, {i2c_queue::OP_STATUS, 1}}},
+  {"input_switch", "switch to the 96kHz input, then to the RPi i2s input",
+   [](Bench &b) {
+     b.ui().select_channel(1);
+     host::app.run_for_ms(5000);
+     const bool locked = b.dac_status().state == "96kHz";
+     b.ui().select_channel(4);
+     host::app.run_for_ms(5000);
+     return locked && b.bus().fpga.gpo0() == 0x81;
+   },
+   {{i2c_queue::OP_INPUT, 2}, {i2c_queue::OP_STATUS, 135}}},
+  {"power_cycle", "power off, and on again after 2s",
+   [](Bench &b) {
+     b.ui().power_off();
+     host::app.run_for_ms(2000);
+     b.ui().power_on();
+     host::app.run_for_ms(5000);
+     return b.bus().fpga.gpo0() == 0x80 && b.bus().dac_r.reg(20) == 0x0c;  // mono, right channel
+   },
+   {{i2c_queue::OP_POWER_OFF, 3}, {i2c_queue::OP_POWER_UP, 6}, {i2c_queue::OP_STATUS, 75}}},
+  {"uisync", "5 volume changes by an ALSA mixer on the RPi, 1s apart",
+   [](Bench &b) {
+     for (int i = 0; i < 5; i++) {
+       b.rpi().set_attenuation(30 + i);
+       host::app.run_for_ms(1000);
+     }
+     return b.ui().get_volume() == 64 - 34 - 20;  // with the 20dB relay, as the volume was low
+   },
+   {{i2c_queue::OP_UISYNC, 10}, {i2c_queue::OP_VOLUME, 0}, {i2c_queue::OP_STATUS, 2}}},
+  {"idle_no_signal", "60s idle on an input without signal",
+   [](Bench &b) {
+     b.ui().select_channel(2);
+     host::app.run_for_ms(5000);
+     b.reset_counts();
+     host::app.run_for_ms(60000);
+     return b.dac_status().state == "No signal";
+   },
+   {{i2c_queue::OP_STATUS, 13}}},
+  {"idle_locked", "60s idle on the 44.1kHz input",
+   [](Bench &b) {
+     b.ui().select_channel(0);
+     host::app.run_for_ms(5000);
+     b.reset_counts();
+     host::app.run_for_ms(60000);
+     return b.dac_status().state == "44kHz";
+   },
+   {{i2c_queue::OP_STATUS, 13}}},
+  {"lease_contention", "a fast knob turn, while the RPi polls its status every 5ms",
+   [](Bench &b) {
+     b.rpi().set_status_polling(5);
+     for (int i = 0; i < 10; i++) {
+       b.ui().turn_knob(-1);
+       host::app.run_for_ms(8);
+     }
+     host::app.run_for_ms(1000);
+     b.rpi().set_status_polling(0);
+     host::app.run_for_ms(100);
+     return b.bus().dac_l.reg(16) == 2 * (10 + 20) + 127;
+   },
+   {{i2c_queue::OP_VOLUME, 8}, {i2c_queue::OP_STATUS, 1}}},
+  {"queue_overflow", "20 distinct reads submitted while the RPi holds a 20ms lease",
+   [](Bench &b) {
+     b.rpi().hold_lease(20000);
+     host::app.run_for_ms(1);
+     // the overflowing submits are dropped, rather than waiting for the lease in the main loop
+     const uint64_t start_us = host::app.now_us();
+     uint32_t queued = 0;
+     for (uint8_t len = 1; len <= 6; len++)
+       queued += b.queue().read(&b.fpga(), dacxo_fpga::REG_GPO0, len, i2c_queue::PRIO_STATUS, nullptr);
+     for (auto *dac : {&b.dac_l(), &b.dac_r()}) {
+       for (uint8_t len = 1; len <= 7; len++)
+         queued += b.queue().read(dac, pcm1792_i2c::REG_FIRST, len, i2c_queue::PRIO_STATUS, nullptr);
+     }
+     const bool no_stall = host::app.now_us() - start_us < 1000;
+     host::app.run_for_ms(1000);
+     return no_stall && queued == i2c_queue::QUEUE_LEN &&
+            b.queue().get_stats(i2c_queue::OP_OTHER).dropped == 20 - i2c_queue::QUEUE_LEN;
+   },
+   {{i2c_queue::OP_OTHER, 16}}},
+  {"overflow_resubmit", "a submit on a full queue, whose synchronously executed transaction resubmits",
+   [](Bench &b) {
+     // fill the queue with distinct reads; the first one, executed on the overflow, submits a follow-up
+     uint32_t followups = 0;
+     auto on_read = [&b, &followups](i2c::ErrorCode err, const uint8_t *, size_t) {
+       b.queue().read(&b.dac_r(), pcm1792_i2c::REG_FIRST, 7, i2c_queue::PRIO_STATUS,
+                      [&followups](i2c::ErrorCode err, const uint8_t *, size_t) { followups++; });
+     };
+     bool ok = b.queue().read(&b.fpga(), dacxo_fpga::REG_GPO0, 1, i2c_queue::PRIO_STATUS, on_read);
+     for (uint8_t len = 2; len <= 6; len++)
+       ok &= b.queue().read(&b.fpga(), dacxo_fpga::REG_GPO0, len, i2c_queue::PRIO_STATUS, nullptr);
+     for (uint8_t len = 1; len <= 7; len++)
+       ok &= b.queue().read(&b.dac_l(), pcm1792_i2c::REG_FIRST, len, i2c_queue::PRIO_STATUS, nullptr);
+     for (uint8_t len = 1; len <= 3; len++)
+       ok &= b.queue().read(&b.dac_r(), pcm1792_i2c::REG_FIRST, len, i2c_queue::PRIO_STATUS, nullptr);
+     // the follow-up takes the slot that the overflow freed: no room is left for this one
+     const bool queued = b.queue().read(&b.dac_r(), pcm1792_i2c::REG_FIRST, 4, i2c_queue::PRIO_STATUS, nullptr);
+     host::app.run_for_ms(100);
+     return ok && !queued && followups == 1 && b.queue().get_stats(i2c_queue::OP_OTHER).dropped == 1;
+   },
+   {{i2c_queue::OP_OTHER, 17}}},
+  {"overlapping_writes", "a volume write between two bursts over the volume and mode registers",
+   [](Bench &b) {
+     // as pcm1792 flush() bursts bridge the registers in between: the last write must win
+     const uint8_t mode = b.bus().dac_l.reg(18);
+     const uint8_t burst1[3] = {0xd0, 0xd0, mode};
+     const uint8_t volume[2] = {0xe0, 0xe0};
+     const uint8_t burst2[3] = {0xf0, 0xf0, mode};
+     bool ok = b.queue().write(&b.dac_l(), pcm1792_i2c::REG_FIRST, burst1, 3, i2c_queue::PRIO_VOLUME);
+     ok &= b.queue().write(&b.dac_l(), pcm1792_i2c::REG_FIRST, volume, 2, i2c_queue::PRIO_VOLUME);
+     ok &= b.queue().write(&b.dac_l(), pcm1792_i2c::REG_FIRST, burst2, 3, i2c_queue::PRIO_VOLUME);
+     host::app.run_for_ms(100);
+     return ok && b.bus().dac_l.reg(16) == 0xf0 && b.bus().dac_l.reg(17) == 0xf0;
+   },
+   {{i2c_queue::OP_OTHER, 2}}},
+};
+
+static bool report(const Scenario &scenario, Bench &bench, bool state_ok, bool check) {
+  const I2cQueue &queue = bench.queue();
+  const host::SimBus::Counts &bus = bench.bus().get_counts();
+  const i2c_queue::LeaseStats lease = queue.get_lease_stats();
+  const host::SimRpi::Counts &rpi = bench.rpi().get_counts();
+  bool ok = state_ok && bus.collisions == 0;
+
+  printf("%s: %s (%.1f s)\n", scenario.name, scenario.description, bench.elapsed_ms() / 1000.0);
+  printf("  %-10s %5s %6s %6s %6s %5s %9s   %s\n", "operation", "count", "trans", "bytes", "coal", "drop",
+         "bus time", "per operation");
+  for (int op = 0; op < i2c_queue::NUM_OPERATIONS; op++) {
+    const i2c_queue::Stats &s = queue.get_stats((Operation) op);
+    uint32_t budget = UINT32_MAX;
+    for (const Budget &b : scenario.budgets) {
+      if (b.op == op)
+        budget = b.max_transactions;
+    }
+    const bool over = s.transactions > budget;
+    ok &= !over;
+    if (s.transactions == 0 && s.coalesced == 0 && s.dropped == 0 && budget == UINT32_MAX)
+      continue;
+    printf("  %-10s %5u %6u %6u %6u %5u %7u us", OPERATION_NAMES[op], s.operations, s.transactions, s.bytes,
+           s.coalesced, s.dropped, s.bus_time_us);
+    if (s.operations > 0) {
+      printf("   %.1f trans, %.1f bytes, %u us", (float) s.transactions / s.operations,
+             (float) s.bytes / s.operations, s.bus_time_us / s.operations);
+    }
+    if (budget != UINT32_MAX)
+      printf("%s   (budget %u)", over ? "  OVER BUDGET" : "", budget);
+    printf("\n");
+  }
+  printf("  bus: %u transactions, %u bytes, %u us, %u nacks, %u collisions; cec: %u frames\n", bus.transactions,
+         bus.bytes, bus.bus_time_us, bus.nacks, bus.collisions, bench.ui().get_cec_frames());
+  printf("  lease: %u acquires, %u contentions, %u collisions, wait max %u us; RPi: %u leases, %u waits, "
+         "wait max %u us\n",
+         lease.acquires, lease.contentions, lease.collisions, lease.max_wait_us, rpi.leases, rpi.contentions,
+         rpi.max_wait_us);
+  if (!state_ok)
+    printf("  FAILED: wrong register state after the scenario\n");
+  if (bus.collisions != 0)
+    printf("  FAILED: bus collisions with the RPi\n");
+  return ok || !check;
+}
+
+static void usage(const char *prog) {
+  fprintf(stderr,
+          "Usage: %s [options] [scenario...]\n"
+          "  -c, --check    exit with an error when a scenario exceeds its transaction budget\n"
+          "  -v, --verbose  log the components, repeat for debug level\n"
+          "  -l, --list     list the scenarios\n",
+          prog);
+}
+
+int main(int argc, char **argv) {
+  static const struct option OPTIONS[] = {{"check", no_argument, nullptr, 'c'},
+                                          {"verbose", no_argument, nullptr, 'v'},
+                                          {"list", no_argument, nullptr, 'l'},
+                                          {"help", no_argument, nullptr, 'h'},
+                                          {nullptr, 0, nullptr, 0}};
+  bool check = false;
+  int log_level = ESPHOME_LOG_LEVEL_ERROR;
+  int opt;
+  while ((opt = getopt_long(argc, argv, "cvlh", OPTIONS, nullptr)) != -1) {
+    switch (opt) {
+      case 'c':
+        check = true;
+        break;
+      case 'v':
+        log_level = (log_level < ESPHOME_LOG_LEVEL_INFO) ? ESPHOME_LOG_LEVEL_INFO : ESPHOME_LOG_LEVEL_DEBUG;
+        break;
+      case 'l':
+        for (const Scenario &s : SCENARIOS)
+          printf("%-19s %s\n", s.name, s.description);
+        return 0;
+      default:
+        usage(argv[0]);
+        return opt == 'h' ? 0 : 2;
+    }
+  }
+  host::set_log_level(log_level);
+
+  int failures = 0;
+  for (const Scenario &scenario : SCENARIOS) {
+    bool selected = optind == argc;
+    for (int i = optind; i < argc; i++)
+      selected |= strcmp(argv[i], scenario.name) == 0;
+    if (!selected)
+      continue;
+    // every scenario starts from a powered-up controller, in a fresh simulation
+    host::app = host::App();
+    Bench bench;
+    bench.setup();
+    const bool state_ok = scenario.run(bench);
+    if (!report(scenario, bench, state_ok, check))
+      failures++;
+  }
+  if (failures)
+    ESP_LOGE(TAG, "%d scenario(s) failed", failures);
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+// Host stand-in for the esphome i2c component: the bus is the simulation in 'sim_bus.h'.
+
+#include <cstddef>
+#include <cstdint>
+
+namespace esphome {
+namespace i2c {
+
+enum ErrorCode {
+  NO_ERROR = 0,
+  ERROR_OK = 0,
+  ERROR_INVALID_ARGUMENT = 1,
+  ERROR_NOT_ACKNOWLEDGED = 2,
+  ERROR_TIMEOUT = 3,
+  ERROR_NOT_INITIALIZED = 4,
+  ERROR_TOO_LARGE = 5,
+  ERROR_UNKNOWN = 6,
+  ERROR_CRC = 7
+};
+
+class I2CBus {
+  public:
+    virtual ~I2CBus() = default;
+    virtual ErrorCode read_register(uint8_t address, uint8_t reg, uint8_t *data, size_t len) = 0;
+    virtual ErrorCode write_register(uint8_t address, uint8_t reg, const uint8_t *data, size_t len) = 0;
+};
+
+class I2CDevice {
+  public:
+    I2CDevice() = default;
+    void set_i2c_address(uint8_t address) { address_ = address; }
+    void set_i2c_bus(I2CBus *bus) { bus_ = bus; }
+
+    ErrorCode read_register(uint8_t a_register, uint8_t *data, size_t len) {
+      return bus_ ? bus_->read_register(address_, a_register, data, len) : ERROR_NOT_INITIALIZED;
+    }
+    ErrorCode write_register(uint8_t a_register, const uint8_t *data, size_t len) {
+      return bus_ ? bus_->write_register(address_, a_register, data, len) : ERROR_NOT_INITIALIZED;
+    }
+
+  protected:
+    uint8_t address_{0x00};
+    I2CBus *bus_{nullptr};
+};
+
+}  // namespace i2c
+}  // namespace esphome
@@ -0,0 +1,30 @@
+#pragma once
+
+// Host stand-in for the esphome text_sensor component: keeps the state, and counts the publishes.
+
+#include <cstdint>
+#include <string>
+#include <utility>
+
+namespace esphome {
+namespace text_sensor {
+
+class TextSensor {
+  public:
+    explicit TextSensor(std::string name = "") : name_(std::move(name)) {}
+    void publish_state(const std::string &state) {
+      this->state = state;
+      num_publishes_++;
+    }
+    const std::string &get_name() const { return name_; }
+    uint32_t get_num_publishes() const { return num_publishes_; }
+
+    std::string state;
+
+  protected:
+    std::string name_;
+    uint32_t num_publishes_{0};
+};
+
+}  // namespace text_sensor
+}  // namespace esphome
@@ -0,0 +1,13 @@
+#pragma once
+
+// Host stand-in for the esphome header of the same name: triggers without automations attached.
+
+namespace esphome {
+
+template<typename... Ts> class Trigger {
+  public:
+    virtual ~Trigger() = default;
+    void trigger(Ts... x) {}
+};
+
+}  // namespace esphome
@@ -0,0 +1,64 @@
+#pragma once
+
+// Host stand-in for the esphome header of the same name: the parts that the dacxo components use.
+// The simulated main loop and scheduler are in 'esphome_host.cpp'.
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
+namespace esphome {
+
+namespace setup_priority {
+static const float BUS = 1000.0f;
+static const float DATA = 600.0f;
+}  // namespace setup_priority
+
+class Component {
+  public:
+    virtual ~Component() = default;
+    virtual void setup() {}
+    virtual void loop() {}
+    virtual void dump_config() {}
+    virtual float get_setup_priority() const { return 0.0f; }
+    /// As esphome: setup() of a PollingComponent also starts its poller
+    virtual void call_setup() { setup(); }
+
+  protected:
+    void set_timeout(const std::string &name, uint32_t timeout_ms, std::function<void()> &&f);
+    void set_interval(const std::string &name, uint32_t interval_ms, std::function<void()> &&f);
+    bool cancel_timeout(const std::string &name);
+    bool cancel_interval(const std::string &name) { return cancel_timeout(name); }
+};
+
+class PollingComponent : public Component {
+  public:
+    PollingComponent() = default;
+    explicit PollingComponent(uint32_t update_interval) : update_interval_(update_interval) {}
+    virtual void update() = 0;
+    void call_setup() override {
+      setup();
+      start_poller();
+    }
+    virtual void set_update_interval(uint32_t update_interval) { update_interval_ = update_interval; }
+    virtual uint32_t get_update_interval() const { return update_interval_; }
+    void start_poller();
+    void stop_poller();
+
+  protected:
+    uint32_t update_interval_{1000};
+};
+
+/// While started, the main loop runs without its idle delay
+class HighFrequencyLoopRequester {
+  public:
+    ~HighFrequencyLoopRequester() { stop(); }
+    void start();
+    void stop();
+    static bool is_high_frequency();
+
+  protected:
+    bool started_{false};
+};
+
+}  // namespace esphome
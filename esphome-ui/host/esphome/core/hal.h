@@ -0,0 +1,59 @@
+#pragma once
+
+// Host stand-in for the esphome header of the same name: the parts that the dacxo components use.
+// Time is simulated, see 'esphome_host.h'.
+
+#include <cstdint>
+#include <string>
+
+#define IRAM_ATTR
+
+namespace esphome {
+
+uint32_t micros();
+uint32_t millis();
+/// Advances the simulated time, running the simulated hardware (such as the RPi) meanwhile
+void delayMicroseconds(uint32_t us);
+
+namespace gpio {
+enum InterruptType : uint8_t {
+  INTERRUPT_RISING_EDGE = 1,
+  INTERRUPT_FALLING_EDGE = 2,
+  INTERRUPT_ANY_EDGE = 3
+};
+}  // namespace gpio
+
+class InternalGPIOPin;
+
+/// Pin access from an interrupt handler
+class ISRInternalGPIOPin {
+  public:
+    ISRInternalGPIOPin() = default;
+    explicit ISRInternalGPIOPin(InternalGPIOPin *pin) : pin_(pin) {}
+    bool digital_read();
+
+  protected:
+    InternalGPIOPin *pin_{nullptr};
+};
+
+/// Logical pin level, with the 'inverted' option of the yaml pin schema already applied
+class InternalGPIOPin {
+  public:
+    virtual ~InternalGPIOPin() = default;
+    virtual void setup() {}
+    virtual bool digital_read() = 0;
+    virtual void digital_write(bool value) = 0;
+    virtual std::string dump_summary() const = 0;
+    ISRInternalGPIOPin to_isr() { return ISRInternalGPIOPin(this); }
+
+    template<typename T> void attach_interrupt(void (*func)(T *), T *arg, gpio::InterruptType type) {
+      attach_interrupt_(reinterpret_cast<void (*)(void *)>(func), arg, type);
+    }
+
+  protected:
+    virtual void attach_interrupt_(void (*func)(void *), void *arg, gpio::InterruptType type) = 0;
+};
+
+inline bool ISRInternalGPIOPin::digital_read() { return pin_->digital_read(); }
+
+}  // namespace esphome
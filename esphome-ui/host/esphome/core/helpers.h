@@ -0,0 +1,26 @@
+#pragma once
+
+// Host stand-in for the esphome header of the same name: the parts that the dacxo components use.
+
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace esphome {
+
+template<typename... X> class CallbackManager;
+
+template<typename... Ts> class CallbackManager<void(Ts...)> {
+  public:
+    void add(std::function<void(Ts...)> &&callback) { callbacks_.push_back(std::move(callback)); }
+    void call(Ts... args) {
+      for (auto &cb : callbacks_)
+        cb(args...);
+    }
+    size_t size() const { return callbacks_.size(); }
+
+  protected:
+    std::vector<std::function<void(Ts...)>> callbacks_;
+};
+
+}  // namespace esphome
@@ -0,0 +1,45 @@
+#pragma once
+
+// Host stand-in for the esphome header of the same name: log lines go to stderr,
+// up to the level set with host::set_log_level().
+
+#include <cinttypes>
+#include <cstdio>
+
+namespace esphome {
+
+enum LogLevel : uint8_t {
+  ESPHOME_LOG_LEVEL_NONE = 0,
+  ESPHOME_LOG_LEVEL_ERROR = 1,
+  ESPHOME_LOG_LEVEL_WARN = 2,
+  ESPHOME_LOG_LEVEL_INFO = 3,
+  ESPHOME_LOG_LEVEL_CONFIG = 4,
+  ESPHOME_LOG_LEVEL_DEBUG = 5,
+  ESPHOME_LOG_LEVEL_VERBOSE = 6
+};
+
+void esp_log_printf_(int level, const char *tag, int line, const char *format, ...)
+    __attribute__((format(printf, 4, 5)));
+
+}  // namespace esphome
+
+#define ESP_LOGE(tag, ...) ::esphome::esp_log_printf_(::esphome::ESPHOME_LOG_LEVEL_ERROR, tag, __LINE__, __VA_ARGS__)
+#define ESP_LOGW(tag, ...) ::esphome::esp_log_printf_(::esphome::ESPHOME_LOG_LEVEL_WARN, tag, __LINE__, __VA_ARGS__)
+#define ESP_LOGI(tag, ...) ::esphome::esp_log_printf_(::esphome::ESPHOME_LOG_LEVEL_INFO, tag, __LINE__, __VA_ARGS__)
+#define ESP_LOGCONFIG(tag, ...) \
+  ::esphome::esp_log_printf_(::esphome::ESPHOME_LOG_LEVEL_CONFIG, tag, __LINE__, __VA_ARGS__)
+#define ESP_LOGD(tag, ...) ::esphome::esp_log_printf_(::esphome::ESPHOME_LOG_LEVEL_DEBUG, tag, __LINE__, __VA_ARGS__)
+#define ESP_LOGV(tag, ...) \
+  ::esphome::esp_log_printf_(::esphome::ESPHOME_LOG_LEVEL_VERBOSE, tag, __LINE__, __VA_ARGS__)
+
+#define LOG_PIN(prefix, pin) \
+  if ((pin) != nullptr) { \
+    ESP_LOGCONFIG(TAG, prefix "%s", (pin)->dump_summary().c_str()); \
+  }
+
+#define LOG_I2C_DEVICE(this) ESP_LOGCONFIG(TAG, "  Address: 0x%02X", this->address_);
+
+#define LOG_TEXT_SENSOR(prefix, type, obj) \
+  if ((obj) != nullptr) { \
+    ESP_LOGCONFIG(TAG, "%s%s '%s'", prefix, type, (obj)->get_name().c_str()); \
+  }
@@ -0,0 +1,154 @@
+#include "esphome_host.h"
+#include "esphome/core/hal.h"
+#include "esphome/core/log.h"
+#include <algorithm>
+#include <cstdarg>
+#include <cstdio>
+
+namespace esphome {
+namespace host {
+
+App app;  // NOLINT
+
+static int log_level = ESPHOME_LOG_LEVEL_WARN;
+
+void set_log_level(int level) { log_level = level; }
+
+void App::setup() {
+  std::stable_sort(components_.begin(), components_.end(), [](Component *a, Component *b) {
+    return a->get_setup_priority() > b->get_setup_priority();
+  });
+  for (Component *c : components_)
+    c->call_setup();
+}
+
+void App::run_for_ms(uint32_t duration_ms) {
+  const uint64_t end_us = now_us_ + (uint64_t) duration_ms * 1000;
+  while (now_us_ < end_us)
+    loop_once_(end_us);
+}
+
+void App::loop_once_(uint64_t end_us) {
+  while (run_next_timer_(now_us_, false)) {
+  }
+  for (Component *c : components_)
+    c->loop();
+  loop_iterations_++;
+  advance_us(LOOP_OTHER_US);
+  if (is_high_frequency())
+    return;
+
+  // sleep until the next timer, at most the loop interval
+  uint64_t wake_us = std::min(now_us_ + LOOP_INTERVAL_US, end_us);
+  for (const Timer &t : timers_) {
+    if (!t.external)
+      wake_us = std::min(wake_us, t.due_us);
+  }
+  if (wake_us > now_us_)
+    advance_us(wake_us - now_us_);
+}
+
+void App::advance_us(uint32_t us) {
+  const uint64_t end_us = now_us_ + us;
+  while (run_next_timer_(end_us, true)) {
+  }
+  now_us_ = std::max(now_us_, end_us);
+}
+
+bool App::run_next_timer_(uint64_t until_us, bool external_only) {
+  auto next = timers_.end();
+  for (auto it = timers_.begin(); it != timers_.end(); ++it) {
+    if (it->due_us > until_us || (external_only && !it->external))
+      continue;
+    if (next == timers_.end() || it->due_us < next->due_us || (it->due_us == next->due_us && it->seq < next->seq))
+      next = it;
+  }
+  if (next == timers_.end())
+    return false;
+
+  now_us_ = std::max(now_us_, next->due_us);
+  std::function<void()> f = next->f;  // the callback might (re-)schedule or cancel timers
+  if (next->interval_us) {
+    next->due_us += next->interval_us;
+    next->seq = next_seq_++;
+  } else {
+    timers_.erase(next);
+  }
+  f();
+  return true;
+}
+
+void App::set_timeout(const void *owner, const std::string &name, uint32_t delay_us, std::function<void()> &&f,
+                      bool external) {
+  cancel(owner, name);
+  timers_.push_back(Timer{owner, name, now_us_ + delay_us, 0, external, next_seq_++, std::move(f)});
+}
+
+void App::set_interval(const void *owner, const std::string &name, uint32_t interval_us,
+                       std::function<void()> &&f) {
+  cancel(owner, name);
+  timers_.push_back(Timer{owner, name, now_us_ + interval_us, interval_us, false, next_seq_++, std::move(f)});
+}
+
+bool App::cancel(const void *owner, const std::string &name) {
+  auto it = std::find_if(timers_.begin(), timers_.end(),
+                         [owner, &name](const Timer &t) { return t.owner == owner && t.name == name; });
+  if (it == timers_.end())
+    return false;
+  timers_.erase(it);
+  return true;
+}
+
+}  // namespace host
+
+// *** esphome core functions, on the simulated time ***
+
+uint32_t micros() { return (uint32_t) host::app.now_us(); }
+uint32_t millis() { return (uint32_t) (host::app.now_us() / 1000); }
+void delayMicroseconds(uint32_t us) { host::app.advance_us(us); }
+
+void esp_log_printf_(int level, const char *tag, int line, const char *format, ...) {
+  if (level > host::log_level)
+    return;
+  static const char *const LEVEL_LETTERS = "-EWICDV";
+  std::fprintf(stderr, "[%10.3f][%c][%s:%d]: ", host::app.now_us() / 1000.0, LEVEL_LETTERS[level], tag, line);
+  va_list args;
+  va_start(args, format);
+  std::vfprintf(stderr, format, args);
+  va_end(args);
+  std::fputc('\n', stderr);
+}
+
+void Component::set_timeout(const std::string &name, uint32_t timeout_ms, std::function<void()> &&f) {
+  host::app.set_timeout(this, name, timeout_ms * 1000, std::move(f));
+}
+
+void Component::set_interval(const std::string &name, uint32_t interval_ms, std::function<void()> &&f) {
+  host::app.set_interval(this, name, interval_ms * 1000, std::move(f));
+}
+
+bool Component::cancel_timeout(const std::string &name) { return host::app.cancel(this, name); }
+
+void PollingComponent::start_poller() {
+  set_interval("update", get_update_interval(), [this]() { update(); });
+}
+
+void PollingComponent::stop_poller() { cancel_interval("update"); }
+
+void HighFrequencyLoopRequester::start() {
+  if (started_)
+    return;
+  started_ = true;
+  host::app.set_high_frequency(+1);
+}
+
+void HighFrequencyLoopRequester::stop() {
+  if (!started_)
+    return;
+  started_ = false;
+  host::app.set_high_frequency(-1);
+}
+
+bool HighFrequencyLoopRequester::is_high_frequency() { return host::app.is_high_frequency(); }
+
+}  // namespace esphome
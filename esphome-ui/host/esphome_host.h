@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include "esphome/core/component.h"
+
+namespace esphome {
+namespace host {
+
+/**
+ * The esphome main loop on the host, in simulated time. Components run their loop() once per
+ * iteration. Without a HighFrequencyLoopRequester, the loop sleeps up to 'loop_interval' until
+ * the next timer, as esphome does.
+ *
+ * Simulated hardware, such as the RPi on the other end of the i2c bus, uses 'external' timers:
+ * these also run while a component waits, in delayMicroseconds() or in an i2c transfer.
+ */
+class App {
+  public:
+    /// Time spent per loop iteration in the other components, such as the display and cec
+    static const uint32_t LOOP_OTHER_US = 200;
+    /// esphome 'loop_interval'
+    static const uint32_t LOOP_INTERVAL_US = 16000;
+
+    void register_component(Component *component) { components_.push_back(component); }
+    /// Call the setup of the registered components, in order of their setup priority
+    void setup();
+    void run_for_ms(uint32_t duration_ms);
+
+    uint64_t now_us() const { return now_us_; }
+    /// Time passing inside a component, which runs the external timers on their due time
+    void advance_us(uint32_t us);
+
+    void set_timeout(const void *owner, const std::string &name, uint32_t delay_us, std::function<void()> &&f,
+                     bool external = false);
+    void set_interval(const void *owner, const std::string &name, uint32_t interval_us, std::function<void()> &&f);
+    bool cancel(const void *owner, const std::string &name);
+
+    void set_high_frequency(int delta) { high_frequency_ += delta; }
+    bool is_high_frequency() const { return high_frequency_ > 0; }
+    uint32_t get_loop_iterations() const { return loop_iterations_; }
+
+  protected:
+    struct Timer {
+      const void *owner;
+      std::string name;
+      uint64_t due_us;
+      uint32_t interval_us;  // 0 for a timeout
+      bool external;
+      uint64_t seq;          // order of timers with the same due time
+      std::function<void()> f;
+    };
+
+    /// Run the first due timer, if any: only the external ones if 'external_only'. @return false if none
+    bool run_next_timer_(uint64_t until_us, bool external_only);
+    /// One main loop iteration, with its idle sleep ending at 'end_us' at the latest
+    void loop_once_(uint64_t end_us);
+
+    std::vector<Component *> components_;
+    std::vector<Timer> timers_;
+    uint64_t now_us_{0};
+    uint64_t next_seq_{0};
+    int high_frequency_{0};
+    uint32_t loop_iterations_{0};
+};
+
+extern App app;  // NOLINT
+
+void set_log_level(int level);
+
+}  // namespace host
+}  // namespace esphome
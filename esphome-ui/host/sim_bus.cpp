@@ -0,0 +1,269 @@
+#include "sim_bus.h"
+#include "esphome_host.h"
+#include <algorithm>
+
+namespace esphome {
+namespace host {
+
+// Register bits, as in 'codecs/dacxo.h' of the RPi driver
+static const uint8_t REG_GPO0 = 0x30;
+static const uint8_t REG_GPO1 = 0x31;
+static const uint8_t REG_GPI0 = 0x34;
+static const uint8_t REG_GPI1 = 0x35;
+static const uint8_t GPO0_CLKMASTER = 0x01;
+static const uint8_t GPO0_SLVINPUT = 0x0c;
+static const uint8_t GPO0_POWERUP = 0x80;
+static const uint8_t GPO0_SELECT = GPO0_POWERUP | GPO0_SLVINPUT | GPO0_CLKMASTER;
+static const uint8_t GPI0_LOCK = 0x01;
+static const uint8_t GPI0_ADJ_HI = 0x10;
+static const uint8_t GPI0_FULLISH = 0x80;
+static const uint8_t GPI1_ANAPWR = 0x01;
+
+// i2c bits per transfer, as in the i2c_queue: start, address, register, stop, and for a read
+// a repeated start with the address again. Each byte takes 9 clocks including its ack.
+static const uint32_t WRITE_OVERHEAD_BITS = 1 + 9 + 9 + 1;
+static const uint32_t READ_OVERHEAD_BITS = WRITE_OVERHEAD_BITS + 1 + 9;
+
+// pcm1792 register content after reset, regs 16..23
+static const std::array<uint8_t, SimPcm1792::NUM_REGS> PCM1792_RESET_REGS =
+    {0xff, 0xff, 0x50, 0x00, 0x00, 0x01, 0x00, 0x00};
+
+void SimPin::set_level(bool level) {
+  if (level == level_)
+    return;
+  level_ = level;
+  if (isr_ == nullptr)
+    return;
+  if (isr_type_ == gpio::INTERRUPT_ANY_EDGE || (level && isr_type_ == gpio::INTERRUPT_RISING_EDGE) ||
+      (!level && isr_type_ == gpio::INTERRUPT_FALLING_EDGE))
+    isr_(isr_arg_);
+}
+
+void SimPin::attach_interrupt_(void (*func)(void *), void *arg, gpio::InterruptType type) {
+  isr_ = func;
+  isr_arg_ = arg;
+  isr_type_ = type;
+}
+
+// *** SimFpga ***
+
+bool SimFpga::is_analog_powered() const {
+  return (gpo0_ & GPO0_POWERUP) && app.now_us() - power_on_us_ >= ANAPWR_TIME_US;
+}
+
+uint8_t SimFpga::gpi0_() const {
+  if (!(gpo0_ & GPO0_POWERUP) || (gpo0_ & GPO0_CLKMASTER))
+    return 0;  // the i2s input of the RPi needs no receiver
+  const uint8_t rate = input_rates_[(gpo0_ & GPO0_SLVINPUT) >> 2];
+  const uint64_t locked_us = app.now_us() - select_us_;
+  if (rate == 0 || locked_us < LOCK_TIME_US)
+    return 0;  // no signal, or hunting for lock
+  uint8_t gpi0 = GPI0_LOCK | (rate << 1);
+  if (locked_us < LOCK_TIME_US + STEER_TIME_US)
+    gpi0 |= GPI0_ADJ_HI | GPI0_FULLISH;  // the output clock steers to center the fifo
+  return gpi0;
+}
+
+ErrorCode SimFpga::read(uint8_t reg, uint8_t *data, size_t len) {
+  if (reg < REG_GPO0 || reg + len - 1 > REG_GPI1)
+    return i2c::ERROR_NOT_ACKNOWLEDGED;
+  for (size_t i = 0; i < len; i++) {
+    switch (reg + i) {
+      case REG_GPO0:
+        data[i] = gpo0_;
+        break;
+      case REG_GPO1:
+        data[i] = gpo1_;
+        break;
+      case REG_GPI0:
+        data[i] = gpi0_();
+        break;
+      case REG_GPI1:
+        data[i] = is_analog_powered() ? GPI1_ANAPWR : 0;
+        break;
+      default:
+        data[i] = 0;  // unused
+    }
+  }
+  return i2c::ERROR_OK;
+}
+
+ErrorCode SimFpga::write(uint8_t reg, const uint8_t *data, size_t len) {
+  if (reg < REG_GPO0 || reg + len - 1 > REG_GPI1)
+    return i2c::ERROR_NOT_ACKNOWLEDGED;
+  for (size_t i = 0; i < len; i++) {
+    if (reg + i == REG_GPO0) {
+      const uint8_t changed = gpo0_ ^ data[i];
+      if (changed & GPO0_SELECT)
+        select_us_ = app.now_us();
+      if ((changed & GPO0_POWERUP) && (data[i] & GPO0_POWERUP))
+        power_on_us_ = app.now_us();
+      gpo0_ = data[i];
+    } else if (reg + i == REG_GPO1) {
+      gpo1_ = data[i];
+    }  // the GPI registers are read-only
+  }
+  return i2c::ERROR_OK;
+}
+
+// *** SimPcm1792 ***
+
+void SimPcm1792::reset_() { regs_ = PCM1792_RESET_REGS; }
+
+bool SimPcm1792::check_power_() {
+  const bool powered = fpga_->is_analog_powered();
+  if (powered_ && !powered)
+    reset_();
+  powered_ = powered;
+  return powered;
+}
+
+ErrorCode SimPcm1792::read(uint8_t reg, uint8_t *data, size_t len) {
+  if (!check_power_() || reg < FIRST_REG || reg + len > FIRST_REG + NUM_REGS)
+    return i2c::ERROR_NOT_ACKNOWLEDGED;
+  std::copy_n(&regs_[reg - FIRST_REG], len, data);
+  return i2c::ERROR_OK;
+}
+
+ErrorCode SimPcm1792::write(uint8_t reg, const uint8_t *data, size_t len) {
+  if (!check_power_() || reg < FIRST_REG || reg + len > FIRST_REG + NUM_REGS)
+    return i2c::ERROR_NOT_ACKNOWLEDGED;
+  for (size_t i = 0; i < len; i++) {
+    if (reg + i < 22)  // regs 22 and 23 are read-only
+      regs_[reg - FIRST_REG + i] = data[i];
+  }
+  return i2c::ERROR_OK;
+}
+
+// *** SimBus ***
+
+uint32_t SimBus::bus_time_us(bool is_read, size_t len) const {
+  const uint32_t bits = (is_read ? READ_OVERHEAD_BITS : WRITE_OVERHEAD_BITS) + 9 * len;
+  return (uint64_t) bits * 1000000 / frequency_;
+}
+
+ErrorCode SimBus::read_register(uint8_t address, uint8_t reg, uint8_t *data, size_t len) {
+  return transfer_(address, reg, data, len, true);
+}
+
+ErrorCode SimBus::write_register(uint8_t address, uint8_t reg, const uint8_t *data, size_t len) {
+  return transfer_(address, reg, const_cast<uint8_t *>(data), len, false);
+}
+
+ErrorCode SimBus::rpi_transfer(uint8_t address, uint8_t reg, uint8_t *data, size_t len, bool is_read) {
+  ErrorCode err;
+  if (address == SimFpga::ADDRESS)
+    err = is_read ? fpga.read(reg, data, len) : fpga.write(reg, data, len);
+  else if (address == DAC_L_ADDRESS)
+    err = is_read ? dac_l.read(reg, data, len) : dac_l.write(reg, data, len);
+  else if (address == DAC_R_ADDRESS)
+    err = is_read ? dac_r.read(reg, data, len) : dac_r.write(reg, data, len);
+  else
+    err = i2c::ERROR_NOT_ACKNOWLEDGED;
+  app.advance_us(bus_time_us(is_read, len));
+  return err;
+}
+
+ErrorCode SimBus::transfer_(uint8_t address, uint8_t reg, uint8_t *data, size_t len, bool is_read) {
+  const uint32_t bus_time = bus_time_us(is_read, len);
+  counts_.transactions++;
+  counts_.bytes += len;
+  counts_.bus_time_us += bus_time;
+
+  // the RPi may also take the bus while this transfer is in progress
+  const uint32_t rpi_claims = rpi_claims_;
+  const bool rpi_was_active = rpi_active_;
+  app.advance_us(DRIVER_OVERHEAD_US + bus_time);
+  if (rpi_was_active || rpi_claims != rpi_claims_) {
+    counts_.collisions++;
+    return i2c::ERROR_UNKNOWN;  // lost the arbitration
+  }
+
+  ErrorCode err;
+  if (address == SimFpga::ADDRESS)
+    err = is_read ? fpga.read(reg, data, len) : fpga.write(reg, data, len);
+  else if (address == DAC_L_ADDRESS)
+    err = is_read ? dac_l.read(reg, data, len) : dac_l.write(reg, data, len);
+  else if (address == DAC_R_ADDRESS)
+    err = is_read ? dac_r.read(reg, data, len) : dac_r.write(reg, data, len);
+  else
+    err = i2c::ERROR_NOT_ACKNOWLEDGED;
+  if (err == i2c::ERROR_NOT_ACKNOWLEDGED)
+    counts_.nacks++;
+  return err;
+}
+
+// *** SimRpi ***
+
+void SimRpi::set_attenuation(uint8_t att_db) {
+  request_({true, 0, [this, att_db]() {
+    uint8_t vol[2];
+    vol[0] = vol[1] = 255 - 2 * std::min<uint8_t>(att_db, 127);
+    bus_->rpi_transfer(SimBus::DAC_L_ADDRESS, 16, vol, 2, false);
+    bus_->rpi_transfer(SimBus::DAC_R_ADDRESS, 16, vol, 2, false);
+  }});
+}
+
+void SimRpi::set_status_polling(uint32_t interval_ms) {
+  if (interval_ms == 0) {
+    app.cancel(this, "status");
+    return;
+  }
+  app.set_timeout(this, "status", interval_ms * 1000, [this, interval_ms]() {
+    request_({false, 0, [this]() {
+      uint8_t gpi[2];
+      bus_->rpi_transfer(SimFpga::ADDRESS, REG_GPI0, gpi, 2, true);
+    }});
+    set_status_polling(interval_ms);
+  }, true);
+}
+
+void SimRpi::hold_lease(uint32_t hold_us) { request_({true, hold_us, nullptr}); }
+
+void SimRpi::request_(Request &&request) {
+  requests_.push_back(std::move(request));
+  if (requests_.size() == 1)
+    claim_();
+}
+
+void SimRpi::claim_() {
+  claim_us_ = app.now_us();
+  uisync_->set_level(true);
+  app.set_timeout(this, "lease", LEASE_SETTLE_US, [this]() { check_peer_(); }, true);
+}
+
+void SimRpi::check_peer_() {
+  const uint32_t wait_us = app.now_us() - claim_us_ - LEASE_SETTLE_US;
+  if (uinotify_->digital_read()) {
+    if (wait_us < LEASE_TIMEOUT_US) {
+      app.set_timeout(this, "lease", LEASE_POLL_US, [this]() { check_peer_(); }, true);
+      return;
+    }
+    counts_.timeouts++;
+  }
+  if (wait_us > 0) {
+    counts_.contentions++;
+    counts_.max_wait_us = std::max(counts_.max_wait_us, wait_us);
+  }
+
+  lease_start_us_ = app.now_us();
+  bus_->set_rpi_active(true);
+  const Request &request = requests_.front();
+  if (request.action)
+    request.action();
+  const uint32_t hold_us = std::max(request.hold_us, request.changes ? LEASE_CHANGE_US : 0);
+  const uint32_t held_us = app.now_us() - lease_start_us_;
+  app.set_timeout(this, "lease", hold_us > held_us ? hold_us - held_us : 0, [this]() { release_(); }, true);
+}
+
+void SimRpi::release_() {
+  bus_->set_rpi_active(false);
+  uisync_->set_level(false);
+  counts_.leases++;
+  requests_.pop_front();
+  if (!requests_.empty())
+    claim_();
+}
+
+}  // namespace host
+}  // namespace esphome
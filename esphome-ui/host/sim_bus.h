@@ -0,0 +1,194 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <string>
+#include "esphome/core/hal.h"
+#include "esphome/components/i2c/i2c.h"
+
+namespace esphome {
+namespace host {
+
+using i2c::ErrorCode;
+
+/// A gpio line between the UI controller and the RPi, as the logical level of the (inverted) pin
+class SimPin : public InternalGPIOPin {
+  public:
+    explicit SimPin(const char *name) : name_(name) {}
+    bool digital_read() override { return level_; }
+    void digital_write(bool value) override { set_level(value); }
+    std::string dump_summary() const override { return name_; }
+    /// Drive the line from the simulated side, calling the interrupt handler on an edge
+    void set_level(bool level);
+
+  protected:
+    void attach_interrupt_(void (*func)(void *), void *arg, gpio::InterruptType type) override;
+
+    std::string name_;
+    bool level_{false};
+    void (*isr_)(void *){nullptr};
+    void *isr_arg_{nullptr};
+    gpio::InterruptType isr_type_{gpio::INTERRUPT_ANY_EDGE};
+};
+
+/**
+ * The dac board FPGA at i2c address 0x10, with the register semantics of 'codecs/dacxo.h' in the RPi driver:
+ * GPO0 (0x30) power and input select, GPO1 (0x31) attenuation relay, read-only GPI0 (0x34) receiver status
+ * and GPI1 (0x35) analog power. Registers auto-increment over 0x30..0x35.
+ */
+class SimFpga {
+  public:
+    static const uint8_t ADDRESS = 0x10;
+    static const uint32_t LOCK_TIME_US = 150000;    // s/pdif receiver lock after an input switch
+    static const uint32_t STEER_TIME_US = 400000;   // clock steering after lock, until the fifo centered
+    static const uint32_t ANAPWR_TIME_US = 100000;  // Vana measured 'on' after the power relay
+
+    /// @param rates GPI0 rate index (2: 44.1kHz .. 7: 192kHz) of the signal on each s/pdif input, 0 without
+    void set_input_rates(const std::array<uint8_t, 4> &rates) { input_rates_ = rates; }
+    ErrorCode read(uint8_t reg, uint8_t *data, size_t len);
+    ErrorCode write(uint8_t reg, const uint8_t *data, size_t len);
+    bool is_analog_powered() const;
+    uint8_t gpo0() const { return gpo0_; }
+    uint8_t gpo1() const { return gpo1_; }
+
+  protected:
+    uint8_t gpi0_() const;
+
+    uint8_t gpo0_{0};
+    uint8_t gpo1_{0};
+    uint64_t select_us_{0};    // time of the last power or input change
+    uint64_t power_on_us_{0};
+    std::array<uint8_t, 4> input_rates_{};
+};
+
+/**
+ * A pcm1792 dac chip at 0x4c or 0x4d: registers 16..23 with auto-increment, of which 22 and 23 are read-only.
+ * It does not acknowledge, and loses its register content, without analog power.
+ */
+class SimPcm1792 {
+  public:
+    static const uint8_t FIRST_REG = 16;
+    static const uint8_t NUM_REGS = 8;
+
+    SimPcm1792(uint8_t address, const SimFpga *fpga) : address_(address), fpga_(fpga) { reset_(); }
+    uint8_t address() const { return address_; }
+    ErrorCode read(uint8_t reg, uint8_t *data, size_t len);
+    ErrorCode write(uint8_t reg, const uint8_t *data, size_t len);
+    uint8_t reg(uint8_t reg) const { return regs_[reg - FIRST_REG]; }
+
+  protected:
+    bool check_power_();
+    void reset_();
+
+    uint8_t address_;
+    const SimFpga *fpga_;
+    bool powered_{false};
+    std::array<uint8_t, NUM_REGS> regs_{};
+};
+
+/**
+ * The i2c bus of the dac board, with the FPGA and the two pcm1792 chips.
+ * Each transfer of the UI controller takes its modeled bus time plus the i2c driver overhead
+ * in simulated time, and is counted. A transfer while the RPi holds the bus collides: it fails
+ * as the arbitration gets lost.
+ */
+class SimBus : public i2c::I2CBus {
+  public:
+    static const uint8_t DAC_L_ADDRESS = 0x4c;
+    static const uint8_t DAC_R_ADDRESS = 0x4d;
+    static const uint32_t DRIVER_OVERHEAD_US = 50;  // i2c driver setup per transfer on the esp32
+
+    struct Counts {
+      uint32_t transactions{0};
+      uint32_t bytes{0};
+      uint32_t bus_time_us{0};
+      uint32_t nacks{0};
+      uint32_t collisions{0};  // transfers while the RPi held the bus
+    };
+
+    explicit SimBus(uint32_t frequency) : frequency_(frequency) {}
+    void set_frequency(uint32_t frequency) { frequency_ = frequency; }
+    ErrorCode read_register(uint8_t address, uint8_t reg, uint8_t *data, size_t len) override;
+    ErrorCode write_register(uint8_t address, uint8_t reg, const uint8_t *data, size_t len) override;
+
+    /// Register access by the RPi, the other bus master: not counted as the traffic of the UI controller
+    ErrorCode rpi_transfer(uint8_t address, uint8_t reg, uint8_t *data, size_t len, bool is_read);
+    void set_rpi_active(bool active) {
+      rpi_active_ = active;
+      rpi_claims_ += active;
+    }
+
+    /// @return Modeled time on the bus, with the same bit counts as the i2c_queue
+    uint32_t bus_time_us(bool is_read, size_t len) const;
+    const Counts &get_counts() const { return counts_; }
+    void reset_counts() { counts_ = Counts(); }
+
+    SimFpga fpga;
+    SimPcm1792 dac_l{DAC_L_ADDRESS, &fpga};
+    SimPcm1792 dac_r{DAC_R_ADDRESS, &fpga};
+
+  protected:
+    ErrorCode transfer_(uint8_t address, uint8_t reg, uint8_t *data, size_t len, bool is_read);
+
+    uint32_t frequency_;
+    bool rpi_active_{false};
+    uint32_t rpi_claims_{0};  // to detect the RPi taking the bus during a transfer
+    Counts counts_;
+};
+
+/**
+ * The RPi driver as the other bus master, with its side of the bus lease as in 'codecs/dacxo.h':
+ * it pulls 'uisync', waits while the UI controller holds 'uinotify', and holds a lease with
+ * register changes for at least the change time.
+ */
+class SimRpi {
+  public:
+    static const uint32_t LEASE_SETTLE_US = 5;
+    static const uint32_t LEASE_POLL_US = 100;
+    static const uint32_t LEASE_TIMEOUT_US = 50000;
+    static const uint32_t LEASE_CHANGE_US = 3000;
+
+    struct Counts {
+      uint32_t leases{0};
+      uint32_t contentions{0};  // leases that waited for the UI controller
+      uint32_t max_wait_us{0};
+      uint32_t timeouts{0};
+    };
+
+    SimRpi(SimBus *bus, SimPin *uisync, SimPin *uinotify) : bus_(bus), uisync_(uisync), uinotify_(uinotify) {}
+
+    /// Write the volume of both dac chips as an ALSA mixer app does, in dB attenuation
+    void set_attenuation(uint8_t att_db);
+    /// A lease for the status reads of the driver every 'interval_ms', 0 to stop
+    void set_status_polling(uint32_t interval_ms);
+    /// Hold a lease with changes for 'hold_us', without bus traffic, such as during a power-up
+    void hold_lease(uint32_t hold_us);
+    bool is_idle() const { return requests_.empty(); }
+    const Counts &get_counts() const { return counts_; }
+    void reset_counts() { counts_ = Counts(); }
+
+  protected:
+    struct Request {
+      bool changes;
+      uint32_t hold_us;               // min hold time, besides the change time
+      std::function<void()> action;   // the bus transfers, during the lease
+    };
+
+    void request_(Request &&request);
+    void claim_();
+    void check_peer_();
+    void release_();
+
+    SimBus *bus_;
+    SimPin *uisync_;
+    SimPin *uinotify_;
+    std::deque<Request> requests_;  // the front one is in progress
+    uint64_t claim_us_{0};
+    uint64_t lease_start_us_{0};
+    Counts counts_;
+};
+
+}  // namespace host
+}  // namespace esphome